@@ -5,7 +5,12 @@ layout (location = 4) in vec3 binormal;
 
 uniform mat4 vertex_model_to_world;
 uniform mat4 normal_model_to_world;
-uniform mat4 vertex_world_to_clip;
+
+layout (std140) uniform FrameUniforms {
+	mat4 vertex_world_to_clip;
+	vec3 camera_position;
+	vec3 light_position;
+};
 
 out VS_OUT {
 	vec3 binormal;
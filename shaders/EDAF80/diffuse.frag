@@ -1,6 +1,11 @@
 #version 410
 
-uniform vec3 light_position;
+layout (std140) uniform FrameUniforms {
+	mat4 vertex_world_to_clip;
+	vec3 camera_position;
+	vec3 light_position;
+};
+
 uniform vec3 ambient_color;
 
 in VS_OUT {
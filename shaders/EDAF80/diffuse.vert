@@ -11,10 +11,20 @@
 // buffer.
 layout (location = 0) in vec3 vertex;
 layout (location = 1) in vec3 normal;
+#ifdef INSTANCED
+// Model-to-world matrix of each instance, applied before the one of the
+// node; it takes locations 5 to 8, one per column.
+layout (location = 5) in mat4 instance_model_to_world;
+#endif
 
 uniform mat4 vertex_model_to_world;
 uniform mat4 normal_model_to_world;
-uniform mat4 vertex_world_to_clip;
+
+layout (std140) uniform FrameUniforms {
+	mat4 vertex_world_to_clip;
+	vec3 camera_position;
+	vec3 light_position;
+};
 
 // This is the custom output of this shader. If you want to retrieve this data
 // from another shader further down the pipeline, you need to declare the exact
@@ -29,10 +39,17 @@ out VS_OUT {
 
 void main()
 {
-	vs_out.vertex = vec3(vertex_model_to_world * vec4(vertex, 1.0));
-	vs_out.normal = vec3(normal_model_to_world * vec4(normal, 0.0));
-
-	gl_Position = vertex_world_to_clip * vertex_model_to_world * vec4(vertex, 1.0);
+#ifdef INSTANCED
+	mat4 model_to_world = vertex_model_to_world * instance_model_to_world;
+	mat3 normal_to_world = mat3(normal_model_to_world) * transpose(inverse(mat3(instance_model_to_world)));
+#else
+	mat4 model_to_world = vertex_model_to_world;
+	mat3 normal_to_world = mat3(normal_model_to_world);
+#endif
+	vs_out.vertex = vec3(model_to_world * vec4(vertex, 1.0));
+	vs_out.normal = normal_to_world * normal;
+
+	gl_Position = vertex_world_to_clip * model_to_world * vec4(vertex, 1.0);
 }
 
 
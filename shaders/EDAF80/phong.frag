@@ -14,10 +14,16 @@ uniform sampler2D Phong_normalmap;
 uniform sampler2D Phong_rough;
 
 uniform bool use_normal_mapping;
-uniform vec3 ambient_colour;
-uniform vec3 diffuse_colour;
-uniform vec3 specular_colour;
-uniform float shininess_value;
+
+layout (std140) uniform MaterialConstants {
+	vec3 diffuse_colour;
+	float shininess_value;
+	vec3 specular_colour;
+	float index_of_refraction_value;
+	vec3 ambient_colour;
+	float opacity_value;
+	vec3 emissive_colour;
+};
 
 void main()
 {
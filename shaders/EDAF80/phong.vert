@@ -8,10 +8,12 @@ layout(location = 4) in vec3 binormal;
 
 uniform mat4 vertex_model_to_world;
 uniform mat4 normal_model_to_world;
-uniform mat4 vertex_world_to_clip;
 
-uniform vec3 light_position;
-uniform vec3 camera_position;
+layout (std140) uniform FrameUniforms {
+	mat4 vertex_world_to_clip;
+	vec3 camera_position;
+	vec3 light_position;
+};
 
 out vec3 Normal_vector;
 out vec3 View_vector;
@@ -4,7 +4,12 @@ layout (location = 0) in vec3 vertex;
 layout (location = 2) in vec3 texcoord;
 
 uniform mat4 vertex_model_to_world;
-uniform mat4 vertex_world_to_clip;
+
+layout (std140) uniform FrameUniforms {
+	mat4 vertex_world_to_clip;
+	vec3 camera_position;
+	vec3 light_position;
+};
 
 out VS_OUT {
 	vec2 texcoord;
@@ -6,10 +6,12 @@ layout (location = 2) in vec2 texCoords;
 
 uniform mat4 vertex_model_to_world;
 uniform mat4 normal_model_to_world;
-uniform mat4 vertex_world_to_clip;
 
-uniform vec3 camera_position;
-uniform vec3 light_position;
+layout (std140) uniform FrameUniforms {
+	mat4 vertex_world_to_clip;
+	vec3 camera_position;
+	vec3 light_position;
+};
 
 uniform float elapsed_time_s;
 uniform float amplitude;
@@ -0,0 +1,38 @@
+#version 430
+
+layout (location = 0) in vec3 vertex;
+
+struct particleParameters {
+	vec3 positions;
+	vec3 velocities;
+	vec3 predictedPosition;
+	vec4 densities;
+};
+
+layout (binding = 0, std430) readonly buffer dataBuffer {
+	particleParameters particles[];
+};
+
+layout (binding = 3, std430) readonly buffer visibleBuffer {
+	uint visibleIndices[];
+};
+
+uniform mat4 vertex_model_to_world;
+uniform mat4 vertex_world_to_clip;
+
+// Start of the list of visible particles for the level of detail being drawn.
+uniform uint visibleOffset;
+// World-space translation of each periodic image, indexed by the top 8 bits
+// of the list entries.
+uniform vec3 imageOffsets[27];
+
+out vec3 paticleVelocity;
+
+void main()
+{
+	uint entry = visibleIndices[visibleOffset + uint(gl_InstanceID)];
+	uint particleIndex = entry & 0xFFFFFFu;
+	vec3 imageOffset = imageOffsets[entry >> 24u];
+	paticleVelocity = particles[particleIndex].velocities;
+	gl_Position = vertex_world_to_clip * vertex_model_to_world * vec4(vertex + particles[particleIndex].positions + imageOffset, 1.0);
+}
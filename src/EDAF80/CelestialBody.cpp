@@ -13,12 +13,11 @@ CelestialBody::CelestialBody(bonobo::mesh_data const& shape,
 	_body.node.set_geometry(shape);
 	_body.node.add_texture("diffuse_texture", diffuse_texture_id, GL_TEXTURE_2D);
 	_body.node.set_program(program);
+
+	_frame.add_child(&_body.node);
 }
 
-glm::mat4 CelestialBody::render(std::chrono::microseconds elapsed_time,
-                                glm::mat4 const& view_projection,
-                                glm::mat4 const& parent_transform,
-                                bool show_basis)
+void CelestialBody::update(std::chrono::microseconds elapsed_time)
 {
 	// Convert the duration from microseconds to seconds.
 	auto const elapsed_time_s = std::chrono::duration<float>(elapsed_time).count();
@@ -26,29 +25,51 @@ glm::mat4 CelestialBody::render(std::chrono::microseconds elapsed_time,
 	// milliseconds, the following would have been used:
 	// auto const elapsed_time_ms = std::chrono::duration<float, std::milli>(elapsed_time).count();
 
-	_body.spin.rotation_angle = -glm::half_pi<float>() / 2.0f;
-
-	glm::mat4 world = parent_transform;
-
-	if (show_basis)
+	// While the animation is paused, the transforms are left untouched so
+	// that their versions do not change and the world matrices are not
+	// computed again.
+	if (elapsed_time_s != 0.0f)
 	{
-		bonobo::renderBasis(1.0f, 2.0f, view_projection, world);
+		_body.orbit.rotation_angle += _body.orbit.speed * elapsed_time_s;
+		_body.spin.rotation_angle += _body.spin.speed * elapsed_time_s;
+		update_transforms();
 	}
 
-	// Note: The second argument of `node::render()` is supposed to be the
-	// parent transform of the node, not the whole world matrix, as the
-	// node internally manages its local transforms. However in our case we
-	// manage all the local transforms ourselves, so the internal transform
-	// of the node is just the identity matrix and we can forward the whole
-	// world matrix.
-	_body.node.render(view_projection, world);
+	for (auto const child : _children)
+		child->update(elapsed_time);
+}
+
+Node const& CelestialBody::get_node() const
+{
+	return _frame;
+}
+
+void CelestialBody::update_transforms()
+{
+	glm::mat4 const orbit = glm::rotate(glm::mat4(1.0f), _body.orbit.inclination, glm::vec3(0.0f, 0.0f, 1.0f))
+	                      * glm::rotate(glm::mat4(1.0f), _body.orbit.rotation_angle, glm::vec3(0.0f, 1.0f, 0.0f));
+	_frame.get_transform().SetTranslate(glm::vec3(orbit * glm::vec4(_body.orbit.radius, 0.0f, 0.0f, 1.0f)));
+
+	auto& body_transform = _body.node.get_transform();
+	body_transform.SetRotateZ(_body.spin.axial_tilt);
+	body_transform.RotateY(_body.spin.rotation_angle);
+	body_transform.SetScale(_body.scale);
 
-	return parent_transform;
+	if (_ring.is_set)
+	{
+		// The ring is modelled in the xy-plane, and lies in the equatorial
+		// plane of the body.
+		auto& ring_transform = _ring.node.get_transform();
+		ring_transform.SetRotateZ(_body.spin.axial_tilt);
+		ring_transform.RotateX(glm::half_pi<float>());
+		ring_transform.SetScale(glm::vec3(_ring.scale, 1.0f));
+	}
 }
 
 void CelestialBody::add_child(CelestialBody* child)
 {
 	_children.push_back(child);
+	_frame.add_child(&child->_frame);
 }
 
 std::vector<CelestialBody*> const& CelestialBody::get_children() const
@@ -62,11 +83,13 @@ void CelestialBody::set_orbit(OrbitConfiguration const& configuration)
 	_body.orbit.inclination = configuration.inclination;
 	_body.orbit.speed = configuration.speed;
 	_body.orbit.rotation_angle = 0.0f;
+	update_transforms();
 }
 
 void CelestialBody::set_scale(glm::vec3 const& scale)
 {
 	_body.scale = scale;
+	update_transforms();
 }
 
 void CelestialBody::set_spin(SpinConfiguration const& configuration)
@@ -74,6 +97,7 @@ void CelestialBody::set_spin(SpinConfiguration const& configuration)
 	_body.spin.axial_tilt = configuration.axial_tilt;
 	_body.spin.speed = configuration.speed;
 	_body.spin.rotation_angle = 0.0f;
+	update_transforms();
 }
 
 void CelestialBody::set_ring(bonobo::mesh_data const& shape,
@@ -87,5 +111,8 @@ void CelestialBody::set_ring(bonobo::mesh_data const& shape,
 
 	_ring.scale = scale;
 
+	if (!_ring.is_set)
+		_frame.add_child(&_ring.node);
 	_ring.is_set = true;
+	update_transforms();
 }
@@ -34,24 +34,33 @@ public:
 	CelestialBody(bonobo::mesh_data const& shape, GLuint const* program,
 	              GLuint diffuse_texture_id);
 
-	//! \brief Render this celestial body.
+	CelestialBody(CelestialBody const&) = delete;
+	CelestialBody& operator=(CelestialBody const&) = delete;
+
+	//! \brief Advance the orbit and spin of this celestial body and of
+	//!        all its children.
+	//!
+	//! Only the transforms of the nodes are updated; the bodies are drawn
+	//! by going through the hierarchy starting at |get_node()|, e.g. with
+	//! a |SceneTransforms|.
 	//!
 	//! @param [in] elapsed_time Amount of time (in microseconds) between
 	//!             two frames
-	//! @param [in] view_projection Matrix transforming from world space to
-	//!             clip space
-	//! @param [in] parent_transform Matrix transforming from the parent’s
-	//!             local space to world space
-	//! @param [in] show_basis Show a 3D basis transformed by the world matrix
-	//!             of this celestial body
-	//! @return Matrix transforming from this celestial body’s local space
-	//!         to world space
-	glm::mat4 render(std::chrono::microseconds elapsed_time,
-	                 glm::mat4 const& view_projection,
-	                 glm::mat4 const& parent_transform = glm::mat4(1.0f),
-	                 bool show_basis = false);
+	void update(std::chrono::microseconds elapsed_time);
+
+	//! \brief Return the node at the top of the hierarchy of this
+	//!        celestial body.
+	//!
+	//! It is placed at the centre of the body in the space of its parent,
+	//! and has the body, its ring and the top nodes of its children below
+	//! it: children inherit the position of the body but neither its
+	//! spin nor its scale.
+	Node const& get_node() const;
 
 	//! \brief Mark another celestial body as being “attached” to the current one.
+	//!
+	//! @param [in] child Celestial body orbiting this one; it has to
+	//!             outlive this celestial body
 	void add_child(CelestialBody* child);
 
 	//! \brief Return all the children of this celestial body.
@@ -80,6 +89,12 @@ public:
 	              glm::vec2 const& scale = glm::vec2(1.0f));
 
 private:
+	//! \brief Set the transforms of the nodes from the current orbit,
+	//!        spin and scale.
+	void update_transforms();
+
+	Node _frame;
+
 	struct {
 		Node node;
 		struct {
@@ -3,8 +3,11 @@
 #include "parametric_shapes.hpp"
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
+#include "core/FrameUniforms.hpp"
 #include "core/helpers.hpp"
 #include "core/node.hpp"
+#include "core/RenderQueue.hpp"
+#include "core/SceneTransforms.hpp"
 #include "core/ShaderProgramManager.hpp"
 
 #include <imgui.h>
@@ -68,6 +71,7 @@ int main()
 	//
 	// Create the shader program
 	//
+	FrameUniforms frame_uniforms;
 	ShaderProgramManager program_manager;
 	GLuint celestial_body_shader = 0u;
 	program_manager.CreateAndRegisterProgram("Celestial Body",
@@ -168,6 +172,8 @@ int main()
 	earth.set_orbit({-2.5f, glm::radians(45.0f), glm::two_pi<float>() / 10.0f});
 	earth.add_child(&moon);
 
+	SceneTransforms scene_transforms(earth.get_node(), glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f)));
+
 
 	//
 	// Define the colour and depth used for clearing.
@@ -186,6 +192,8 @@ int main()
 	bool show_basis = false;
 	float time_scale = 1.0f;
 
+	RenderQueue render_queue;
+
 	while (!glfwWindowShouldClose(window)) {
 		//
 		// Compute timings information
@@ -237,20 +245,21 @@ int main()
 		//
 		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
+		frame_uniforms.update(camera.GetWorldToClipMatrix(), camera.mWorld.GetTranslation(), glm::vec3(0.0f));
+
 
 		//
 		// Traverse the scene graph and render all nodes
 		//
-		struct CelestialBodyRef
+		earth.update(animation_delta_time_us);
+		scene_transforms.update();
+		render_queue.submit(scene_transforms);
+		if (show_basis)
 		{
-			CelestialBody* body;
-			glm::mat4 parent_transform;
-		};
-		// TODO: Replace this explicit rendering of the Earth and Moon
-		// with a traversal of the scene graph and rendering of all its
-		// nodes.
-		earth.render(animation_delta_time_us, camera.GetWorldToClipMatrix(), glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f)), show_basis);
-		moon.render(animation_delta_time_us, camera.GetWorldToClipMatrix(), glm::mat4(1.0f), show_basis);
+			for (auto const& entry : scene_transforms.get_entries())
+				bonobo::renderBasis(1.0f, 2.0f, camera.GetWorldToClipMatrix(), entry.world);
+		}
+		render_queue.flush(camera.GetWorldToClipMatrix());
 
 
 		//
@@ -263,6 +272,13 @@ int main()
 			ImGui::SliderFloat("Time scale", &time_scale, 1e-1f, 10.0f);
 			ImGui::Separator();
 			ImGui::Checkbox("Show basis", &show_basis);
+			ImGui::Separator();
+			auto const& render_stats = render_queue.get_stats();
+			ImGui::Text("Draws: %u", render_stats.draws);
+			ImGui::Text("Program binds: %u", render_stats.program_binds);
+			ImGui::Text("Vertex array binds: %u", render_stats.vertex_array_binds);
+			ImGui::Text("Texture binds: %u", render_stats.texture_binds);
+			ImGui::Text("Material changes: %u", render_stats.material_changes);
 		}
 		ImGui::End();
 
@@ -5,6 +5,7 @@
 #include "config.hpp"
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
+#include "core/FrameUniforms.hpp"
 #include "core/node.hpp"
 #include "core/ShaderProgramManager.hpp"
 #include <imgui.h>
@@ -59,6 +60,7 @@ edaf80::Assignment2::run()
 	mCamera.mMovementSpeed = glm::vec3(3.0f); // 3 m/s => 10.8 km/h
 
 	// Create the shader programs
+	FrameUniforms frame_uniforms;
 	ShaderProgramManager program_manager;
 	GLuint fallback_shader = 0u;
 	program_manager.CreateAndRegisterProgram("Fallback",
@@ -110,10 +112,8 @@ edaf80::Assignment2::run()
 	if (texcoord_shader == 0u)
 		LogError("Failed to load texcoord shader");
 
+	// Shared by all programs through the `FrameUniforms` block.
 	auto const light_position = glm::vec3(-2.0f, 4.0f, 2.0f);
-	auto const set_uniforms = [&light_position](GLuint program){
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
-	};
 
 	// Set the default tensions value; it can always be changed at runtime
 	// through the "Scene Controls" window.
@@ -135,7 +135,7 @@ edaf80::Assignment2::run()
 
 	auto circle_rings = Node();
 	circle_rings.set_geometry(shape);
-	circle_rings.set_program(&fallback_shader, set_uniforms);
+	circle_rings.set_program(&fallback_shader);
 	TRSTransformf& circle_rings_transform_ref = circle_rings.get_transform();
 
 
@@ -164,7 +164,7 @@ edaf80::Assignment2::run()
 	for (std::size_t i = 0; i < control_point_locations.size(); ++i) {
 		auto& control_point = control_points[i];
 		control_point.set_geometry(control_point_sphere);
-		control_point.set_program(&diffuse_shader, set_uniforms);
+		control_point.set_program(&diffuse_shader);
 		control_point.get_transform().SetTranslate(control_point_locations[i]);
 	}
 
@@ -227,6 +227,8 @@ edaf80::Assignment2::run()
 		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 		bonobo::changePolygonMode(polygon_mode);
 
+		frame_uniforms.update(mCamera.GetWorldToClipMatrix(), mCamera.mWorld.GetTranslation(), light_position);
+
 
 		if (interpolate) {
 			//! \todo Interpolate the movement of a shape between various
@@ -276,7 +278,7 @@ edaf80::Assignment2::run()
 			bonobo::uiSelectPolygonMode("Polygon mode", polygon_mode);
 			auto selection_result = program_manager.SelectProgram("Shader", program_index);
 			if (selection_result.was_selection_changed) {
-				circle_rings.set_program(selection_result.program, set_uniforms);
+				circle_rings.set_program(selection_result.program);
 			}
 			ImGui::Separator();
 			ImGui::Checkbox("Show control points", &show_control_points);
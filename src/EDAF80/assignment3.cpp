@@ -5,6 +5,7 @@
 #include "config.hpp"
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
+#include "core/FrameUniforms.hpp"
 #include "core/node.hpp"
 #include "core/ShaderProgramManager.hpp"
 
@@ -48,6 +49,7 @@ edaf80::Assignment3::run()
 	mCamera.mMovementSpeed = glm::vec3(3.0f); // 3 m/s => 10.8 km/h
 
 	// Create the shader programs
+	FrameUniforms frame_uniforms;
 	ShaderProgramManager program_manager;
 	GLuint fallback_shader = 0u;
 	program_manager.CreateAndRegisterProgram("Fallback",
@@ -100,17 +102,14 @@ edaf80::Assignment3::run()
 		LogError("Failed to load phong shader");
 	//added end
 
+	// The light and camera positions are shared by all programs through
+	// the `FrameUniforms` block.
 	auto light_position = glm::vec3(-2.0f, 4.0f, 2.0f);
-	auto const set_uniforms = [&light_position](GLuint program){
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
-	};
 
 	bool use_normal_mapping = false;
 	auto camera_position = mCamera.mWorld.GetTranslation();
-	auto const phong_set_uniforms = [&use_normal_mapping,&light_position,&camera_position](GLuint program){
+	auto const phong_set_uniforms = [&use_normal_mapping](GLuint program){
 		glUniform1i(glGetUniformLocation(program, "use_normal_mapping"), use_normal_mapping ? 1 : 0);
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
-		glUniform3fv(glGetUniformLocation(program, "camera_position"), 1, glm::value_ptr(camera_position));
 	};
 	
 	//glm::vec3 ambient = glm::vec3(0.1f, 0.1f, 0.1f);
@@ -151,7 +150,7 @@ edaf80::Assignment3::run()
 	//added end
 	//skybox.set_program(&fallback_shader, set_uniforms);
 	//changed to
-	skybox.set_program(&skybox_shader, set_uniforms);
+	skybox.set_program(&skybox_shader);
 
 	auto demo_shape = parametric_shapes::createSphere(1.5f, 40u, 40u);
 	if (demo_shape.vao == 0u) {
@@ -228,6 +227,8 @@ edaf80::Assignment3::run()
 				                   "Rendering is suspended until the issue is solved. Once fixed, just reload the shaders again.",
 				                   "error");
 		}
+		if (program_manager.PollHotReload())
+			shader_reload_failed = false;
 		if (inputHandler.GetKeycodeState(GLFW_KEY_F3) & JUST_RELEASED)
 			show_logs = !show_logs;
 		if (inputHandler.GetKeycodeState(GLFW_KEY_F2) & JUST_RELEASED)
@@ -254,6 +255,8 @@ edaf80::Assignment3::run()
 		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 		bonobo::changePolygonMode(polygon_mode);
 
+		frame_uniforms.update(mCamera.GetWorldToClipMatrix(), camera_position, light_position);
+
 		skybox.get_transform().SetTranslate(camera_position);
 		glDisable(GL_DEPTH_TEST);
 		skybox.render(mCamera.GetWorldToClipMatrix());
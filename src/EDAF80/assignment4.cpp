@@ -4,6 +4,7 @@
 #include "config.hpp"
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
+#include "core/FrameUniforms.hpp"
 #include "core/helpers.hpp"
 #include "core/node.hpp"
 #include "core/ShaderProgramManager.hpp"
@@ -47,6 +48,7 @@ edaf80::Assignment4::run()
 	auto camera_position = mCamera.mWorld.GetTranslation();
 
 	// Create the shader programs
+	FrameUniforms frame_uniforms;
 	ShaderProgramManager program_manager;
 	GLuint fallback_shader = 0u;
 	program_manager.CreateAndRegisterProgram("Fallback",
@@ -97,13 +99,9 @@ edaf80::Assignment4::run()
 	glm::vec2 direction = glm::vec2(-1.0f, 0.0f);
 	glm::vec2 direction1 = glm::vec2(-0.7f, 0.7f);
 
-	auto const set_uniforms = [&light_position](GLuint program) {
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
-		};
-
-	auto const water_set_uniforms = [&light_position, &camera_position, &ambient_color, &deep_color, &shallow_color, &elapsed_time_s, &amplitude, &frequency, &phare_constant, &sharpness, &direction, &amplitude1, &frequency1, &phare_constant1, &sharpness1, &direction1](GLuint program) {
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
-		glUniform3fv(glGetUniformLocation(program, "camera_position"), 1, glm::value_ptr(camera_position));
+	// The light and camera positions are shared by all programs through
+	// the `FrameUniforms` block.
+	auto const water_set_uniforms = [&ambient_color, &deep_color, &shallow_color, &elapsed_time_s, &amplitude, &frequency, &phare_constant, &sharpness, &direction, &amplitude1, &frequency1, &phare_constant1, &sharpness1, &direction1](GLuint program) {
 		glUniform3fv(glGetUniformLocation(program, "ambient_color"), 1, glm::value_ptr(ambient_color));
 		glUniform4fv(glGetUniformLocation(program, "deep_color"), 1, glm::value_ptr(deep_color));
 		glUniform4fv(glGetUniformLocation(program, "shallow_color"), 1, glm::value_ptr(shallow_color));
@@ -142,7 +140,7 @@ edaf80::Assignment4::run()
 		config::resources_path("cubemaps/NissiBeach2/negz.jpg"));
 	skybox.add_texture("cubemap", cubemap, GL_TEXTURE_CUBE_MAP);
 
-	skybox.set_program(&skybox_shader, set_uniforms);
+	skybox.set_program(&skybox_shader);
 	//set water quad
 	auto water_shape = parametric_shapes::createQuad(100.0f, 100.0f, 1000, 1000);
 
@@ -207,6 +205,8 @@ edaf80::Assignment4::run()
 				                   "Rendering is suspended until the issue is solved. Once fixed, just reload the shaders again.",
 				                   "error");
 		}
+		if (program_manager.PollHotReload())
+			shader_reload_failed = false;
 		if (inputHandler.GetKeycodeState(GLFW_KEY_F3) & JUST_RELEASED)
 			show_logs = !show_logs;
 		if (inputHandler.GetKeycodeState(GLFW_KEY_F2) & JUST_RELEASED)
@@ -236,6 +236,7 @@ edaf80::Assignment4::run()
 		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 		bonobo::changePolygonMode(polygon_mode);
 
+		frame_uniforms.update(mCamera.GetWorldToClipMatrix(), camera_position, light_position);
 
 		if (!shader_reload_failed) {
 			//
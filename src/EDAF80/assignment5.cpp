@@ -5,8 +5,13 @@
 #include "config.hpp"
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
+#include "core/FrameUniforms.hpp"
 #include "core/helpers.hpp"
+#include "core/InstanceBuffer.hpp"
 #include "core/node.hpp"
+#include "core/RenderQueue.hpp"
+#include "core/ResourceManager.hpp"
+#include "core/SceneTransforms.hpp"
 #include "core/ShaderProgramManager.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
@@ -219,6 +224,7 @@ public:
 	Node bullet_node;
 	bool isActive;
 	glm::vec3 shot_direction;
+	ResourceManager::MeshHandle shape;
 };
 bullet::bullet(Node node, glm::vec3 direction) {
 	bullet_node = node;
@@ -235,6 +241,7 @@ public:
 	Node upgrade_node;
 	bool isActive;
 	upgrade_type type;
+	ResourceManager::MeshHandle shape;
 };
 upgrade::upgrade(Node node, upgrade_type Upgrade) {
 	upgrade_node = node;
@@ -243,18 +250,60 @@ upgrade::upgrade(Node node, upgrade_type Upgrade) {
 }
 upgrade::~upgrade() {
 
+}
+//! \brief Entities sharing a geometry and a colour, drawn with a single
+//!        instanced draw.
+//!
+//! The world matrices added during a frame are uploaded and drawn by
+//! |render()|. Groups sharing a geometry, such as the player and enemy
+//! bullets, point it at their own instances when updated, so each group is
+//! drawn right after its update.
+class instanced_group {
+public:
+	instanced_group(bonobo::mesh_data const& shape, GLuint const* program, std::function<void (GLuint)> const& set_uniforms);
+	void add(glm::mat4 const& world);
+	void render(glm::mat4 const& view_projection);
+	Node node;
+	InstanceBuffer instances;
+	std::vector<glm::mat4> worlds;
+};
+instanced_group::instanced_group(bonobo::mesh_data const& shape, GLuint const* program, std::function<void (GLuint)> const& set_uniforms) :
+	instances({ { 5u, InstanceBuffer::AttributeType::mat4 } })
+{
+	node.set_geometry(shape);
+	node.set_program(program, set_uniforms);
+	instances.attach(shape);
+}
+void instanced_group::add(glm::mat4 const& world) {
+	worlds.push_back(world);
+}
+void instanced_group::render(glm::mat4 const& view_projection) {
+	instances.update(0u, worlds);
+	node.render_instanced(view_projection, instances);
+	worlds.clear();
+}
+// All upgrades share the same sphere, and so do all bullets.
+ResourceManager::MeshHandle getUpgradeShape() {
+	return ResourceManager::get_mesh(ResourceManager::make_key("sphere", 1.5f, 10u, 10u),
+	                                 [](){ return parametric_shapes::createSphere(1.5f, 10u, 10u); });
+}
+ResourceManager::MeshHandle getBulletShape() {
+	return ResourceManager::get_mesh(ResourceManager::make_key("sphere", 0.5f, 5u, 5u),
+	                                 [](){ return parametric_shapes::createSphere(0.5f, 5u, 5u); });
 }
 upgrade* createUpgradeSphere(glm::vec3 Translation, std::vector<upgrade*>& upgrade_vector, upgrade_type type) {
-	auto upgrade_shape = parametric_shapes::createSphere(1.5f, 10u, 10u);;
+	auto const upgrade_shape = getUpgradeShape();
 	Node upgrade_node;
-	upgrade_node.set_geometry(upgrade_shape);
+	if (upgrade_shape)
+		upgrade_node.set_geometry(*upgrade_shape);
 	upgrade_node.get_transform().SetTranslate(Translation);
 	upgrade* new_upgrade = new upgrade(upgrade_node, type);
+	new_upgrade->shape = upgrade_shape;
 	upgrade_vector.push_back(new_upgrade);
 	return new_upgrade;
 }
 
-enemy* createEnemy(int enemyType, glm::vec3 Translation, std::vector<enemy*>& enemy_vector, std::vector<bonobo::mesh_data> enemy_shape0, std::vector<bonobo::mesh_data> enemy_shape1, std::vector<bonobo::mesh_data> turret_shape) {
+enemy* createEnemy(int enemyType, glm::vec3 Translation, std::vector<enemy*>& enemy_vector, std::vector<bonobo::mesh_data> const& enemy_shape0, std::vector<bonobo::mesh_data> const& enemy_shape1, std::vector<bonobo::mesh_data> const& turret_shape) {
 	if (!enemy_vector.empty()) {
 		for (enemy* tmp_enemy : enemy_vector) {
 			if (tmp_enemy->isActive == false && tmp_enemy->enemy_type == enemyType) {
@@ -294,11 +343,13 @@ bullet* createBullet(glm::vec3 Translation, glm::vec3 direction, std::vector<bul
 				return tmp_bullet;
 			}
 	}
-	auto bullet_shape = parametric_shapes::createSphere(0.5f, 5u, 5u);;
+	auto const bullet_shape = getBulletShape();
 	Node bullet_node;
-	bullet_node.set_geometry(bullet_shape);
+	if (bullet_shape)
+		bullet_node.set_geometry(*bullet_shape);
 	bullet_node.get_transform().SetTranslate(Translation);
 	bullet* new_bullet = new bullet(bullet_node, direction);
+	new_bullet->shape = bullet_shape;
 	bullet_vector.push_back(new_bullet);
 	return new_bullet;
 }
@@ -315,6 +366,7 @@ edaf80::Assignment5::run()
 	auto camera_position = mCamera.mWorld.GetTranslation();
 
 	// Create the shader programs
+	FrameUniforms frame_uniforms;
 	ShaderProgramManager program_manager;
 	GLuint fallback_shader = 0u;
 	program_manager.CreateAndRegisterProgram("Fallback",
@@ -334,6 +386,16 @@ edaf80::Assignment5::run()
 		LogError("Failed to load diffuse shader");
 		return;
 	}
+	GLuint diffuse_instanced_shader = 0u;
+	program_manager.CreateAndRegisterProgram("Diffuse (instanced)",
+		{ { ShaderType::vertex, "EDAF80/diffuse.vert" },
+		  { ShaderType::fragment, "EDAF80/diffuse.frag" } },
+		{ { "INSTANCED", "1" } },
+		diffuse_instanced_shader);
+	if (diffuse_instanced_shader == 0u) {
+		LogError("Failed to load instanced diffuse shader");
+		return;
+	}
 	GLuint water_shader = 0u;
 	program_manager.CreateAndRegisterProgram("water",
 		{ { ShaderType::vertex, "EDAF80/water.vert" },
@@ -392,38 +454,29 @@ edaf80::Assignment5::run()
 	//the color of upgrade ball
 	glm::vec3 upgrade_ambient_color = glm::vec3(0.0f, 1.0f, 0.0f);
 
-	auto const playerboat_set_uniforms = [&light_position, &playerBoat_ambient_color](GLuint program) {
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
+	auto const playerboat_set_uniforms = [&playerBoat_ambient_color](GLuint program) {
 		glUniform3fv(glGetUniformLocation(program, "ambient_color"), 1, glm::value_ptr(playerBoat_ambient_color));
 		};
-	auto const playerturret_set_uniforms = [&light_position, &playerTurret_ambient_color](GLuint program) {
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
+	auto const playerturret_set_uniforms = [&playerTurret_ambient_color](GLuint program) {
 		glUniform3fv(glGetUniformLocation(program, "ambient_color"), 1, glm::value_ptr(playerTurret_ambient_color));
 		};
-	auto const enemyboat_set_uniforms = [&light_position, &enemyBoat_ambient_color](GLuint program) {
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
+	auto const enemyboat_set_uniforms = [&enemyBoat_ambient_color](GLuint program) {
 		glUniform3fv(glGetUniformLocation(program, "ambient_color"), 1, glm::value_ptr(enemyBoat_ambient_color));
 		};
-	auto const enemyturret_set_uniforms = [&light_position, &enemyTurret_ambient_color](GLuint program) {
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
+	auto const enemyturret_set_uniforms = [&enemyTurret_ambient_color](GLuint program) {
 		glUniform3fv(glGetUniformLocation(program, "ambient_color"), 1, glm::value_ptr(enemyTurret_ambient_color));
 		};
-	auto const playerbullet_set_uniforms = [&light_position, &playerBullet_ambient_color](GLuint program) {
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
+	auto const playerbullet_set_uniforms = [&playerBullet_ambient_color](GLuint program) {
 		glUniform3fv(glGetUniformLocation(program, "ambient_color"), 1, glm::value_ptr(playerBullet_ambient_color));
 		};
-	auto const enenmybullet_set_uniforms = [&light_position, &enemyBullet_ambient_color](GLuint program) {
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
+	auto const enenmybullet_set_uniforms = [&enemyBullet_ambient_color](GLuint program) {
 		glUniform3fv(glGetUniformLocation(program, "ambient_color"), 1, glm::value_ptr(enemyBullet_ambient_color));
 		};
-	auto const ungrade_set_uniforms = [&light_position, &upgrade_ambient_color](GLuint program) {
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
+	auto const ungrade_set_uniforms = [&upgrade_ambient_color](GLuint program) {
 		glUniform3fv(glGetUniformLocation(program, "ambient_color"), 1, glm::value_ptr(upgrade_ambient_color));
 		};
 
-	auto const water_set_uniforms = [&light_position, &camera_position, &ambient_color, &deep_color, &shallow_color, &elapsed_time_s, &amplitude, &frequency, &phare_constant, &sharpness, &direction, &amplitude1, &frequency1, &phare_constant1, &sharpness1, &direction1](GLuint program) {
-		glUniform3fv(glGetUniformLocation(program, "light_position"), 1, glm::value_ptr(light_position));
-		glUniform3fv(glGetUniformLocation(program, "camera_position"), 1, glm::value_ptr(camera_position));
+	auto const water_set_uniforms = [&ambient_color, &deep_color, &shallow_color, &elapsed_time_s, &amplitude, &frequency, &phare_constant, &sharpness, &direction, &amplitude1, &frequency1, &phare_constant1, &sharpness1, &direction1](GLuint program) {
 		glUniform3fv(glGetUniformLocation(program, "ambient_color"), 1, glm::value_ptr(ambient_color));
 		glUniform4fv(glGetUniformLocation(program, "deep_color"), 1, glm::value_ptr(deep_color));
 		glUniform4fv(glGetUniformLocation(program, "shallow_color"), 1, glm::value_ptr(shallow_color));
@@ -442,40 +495,45 @@ edaf80::Assignment5::run()
 	float waterWidth = 400.0f;
 	float waterHeight = 400.0f;
 	//load models
-		auto enemy_shape0 = bonobo::loadObjects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/boat1.obj");
-		auto enemy_shape1 = bonobo::loadObjects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/boat3.obj");
-		auto turret_shape = bonobo::loadObjects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/turret3.obj");
+		// The handles keep the loaded files alive until the end of the run;
+		// loading the same file twice shares its meshes and textures.
+		std::vector<ResourceManager::ObjectsHandle> loaded_objects;
+		auto const load_objects = [&loaded_objects](std::string const& filename){
+			auto const objects = ResourceManager::get_objects(filename);
+			loaded_objects.push_back(objects);
+			return objects ? *objects : std::vector<bonobo::mesh_data>();
+		};
+		auto enemy_shape0 = load_objects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/boat1.obj");
+		auto enemy_shape1 = load_objects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/boat3.obj");
+		auto turret_shape = load_objects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/turret3.obj");
 
-		auto Player_shape = bonobo::loadObjects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/boat2.obj");
+		auto Player_shape = load_objects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/boat2.obj");
 		Node Player;
 		Player.set_geometry(Player_shape[0]);
 		Player.set_program(&diffuse_shader, playerboat_set_uniforms);
 		Player.get_transform().SetTranslate(glm::vec3(waterWidth / 2, 5.0f, waterHeight / 2));
 
-		auto turret1_shape = bonobo::loadObjects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/turret2.obj");
+		auto turret1_shape = load_objects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/turret2.obj");
 		Node turret1;
 		turret1.set_geometry(turret1_shape[0]);
 		turret1.set_program(&diffuse_shader, playerturret_set_uniforms);
 
-		auto turret2_shape = bonobo::loadObjects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/turret3.obj");
+		auto turret2_shape = load_objects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/turret3.obj");
 		Node turret2;
 		turret2.set_geometry(turret2_shape[0]);
 		turret2.set_program(&diffuse_shader, playerturret_set_uniforms);
 
-		auto turret3_shape = bonobo::loadObjects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/turret1.obj");
+		auto turret3_shape = load_objects("F:/desktop/CourseFile/ComputerGraphics/res/scenes/turret1.obj");
 		Node turret3;
 		turret3.set_geometry(turret3_shape[0]);
 		turret3.set_program(&diffuse_shader, playerturret_set_uniforms);
 
 		std::vector<Node> turret_vector;
 		std::map<Node, bool> turret_Dictionary;
-		Player.add_child(&turret1);
 		turret1.get_transform().SetScale(glm::vec3(0.5f, 0.5f, 0.5f));
 		turret1.get_transform().SetTranslate(glm::vec3(0, 1.2f, 2.0f));
-		Player.add_child(&turret2);
 		turret2.get_transform().SetScale(glm::vec3(0.5f, 0.5f, 0.5f));
 		turret2.get_transform().SetTranslate(glm::vec3(0, 1.2f, -1.6f));
-		Player.add_child(&turret3);
 		turret3.get_transform().SetScale(glm::vec3(0.5f, 0.5f, 0.5f));
 		turret3.get_transform().SetTranslate(glm::vec3(0, 2.0f, 0.5f));
 
@@ -485,6 +543,9 @@ edaf80::Assignment5::run()
 		turret_vector.push_back(turret1);
 		turret_vector.push_back(turret2);
 		turret_vector.push_back(turret3);
+		// The turrets drawn are the copies above; only the active ones are
+		// children of the boat.
+		Player.add_child(&turret_vector[0]);
 
 		auto bullet_shape = parametric_shapes::createSphere(5.0f, 10u, 10u);
 		//
@@ -522,12 +583,36 @@ edaf80::Assignment5::run()
 		Node water_quad;
 
 		water_quad.set_geometry(water_shape);
-		GLuint wave_texture = bonobo::loadTexture2D(config::resources_path("textures/waves.png"));
-		water_quad.add_texture("waveTexture", wave_texture, GL_TEXTURE_2D);
+		auto const wave_texture = ResourceManager::get_texture_2d(config::resources_path("textures/waves.png"));
+		water_quad.add_texture("waveTexture", wave_texture ? *wave_texture : 0u, GL_TEXTURE_2D);
 		water_quad.add_texture("cubemap", cubemap, GL_TEXTURE_CUBE_MAP);
 		water_quad.set_program(&water_shader, water_set_uniforms);
+
+		// The skybox is drawn on its own, with depth testing disabled, so
+		// it stays out of the scene.
+		Node scene;
+		scene.add_child(&water_quad);
+		scene.add_child(&Player);
+		SceneTransforms scene_transforms(scene);
+
+		// Bullets, enemies and upgrades are many copies of a few meshes, so
+		// each kind is drawn with one instanced draw.
+		auto const bullet_shape = getBulletShape();
+		auto const upgrade_shape = getUpgradeShape();
+		if (!bullet_shape || !upgrade_shape) {
+			LogError("Failed to retrieve the meshes of the bullets and upgrades");
+			return;
+		}
+		instanced_group player_bullet_group(*bullet_shape, &diffuse_instanced_shader, playerbullet_set_uniforms);
+		instanced_group enemy_bullet_group(*bullet_shape, &diffuse_instanced_shader, enemyboat_set_uniforms);
+		instanced_group enemy1_group(enemy_shape0[0], &diffuse_instanced_shader, enemyboat_set_uniforms);
+		instanced_group enemy2_group(enemy_shape1[0], &diffuse_instanced_shader, enemyboat_set_uniforms);
+		instanced_group enemy_turret_group(turret_shape[0], &diffuse_instanced_shader, enemyturret_set_uniforms);
+		instanced_group upgrade_group(*upgrade_shape, &diffuse_instanced_shader, ungrade_set_uniforms);
 		//added end
 
+		ResourceManager::log_stats();
+
 		glClearDepthf(1.0f);
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glEnable(GL_DEPTH_TEST);
@@ -547,6 +632,8 @@ edaf80::Assignment5::run()
 		float basis_thickness_scale = 1.0f;
 		float basis_length_scale = 1.0f;
 
+		RenderQueue render_queue;
+
 		changeCullMode(cull_mode);
 		bool moveRight = false;
 		bool moveDown = false;
@@ -856,6 +943,7 @@ edaf80::Assignment5::run()
 								switch (upgrade->type) {
 								case upgrade_type(oneMoreTurret):
 									num_turret++;
+									Player.add_child(&turret_vector[num_turret - 1]);
 									shownText1 = "one more turret!";
 									break;
 								case upgrade_type(IncreaseShotFrequency):
@@ -984,6 +1072,8 @@ edaf80::Assignment5::run()
 						"Rendering is suspended until the issue is solved. Once fixed, just reload the shaders again.",
 						"error");
 			}
+			if (program_manager.PollHotReload())
+				shader_reload_failed = false;
 			if (inputHandler.GetKeycodeState(GLFW_KEY_F3) & JUST_RELEASED)
 				show_logs = !show_logs;
 			if (inputHandler.GetKeycodeState(GLFW_KEY_F2) & JUST_RELEASED)
@@ -1078,6 +1168,7 @@ edaf80::Assignment5::run()
 			glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 			bonobo::changePolygonMode(polygon_mode);
 
+			frame_uniforms.update(mCamera.GetWorldToClipMatrix(), camera_position, light_position);
 
 			if (!shader_reload_failed) {
 				//
@@ -1087,40 +1178,46 @@ edaf80::Assignment5::run()
 				glDisable(GL_DEPTH_TEST);
 				skybox.render(mCamera.GetWorldToClipMatrix());
 				glEnable(GL_DEPTH_TEST);
-				water_quad.render(mCamera.GetWorldToClipMatrix());
-				Player.render(mCamera.GetWorldToClipMatrix());
+				// Everything else is opaque and depth-tested, so it can be
+				// drawn in whichever order changes the least state.
+				scene_transforms.update();
+				render_queue.submit(scene_transforms);
 				//turret1.render(mCamera.GetWorldToClipMatrix(), Player.get_transform().GetMatrix());
 				//turret2.render(mCamera.GetWorldToClipMatrix(), Player.get_transform().GetMatrix());
-				for (int i = 0; i < num_turret; i++) {
-					turret_vector[i].render(mCamera.GetWorldToClipMatrix(), Player.get_transform().GetMatrix());
-				}
 				for (enemy* enemy : enemies) {
 					if (enemy->isActive) {						
 						if (enemy->enemy_type == 1) {
-							enemy->enemy_node.render(mCamera.GetWorldToClipMatrix());
+							enemy1_group.add(enemy->enemy_node.get_transform().GetMatrix());
 						}
 						else {
-							enemy->enemy_node.render(mCamera.GetWorldToClipMatrix());
+							enemy2_group.add(enemy->enemy_node.get_transform().GetMatrix());
 							//std::cout << enemy->enemy_turret.get_transform().GetTranslation() << std::endl;
-							enemy->enemy_turret.render(mCamera.GetWorldToClipMatrix(), enemy->enemy_node.get_transform().GetMatrix());
+							enemy_turret_group.add(enemy->enemy_node.get_transform().GetMatrix() * enemy->enemy_turret.get_transform().GetMatrix());
 						}
 					}
 				}
 				for (bullet* Bullet : player_bullets) {
 					if (Bullet->isActive) {
-						Bullet->bullet_node.render(mCamera.GetWorldToClipMatrix());
+						player_bullet_group.add(Bullet->bullet_node.get_transform().GetMatrix());
 					}
 				}
 				for (bullet* Bullet : enemies_bullets) {
 					if (Bullet->isActive) {
-						Bullet->bullet_node.render(mCamera.GetWorldToClipMatrix());
+						enemy_bullet_group.add(Bullet->bullet_node.get_transform().GetMatrix());
 					}
 				}
 				for (upgrade* upgrade : upgrades) {
 					if (upgrade->isActive) {
-						upgrade->upgrade_node.render(mCamera.GetWorldToClipMatrix());
+						upgrade_group.add(upgrade->upgrade_node.get_transform().GetMatrix());
 					}
 				}
+				render_queue.flush(mCamera.GetWorldToClipMatrix());
+				enemy1_group.render(mCamera.GetWorldToClipMatrix());
+				enemy2_group.render(mCamera.GetWorldToClipMatrix());
+				enemy_turret_group.render(mCamera.GetWorldToClipMatrix());
+				player_bullet_group.render(mCamera.GetWorldToClipMatrix());
+				enemy_bullet_group.render(mCamera.GetWorldToClipMatrix());
+				upgrade_group.render(mCamera.GetWorldToClipMatrix());
 			}
 
 
@@ -1188,6 +1285,15 @@ edaf80::Assignment5::run()
 
 			glfwSwapBuffers(window);
 		}
+
+		// Release the shared bullet and upgrade spheres while the context
+		// is still alive.
+		for (bullet* b : player_bullets)
+			delete b;
+		for (bullet* b : enemies_bullets)
+			delete b;
+		for (upgrade* u : upgrades)
+			delete u;
 	}
 
 
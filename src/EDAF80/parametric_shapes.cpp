@@ -588,10 +588,10 @@ parametric_shapes::createCircleRing(float const radius,
 	return data;
 }
 bonobo::mesh_data
-parametric_shapes::createBriefCircleRingBatch2(float const radius,
-	float const spread_length,
-	unsigned int const circle_split_count,
-	unsigned int const spread_split_count, int particleNum, std::vector<glm::vec2>& positions, std::vector<glm::vec2>& velocities)
+parametric_shapes::createBriefCircleRing(float const radius,
+                                         float const spread_length,
+                                         unsigned int const circle_split_count,
+                                         unsigned int const spread_split_count)
 {
 	auto const circle_slice_edges_count = circle_split_count + 1u;
 	auto const spread_slice_edges_count = spread_split_count + 1u;
@@ -651,248 +651,19 @@ parametric_shapes::createBriefCircleRingBatch2(float const radius,
 	assert(data.vao != 0u);
 	glBindVertexArray(data.vao);
 
-	auto const vertices_offset = 0u;
-	auto const vertices_size = static_cast<GLsizeiptr>(vertices.size() * sizeof(glm::vec3));
-	auto const positions_offset = vertices_size;
-	auto const positions_size = static_cast<GLsizeiptr>(positions.size() * sizeof(glm::vec2));
-	auto const velocities_offset = positions_offset + positions_size;
-	auto const velocities_size = static_cast<GLsizeiptr>(velocities.size() * sizeof(glm::vec2));
-	auto const bo_size = static_cast<GLsizeiptr>(vertices_size + positions_size +velocities_size);
-	glGenBuffers(1, &data.bo);
-	assert(data.bo != 0u);
-	glBindBuffer(GL_ARRAY_BUFFER, data.bo);
-	glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
-
-	glBufferSubData(GL_ARRAY_BUFFER, vertices_offset, vertices_size, static_cast<GLvoid const*>(vertices.data()));
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), reinterpret_cast<GLvoid const*>(0x0));
-
-	glBufferSubData(GL_ARRAY_BUFFER, positions_offset, positions_size, static_cast<GLvoid const*>(positions.data()));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), reinterpret_cast<GLvoid const*>(positions_offset));
-	glVertexAttribDivisor(1, 1);
-	glBufferSubData(GL_ARRAY_BUFFER, velocities_offset, velocities_size, static_cast<GLvoid const*>(velocities.data()));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), reinterpret_cast<GLvoid const*>(velocities_offset));
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0u);
-	glVertexAttribDivisor(1, 1);
-	glVertexAttribDivisor(2, 1);
-
-	data.indices_nb = static_cast<GLsizei>(index_sets.size() * 3u);
-	data.vertices_nb = vertices_nb;
-	glGenBuffers(1, &data.ibo);
-	assert(data.ibo != 0u);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(index_sets.size() * sizeof(glm::uvec3)), reinterpret_cast<GLvoid const*>(index_sets.data()), GL_STATIC_DRAW);
-
-	glBindVertexArray(0u);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
-
-	return data;
-}
-bonobo::mesh_data
-	parametric_shapes::createBriefCircleRingBatch3(float const radius,
-		float const spread_length,
-		unsigned int const circle_split_count,
-		unsigned int const spread_split_count, int particleNum, std::vector<glm::vec2>* positions, std::vector<glm::vec2>* velocities)
-{
-	auto const circle_slice_edges_count = circle_split_count + 1u;
-	auto const spread_slice_edges_count = spread_split_count + 1u;
-	auto const circle_slice_vertices_count = circle_slice_edges_count + 1u;
-	auto const spread_slice_vertices_count = spread_slice_edges_count + 1u;
-	auto const vertices_nb = circle_slice_vertices_count * spread_slice_vertices_count;
-
-	auto vertices = std::vector<glm::vec3>(vertices_nb);
-
-	float const spread_start = radius - 0.5f * spread_length;
-	float const d_theta = glm::two_pi<float>() / (static_cast<float>(circle_slice_edges_count));
-	float const d_spread = spread_length / (static_cast<float>(spread_slice_edges_count));
-
-	// generate vertices iteratively
-	size_t index = 0u;
-	float theta = 0.0f;
-	for (unsigned int i = 0u; i < circle_slice_vertices_count; ++i) {
-		float const cos_theta = std::cos(theta);
-		float const sin_theta = std::sin(theta);
-
-		float distance_to_centre = spread_start;
-		for (unsigned int j = 0u; j < spread_slice_vertices_count; ++j) {
-			// vertex
-			vertices[index] = glm::vec3(distance_to_centre * cos_theta,
-				distance_to_centre * sin_theta,
-				0.0f);
-			distance_to_centre += d_spread;
-			++index;
-		}
-
-		theta += d_theta;
-	}
-
-	// create index array
-	auto index_sets = std::vector<glm::uvec3>(2u * circle_slice_edges_count * spread_slice_edges_count);
-
-	// generate indices iteratively
-	index = 0u;
-	for (unsigned int i = 0u; i < circle_slice_edges_count; ++i)
-	{
-		for (unsigned int j = 0u; j < spread_slice_edges_count; ++j)
-		{
-			index_sets[index] = glm::uvec3(spread_slice_vertices_count * (i + 0u) + (j + 0u),
-				spread_slice_vertices_count * (i + 0u) + (j + 1u),
-				spread_slice_vertices_count * (i + 1u) + (j + 1u));
-			++index;
-
-			index_sets[index] = glm::uvec3(spread_slice_vertices_count * (i + 0u) + (j + 0u),
-				spread_slice_vertices_count * (i + 1u) + (j + 1u),
-				spread_slice_vertices_count * (i + 1u) + (j + 0u));
-			++index;
-		}
-	}
-
-	bonobo::mesh_data data;
-	glGenVertexArrays(1, &data.vao);
-	assert(data.vao != 0u);
-	glBindVertexArray(data.vao);
-
-	auto const vertices_offset = 0u;
-	auto const vertices_size = static_cast<GLsizeiptr>(vertices.size() * sizeof(glm::vec3));
-	auto const positions_offset = vertices_size;
-	auto const positions_size = static_cast<GLsizeiptr>(positions->size() * sizeof(glm::vec2));
-	auto const velocities_offset = positions_offset + positions_size;
-	auto const velocities_size = static_cast<GLsizeiptr>(velocities->size() * sizeof(glm::vec2));
-	auto const bo_size = static_cast<GLsizeiptr>(vertices_size + positions_size + velocities_size);
-	glGenBuffers(1, &data.bo);
-	assert(data.bo != 0u);
-	glBindBuffer(GL_ARRAY_BUFFER, data.bo);
-	glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
-
-	glBufferSubData(GL_ARRAY_BUFFER, vertices_offset, vertices_size, static_cast<GLvoid const*>(vertices.data()));
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), reinterpret_cast<GLvoid const*>(0x0));
-
-	glBufferSubData(GL_ARRAY_BUFFER, positions_offset, positions_size, static_cast<GLvoid const*>(positions->data()));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), reinterpret_cast<GLvoid const*>(positions_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, velocities_offset, velocities_size, static_cast<GLvoid const*>(velocities->data()));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), reinterpret_cast<GLvoid const*>(velocities_offset));
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0u);
-	glVertexAttribDivisor(1, 1);
-	glVertexAttribDivisor(2, 1);
-
-	data.indices_nb = static_cast<GLsizei>(index_sets.size() * 3u);
-	data.vertices_nb = vertices_nb;
-	glGenBuffers(1, &data.ibo);
-	assert(data.ibo != 0u);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(index_sets.size() * sizeof(glm::uvec3)), reinterpret_cast<GLvoid const*>(index_sets.data()), GL_STATIC_DRAW);
-
-	glBindVertexArray(0u);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
-
-	return data;
-}
-bonobo::mesh_data
-	parametric_shapes::createSphereBatch(float const radius,
-		unsigned int const longitude_split_count,
-		unsigned int const latitude_split_count, int particleNum, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities)
-{
-	//! \todo Implement this function
-	auto const longitude_slice_edges_count = longitude_split_count + 1u;
-	auto const latitude_slice_edges_count = latitude_split_count + 1u;
-	auto const longitude_slice_vertices_count = longitude_slice_edges_count + 1u;
-	auto const latitude_slice_vertices_count = latitude_slice_edges_count + 1u;
-	auto const vertices_nb = longitude_slice_vertices_count * latitude_slice_vertices_count;
-
-	auto vertices = std::vector<glm::vec3>(vertices_nb);
-
-	float const d_theta = glm::two_pi<float>() / (static_cast<float>(longitude_slice_edges_count));
-	float const d_phi = glm::pi<float>() / (static_cast<float>(latitude_slice_edges_count));
-
-	// generate vertices iteratively
-	size_t index = 0u;
-	float theta = 0.0f;
-	float phi = 0.0f;
-	for (unsigned int i = 0u; i < latitude_slice_vertices_count; ++i) {
-		float const cos_phi = std::cos(phi);
-		float const sin_phi = std::sin(phi);
-		theta = 0.0f;
-		for (unsigned int j = 0u; j < longitude_slice_vertices_count; ++j) {
-
-
-			float const cos_theta = std::cos(theta);
-			float const sin_theta = std::sin(theta);
-			// vertex
-			vertices[index] = glm::vec3(radius * sin_theta * sin_phi,
-				-radius * cos_phi,
-				radius * cos_theta * sin_phi);
-			++index;
-			theta += d_theta;
-		}
-
-		phi += d_phi;
-	}
-
-	// create index array
-	auto index_sets = std::vector<glm::uvec3>(2u * longitude_slice_vertices_count * latitude_slice_vertices_count);
-
-	// generate indices iterativelyyu
-	index = 0u;
-	for (unsigned int i = 0u; i <= latitude_slice_edges_count; ++i)
-	{
-		for (unsigned int j = 0u; j <= longitude_slice_edges_count; ++j)
-		{
-			index_sets[index] = glm::uvec3(longitude_slice_edges_count * (i + 0u) + (j + 0u),
-				longitude_slice_edges_count * (i + 0u) + (j + 1u),
-				longitude_slice_edges_count * (i + 1u) + (j + 1u));
-			++index;
-
-			index_sets[index] = glm::uvec3(longitude_slice_edges_count * (i + 0u) + (j + 0u),
-				longitude_slice_edges_count * (i + 1u) + (j + 1u),
-				longitude_slice_edges_count * (i + 1u) + (j + 0u));
-			++index;
-
-		}
-	}
-
-	bonobo::mesh_data data;
-	glGenVertexArrays(1, &data.vao);
-	assert(data.vao != 0u);
-	glBindVertexArray(data.vao);
-
-	auto const vertices_offset = 0u;
 	auto const vertices_size = static_cast<GLsizeiptr>(vertices.size() * sizeof(glm::vec3));
-	auto const positions_offset = vertices_size;
-	auto const positions_size = static_cast<GLsizeiptr>(positions.size() * sizeof(glm::vec3));
-	auto const velocities_offset = positions_offset + positions_size;
-	auto const velocities_size = static_cast<GLsizeiptr>(velocities.size() * sizeof(glm::vec3));
-	auto const bo_size = static_cast<GLsizeiptr>(vertices_size + positions_size + velocities_size);
-
 	glGenBuffers(1, &data.bo);
 	assert(data.bo != 0u);
 	glBindBuffer(GL_ARRAY_BUFFER, data.bo);
-	glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertices_size, static_cast<GLvoid const*>(vertices.data()), GL_STATIC_DRAW);
 
-	glBufferSubData(GL_ARRAY_BUFFER, vertices_offset, vertices_size, static_cast<GLvoid const*>(vertices.data()));
 	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::vertices));
 	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::vertices), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(0x0));
 
-	glBufferSubData(GL_ARRAY_BUFFER, positions_offset, positions_size, static_cast<GLvoid const*>(positions.data()));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), reinterpret_cast<GLvoid const*>(positions_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, velocities_offset, velocities_size, static_cast<GLvoid const*>(velocities.data()));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), reinterpret_cast<GLvoid const*>(velocities_offset));
-
 	glBindBuffer(GL_ARRAY_BUFFER, 0u);
-	glVertexAttribDivisor(1, 1);
-	glVertexAttribDivisor(2, 1);
 
 	data.indices_nb = static_cast<GLsizei>(index_sets.size() * 3u);
+	data.vertices_nb = vertices_nb;
 	glGenBuffers(1, &data.ibo);
 	assert(data.ibo != 0u);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.ibo);
@@ -902,13 +673,11 @@ bonobo::mesh_data
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
 
 	return data;
-
-	//return bonobo::mesh_data();
 }
 bonobo::mesh_data
-parametric_shapes::createSphereBatch2(float const radius,
-	unsigned int const longitude_split_count,
-	unsigned int const latitude_split_count, int particleNum, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities)
+parametric_shapes::createBriefSphere(float const radius,
+                                     unsigned int const longitude_split_count,
+                                     unsigned int const latitude_split_count)
 {
 
 	auto const longtitude_slice_edges_count = longitude_split_count;
@@ -982,34 +751,16 @@ parametric_shapes::createSphereBatch2(float const radius,
 	assert(data.vao != 0u);
 	glBindVertexArray(data.vao);
 
-	auto const vertices_offset = 0u;
 	auto const vertices_size = static_cast<GLsizeiptr>(vertices.size() * sizeof(glm::vec3));
-	auto const positions_offset = vertices_size;
-	auto const positions_size = static_cast<GLsizeiptr>(positions.size() * sizeof(glm::vec3));
-	auto const velocities_offset = positions_offset + positions_size;
-	auto const velocities_size = static_cast<GLsizeiptr>(velocities.size() * sizeof(glm::vec3));
-	auto const bo_size = static_cast<GLsizeiptr>(vertices_size + positions_size + velocities_size);
-
 	glGenBuffers(1, &data.bo);
 	assert(data.bo != 0u);
 	glBindBuffer(GL_ARRAY_BUFFER, data.bo);
-	glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertices_size, static_cast<GLvoid const*>(vertices.data()), GL_STATIC_DRAW);
 
-	glBufferSubData(GL_ARRAY_BUFFER, vertices_offset, vertices_size, static_cast<GLvoid const*>(vertices.data()));
 	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::vertices));
 	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::vertices), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(0x0));
 
-	glBufferSubData(GL_ARRAY_BUFFER, positions_offset, positions_size, static_cast<GLvoid const*>(positions.data()));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), reinterpret_cast<GLvoid const*>(positions_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, velocities_offset, velocities_size, static_cast<GLvoid const*>(velocities.data()));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), reinterpret_cast<GLvoid const*>(velocities_offset));
-
 	glBindBuffer(GL_ARRAY_BUFFER, 0u);
-	glVertexAttribDivisor(1, 1);
-	glVertexAttribDivisor(2, 1);
 
 	data.indices_nb = static_cast<GLsizei>(index_sets.size() * 3u);
 	data.vertices_nb = vertices_nb;
@@ -45,12 +45,15 @@ namespace parametric_shapes
 	bonobo::mesh_data createSphere(float const radius,
 	                               unsigned int const longitude_split_count,
 	                               unsigned int const latitude_split_count);
-	bonobo::mesh_data createSphereBatch(float const radius,
-		unsigned int const longitude_split_count,
-		unsigned int const latitude_split_count, int particleNum, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities);
-	bonobo::mesh_data createSphereBatch2(float const radius,
-		unsigned int const longitude_split_count,
-		unsigned int const latitude_split_count, int particleNum, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities);
+	//! \brief Create a sphere with positions only, as drawn once per
+	//!        particle.
+	//!
+	//! Only the vertex attribute 0 is set up, so that per-instance data
+	//! can be attached to the other ones, see |InstanceBuffer::attach()|.
+	//! The parameters are the same as for |createSphere()|.
+	bonobo::mesh_data createBriefSphere(float const radius,
+	                                    unsigned int const longitude_split_count,
+	                                    unsigned int const latitude_split_count);
 	//! \brief Create a torus for a given tesselation level and make it
 	//!        available to OpenGL.
 	//!
@@ -104,16 +107,14 @@ namespace parametric_shapes
 	                                   float const spread_length,
 	                                   unsigned int const circle_split_count,
 	                                   unsigned int const spread_split_count);
-	bonobo::mesh_data createBriefCircleRingBatch(float const radius,
-		float const spread_length,
-		unsigned int const circle_split_count,
-		unsigned int const spread_split_count, int particleNum, std::vector<glm::vec2> positions, std::vector<glm::vec2>& velocities);
-	bonobo::mesh_data createBriefCircleRingBatch2(float const radius,
-		float const spread_length,
-		unsigned int const circle_split_count,
-		unsigned int const spread_split_count, int particleNum, std::vector<glm::vec2>& positions, std::vector<glm::vec2>& velocities);
-	bonobo::mesh_data createBriefCircleRingBatch3(float const radius,
-		float const spread_length,
-		unsigned int const circle_split_count,
-		unsigned int const spread_split_count, int particleNum, std::vector<glm::vec2>* positions, std::vector<glm::vec2>* velocities);
+	//! \brief Create a circle ring with positions only, as drawn once per
+	//!        particle.
+	//!
+	//! Only the vertex attribute 0 is set up, so that per-instance data
+	//! can be attached to the other ones, see |InstanceBuffer::attach()|.
+	//! The parameters are the same as for |createCircleRing()|.
+	bonobo::mesh_data createBriefCircleRing(float const radius,
+	                                        float const spread_length,
+	                                        unsigned int const circle_split_count,
+	                                        unsigned int const spread_split_count);
 }
@@ -0,0 +1,344 @@
+#include "core/Bonobo.h"
+#include "core/FPSCamera.h"
+#include "core/GpuPrimitives.hpp"
+#include "core/InputHandler.h"
+#include "core/ShaderProgramManager.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//! Micro-benchmarks of the GPU primitives of core/GpuPrimitives.hpp.
+//!
+//! Every primitive runs on random inputs of 1Ki to 16Mi elements (by
+//! powers of 4); its result is checked once against a CPU reference, then
+//! its GPU time is measured with GL_TIME_ELAPSED queries and the median is
+//! reported together with the throughput, counting the bytes each
+//! primitive has to read and write at least once.
+
+namespace
+{
+	struct Options {
+		std::uint32_t min_size = 1u << 10;
+		std::uint32_t max_size = 1u << 24;
+		std::uint32_t repetitions = 10u;
+		std::string csv_path;
+		std::vector<std::string> filters;
+	};
+
+	struct Measurement {
+		double milliseconds = 0.0;
+		double bytes = 0.0;
+		bool correct = false;
+	};
+
+	//! \brief Benchmark of one primitive at one size: |prepare| (re)sets
+	//!        the inputs and is not timed, |run| is, and |check| compares
+	//!        the outputs with the CPU reference after the first run.
+	struct Benchmark {
+		std::string name;
+		std::function<void()> prepare;
+		std::function<void()> run;
+		std::function<bool()> check;
+		double bytes;
+	};
+
+	GLuint create_buffer(std::size_t size, void const* data)
+	{
+		GLuint buffer = 0u;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(std::max<std::size_t>(size, 4u)), data, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u);
+		return buffer;
+	}
+
+	template<typename T>
+	void upload(GLuint buffer, std::vector<T> const& data)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(data.size() * sizeof(T)), data.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u);
+	}
+
+	template<typename T>
+	std::vector<T> download(GLuint buffer, std::size_t count)
+	{
+		std::vector<T> data(count);
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(count * sizeof(T)), data.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u);
+		return data;
+	}
+
+	Measurement measure(Benchmark const& benchmark, std::uint32_t repetitions, GLuint query)
+	{
+		Measurement measurement;
+		measurement.bytes = benchmark.bytes;
+
+		// The first run also pays for the allocation of the scratch
+		// buffers, and is the one checked.
+		benchmark.prepare();
+		benchmark.run();
+		measurement.correct = benchmark.check();
+
+		std::vector<double> timings;
+		for (std::uint32_t i = 0u; i < repetitions; ++i) {
+			benchmark.prepare();
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			benchmark.run();
+			glEndQuery(GL_TIME_ELAPSED);
+			GLuint64 elapsed = 0u;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+			timings.push_back(elapsed / 1.0e6);
+		}
+		std::nth_element(timings.begin(), timings.begin() + timings.size() / 2, timings.end());
+		measurement.milliseconds = timings[timings.size() / 2];
+		return measurement;
+	}
+
+	std::string size_label(std::uint32_t size)
+	{
+		if (size >= (1u << 20))
+			return std::to_string(size >> 20) + "Mi";
+		if (size >= (1u << 10))
+			return std::to_string(size >> 10) + "Ki";
+		return std::to_string(size);
+	}
+
+	void print_usage(char const* program)
+	{
+		std::cout << "Usage: " << program << " [options] [primitive...]\n"
+		          << "  --min-size N          smallest element count (default 1024)\n"
+		          << "  --max-size N          largest element count (default 16777216)\n"
+		          << "  --repetitions N       timed runs per size, the median is reported (default 10)\n"
+		          << "  --csv FILE            also write the results as CSV\n"
+		          << "Primitives: scan radix_sort compact segmented_reduce histogram" << std::endl;
+	}
+
+	Options parse_options(int argc, char* argv[])
+	{
+		Options options;
+		for (int i = 1; i < argc; ++i) {
+			std::string const option = argv[i];
+			bool const has_value = i + 1 < argc;
+			if (option == "--min-size" && has_value)
+				options.min_size = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+			else if (option == "--max-size" && has_value)
+				options.max_size = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+			else if (option == "--repetitions" && has_value)
+				options.repetitions = std::max(1u, static_cast<std::uint32_t>(std::stoul(argv[++i])));
+			else if (option == "--csv" && has_value)
+				options.csv_path = argv[++i];
+			else if (option.compare(0, 2, "--") != 0)
+				options.filters.push_back(option);
+			else
+				throw std::invalid_argument("Unknown option " + option);
+		}
+		if (options.min_size == 0u || options.min_size > options.max_size)
+			throw std::invalid_argument("Invalid size range");
+		return options;
+	}
+
+	int run(Options const& options, GpuPrimitives& primitives)
+	{
+		std::ofstream csv;
+		if (!options.csv_path.empty()) {
+			csv.open(options.csv_path);
+			if (!csv)
+				throw std::runtime_error("Failed to create " + options.csv_path);
+			csv << "primitive,elements,milliseconds,gigabytes_per_second,million_elements_per_second,correct\n";
+		}
+
+		GLuint query = 0u;
+		glGenQueries(1, &query);
+		std::mt19937 generator(1u);
+
+		bool all_correct = true;
+		std::cout << std::left << std::setw(18) << "primitive" << std::right << std::setw(8) << "size"
+		          << std::setw(12) << "ms" << std::setw(10) << "GB/s" << std::setw(12) << "Melem/s" << "  check" << std::endl;
+		for (std::uint64_t size64 = options.min_size; size64 <= options.max_size; size64 *= 4u) {
+			auto const size = static_cast<std::uint32_t>(size64);
+
+			std::uniform_int_distribution<std::uint32_t> any_key;
+			std::vector<std::uint32_t> keys(size), values(size), flags(size);
+			std::vector<float> floats(size);
+			std::uniform_real_distribution<float> any_float(-1.0f, 1.0f);
+			for (std::uint32_t i = 0u; i < size; ++i) {
+				keys[i] = any_key(generator);
+				values[i] = i;
+				flags[i] = keys[i] % 3u == 0u ? 1u : 0u;
+				floats[i] = any_float(generator);
+			}
+			// Segments of 1 to 512 elements.
+			std::vector<std::uint32_t> segment_offsets(1u, 0u);
+			std::uniform_int_distribution<std::uint32_t> segment_length(1u, 512u);
+			while (segment_offsets.back() < size)
+				segment_offsets.push_back(std::min(size, segment_offsets.back() + segment_length(generator)));
+			auto const segment_count = static_cast<std::uint32_t>(segment_offsets.size() - 1u);
+			std::uint32_t const bin_count = 256u, key_shift = 24u;
+
+			auto const key_buffer = create_buffer(size * sizeof(GLuint), keys.data());
+			auto const value_buffer = create_buffer(size * sizeof(GLuint), values.data());
+			auto const flag_buffer = create_buffer(size * sizeof(GLuint), flags.data());
+			auto const float_buffer = create_buffer(size * sizeof(GLfloat), floats.data());
+			auto const offset_buffer = create_buffer(segment_offsets.size() * sizeof(GLuint), segment_offsets.data());
+			auto const output_buffer = create_buffer(size * sizeof(GLuint), nullptr);
+			auto const count_buffer = create_buffer(sizeof(GLuint), nullptr);
+
+			std::vector<Benchmark> const benchmarks = {
+				{ "scan",
+				  []() {},
+				  [&]() { primitives.exclusive_scan(key_buffer, output_buffer, size); },
+				  [&]() {
+					  auto const result = download<std::uint32_t>(output_buffer, size);
+					  std::uint32_t sum = 0u;
+					  for (std::uint32_t i = 0u; i < size; sum += keys[i], ++i)
+						  if (result[i] != sum)
+							  return false;
+					  return true;
+				  },
+				  2.0 * size * sizeof(GLuint) },
+				{ "radix_sort",
+				  [&]() { upload(key_buffer, keys); upload(value_buffer, values); },
+				  [&]() { primitives.radix_sort(key_buffer, value_buffer, size); },
+				  [&]() {
+					  auto const sorted_keys = download<std::uint32_t>(key_buffer, size);
+					  auto const sorted_values = download<std::uint32_t>(value_buffer, size);
+					  std::vector<std::uint32_t> order(values);
+					  std::stable_sort(order.begin(), order.end(), [&keys](std::uint32_t a, std::uint32_t b) { return keys[a] < keys[b]; });
+					  for (std::uint32_t i = 0u; i < size; ++i)
+						  if (sorted_values[i] != order[i] || sorted_keys[i] != keys[order[i]])
+							  return false;
+					  return true;
+				  },
+				  4.0 * 4.0 * size * sizeof(GLuint) },
+				{ "compact",
+				  []() {},
+				  [&]() { primitives.compact(value_buffer, flag_buffer, output_buffer, count_buffer, size); },
+				  [&]() {
+					  std::vector<std::uint32_t> expected;
+					  for (std::uint32_t i = 0u; i < size; ++i)
+						  if (flags[i] != 0u)
+							  expected.push_back(values[i]);
+					  auto const kept = download<std::uint32_t>(count_buffer, 1u)[0];
+					  return kept == expected.size() && download<std::uint32_t>(output_buffer, kept) == expected;
+				  },
+				  (2.0 * size + size / 3.0) * sizeof(GLuint) },
+				{ "segmented_reduce",
+				  []() {},
+				  [&]() { primitives.segmented_reduce(float_buffer, offset_buffer, output_buffer, segment_count); },
+				  [&]() {
+					  auto const sums = download<float>(output_buffer, segment_count);
+					  for (std::uint32_t s = 0u; s < segment_count; ++s) {
+						  float expected = 0.0f;
+						  for (auto i = segment_offsets[s]; i < segment_offsets[s + 1u]; ++i)
+							  expected += floats[i];
+						  if (std::abs(sums[s] - expected) > 1.0e-3f * (segment_offsets[s + 1u] - segment_offsets[s]))
+							  return false;
+					  }
+					  return true;
+				  },
+				  (size + 2.0 * segment_count) * sizeof(GLuint) },
+				{ "histogram",
+				  []() {},
+				  [&]() { primitives.histogram(key_buffer, output_buffer, size, bin_count, key_shift); },
+				  [&]() {
+					  std::vector<std::uint32_t> expected(bin_count, 0u);
+					  for (auto const key : keys)
+						  ++expected[key >> key_shift];
+					  return download<std::uint32_t>(output_buffer, bin_count) == expected;
+				  },
+				  static_cast<double>(size) * sizeof(GLuint) },
+			};
+
+			for (auto const& benchmark : benchmarks) {
+				if (!options.filters.empty()
+				    && std::find(options.filters.begin(), options.filters.end(), benchmark.name) == options.filters.end())
+					continue;
+				// The radix sort leaves the pairs sorted; restore them for
+				// the primitives reading them afterwards.
+				upload(key_buffer, keys);
+				upload(value_buffer, values);
+				auto const measurement = measure(benchmark, options.repetitions, query);
+				all_correct = all_correct && measurement.correct;
+
+				double const seconds = measurement.milliseconds / 1000.0;
+				double const gigabytes_per_second = seconds > 0.0 ? measurement.bytes / seconds / 1.0e9 : 0.0;
+				double const elements_per_second = seconds > 0.0 ? size / seconds / 1.0e6 : 0.0;
+				std::cout << std::left << std::setw(18) << benchmark.name << std::right << std::setw(8) << size_label(size)
+				          << std::fixed << std::setprecision(3) << std::setw(12) << measurement.milliseconds
+				          << std::setprecision(1) << std::setw(10) << gigabytes_per_second << std::setw(12) << elements_per_second
+				          << "  " << (measurement.correct ? "ok" : "MISMATCH") << std::endl;
+				if (csv)
+					csv << benchmark.name << "," << size << "," << measurement.milliseconds << "," << gigabytes_per_second
+					    << "," << elements_per_second << "," << (measurement.correct ? 1 : 0) << "\n";
+			}
+
+			GLuint const buffers[] = { key_buffer, value_buffer, flag_buffer, float_buffer, offset_buffer, output_buffer, count_buffer };
+			glDeleteBuffers(static_cast<GLsizei>(sizeof(buffers) / sizeof(buffers[0])), buffers);
+		}
+
+		glDeleteQueries(1, &query);
+		return all_correct ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::setlocale(LC_ALL, "");
+
+	Options options;
+	try {
+		options = parse_options(argc, argv);
+	}
+	catch (std::exception const& e) {
+		std::cerr << e.what() << std::endl;
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	Bonobo framework;
+
+	// A hidden window provides the OpenGL context.
+	InputHandler input_handler;
+	FPSCameraf camera(0.5f * glm::half_pi<float>(), 1.0f, 0.01f, 1000.0f);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	WindowManager::WindowDatum window_datum{ input_handler, camera, 64, 64, 0, 0, 0, 0 };
+	auto& window_manager = framework.GetWindowManager();
+	GLFWwindow* window = window_manager.CreateGLFWWindow("EDAN35: primitives benchmark", window_datum, 1u);
+	if (window == nullptr) {
+		LogError("No OpenGL context available.");
+		return EXIT_FAILURE;
+	}
+
+	int status = EXIT_FAILURE;
+	{
+		ShaderProgramManager program_manager;
+		GpuPrimitives primitives(program_manager);
+		if (!primitives.is_valid())
+			LogError("Some of the primitives failed to build.");
+		else {
+			try {
+				status = run(options, primitives);
+			}
+			catch (std::runtime_error const& e) {
+				LogError(e.what());
+			}
+		}
+	}
+	window_manager.DestroyWindow(window);
+	return status;
+}
@@ -2,11 +2,18 @@
 #include "parametric_shapes.hpp"
 
 #include "config.hpp"
+#include "core/AsyncReadback.hpp"
 #include "core/Bonobo.h"
+#include "core/BufferInspector.hpp"
 #include "core/FPSCamera.h"
+#include "core/InstanceBuffer.hpp"
 #include "core/node.hpp"
 #include "core/helpers.hpp"
+#include "core/opengl.hpp"
 #include "core/ShaderProgramManager.hpp"
+#include "core/WorkGroupTuner.hpp"
+#include "sph_cluster.hpp"
+#include "sph_shader.hpp"
 
 #include <imgui.h>
 #include <tinyfiledialogs.h>
@@ -15,8 +22,10 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <array>
 #include <clocale>
+#include <cstddef>
 #include <cstdlib>
 #include <stdexcept>
 #include <random>
@@ -303,14 +312,19 @@ edaf80::project::run()
 	//for (int i = 0; i < 100; i++) {
 	//	velocities[i] += glm::vec2(5.0f, 0.0f);
 	//}
-	//auto const shape = parametric_shapes::createBriefCircleRingBatch3(particleRadius, particleRadius * 2, 10u, 2u, spawner.particleCount, &positions, &velocities);
-	auto const shape = parametric_shapes::createBriefCircleRingBatch2(particleRadius, particleRadius * 2, 10u, 2u, spawner.particleCount, positions, velocities);
+	auto const shape = parametric_shapes::createBriefCircleRing(particleRadius, particleRadius * 2, 10u, 2u);
 	//for (int i = 0; i < 100; i++) {
 	//	positions[i] += glm::vec2(1.0f, 0.0f);
 	//}
 	auto circle = Node();
 	circle.set_geometry(shape);
 	circle.set_program(&fallback_shader, set_uniforms);
+	// Positions and velocities of the particles, uploaded once per frame
+	// and read by every periodic image drawn.
+	InstanceBuffer particle_instances({ { 1u, InstanceBuffer::AttributeType::vec2 },
+	                                    { 2u, InstanceBuffer::AttributeType::vec2 } },
+	                                  spawner.particleCount);
+	particle_instances.attach(shape);
 	circle.get_transform().SetTranslate(glm::vec3(0.0f, 0.0f, 0.0f));
 	TRSTransformf& circle_rings_transform_ref = circle.get_transform();
 
@@ -357,14 +371,101 @@ edaf80::project::run()
 	glBufferData(GL_SHADER_STORAGE_BUFFER, particles.size() * sizeof(particleParameter), particles.data(), GL_DYNAMIC_DRAW);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleBuffer);
 
-	std::string computeShaderSource = readFile("F:/desktop/CourseFile/ComputerGraphics/src/EDAF80/computeShader5.glsl");
-	if (computeShaderSource.empty()) {
-		std::cerr << "Failed to read compute shader source file." << std::endl;
-		return;
-	}
-	GLuint computeProgram = createComputeShaderProgram(computeShaderSource);
+	// Activity tracking: per-particle count of consecutive settled steps,
+	// double-buffered cell flags set by moving particles, and the number of
+	// awake particles (one slot per frame parity, so that the count read
+	// back is the one of the previous step).
+	std::vector<GLuint> const sleep_counters(spawner.particleCount, 0u);
+	GLuint sleepCounterBuffer;
+	glGenBuffers(1, &sleepCounterBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, sleepCounterBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sleep_counters.size() * sizeof(GLuint), sleep_counters.data(), GL_DYNAMIC_COPY);
+	utils::opengl::debug::nameObject(GL_BUFFER, sleepCounterBuffer, "Particle sleep counters");
+
+	GLuint activityCellBuffer;
+	glGenBuffers(1, &activityCellBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityCellBuffer);
+	utils::opengl::debug::nameObject(GL_BUFFER, activityCellBuffer, "Particle activity cells");
+	GLuint activity_cell_capacity = 0u;
+
+	GLuint const active_particle_slots[2] = { 0u, 0u };
+	GLuint activityCounterBuffer;
+	glGenBuffers(1, &activityCounterBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityCounterBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(active_particle_slots), active_particle_slots, GL_DYNAMIC_COPY);
+	utils::opengl::debug::nameObject(GL_BUFFER, activityCounterBuffer, "Active particle counters");
+	GLuint activity_parity = 0u;
+	GLuint active_particles = spawner.particleCount;
+	AsyncReadback active_particles_readback(sizeof(GLuint));
+
+	// Verlet neighbour lists: a reference position and candidate count per
+	// particle (16 bytes in std430), up to maxNeighbours indices per particle
+	// (allocated on first use), and the rebuild statistics, one entry per
+	// frame parity.
+	struct NeighbourListStats {
+		GLuint rebuildRequested;
+		GLuint rebuilt;
+		GLuint overflowCount;
+		GLuint padding;
+	};
+	GLsizeiptr const neighbour_state_size = 4 * sizeof(GLuint);
+	GLuint neighbourStateBuffer;
+	glGenBuffers(1, &neighbourStateBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, neighbourStateBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, spawner.particleCount * neighbour_state_size, nullptr, GL_DYNAMIC_COPY);
+	utils::opengl::debug::nameObject(GL_BUFFER, neighbourStateBuffer, "Neighbour list states");
+
+	GLuint neighbourIndexBuffer;
+	glGenBuffers(1, &neighbourIndexBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, neighbourIndexBuffer);
+	utils::opengl::debug::nameObject(GL_BUFFER, neighbourIndexBuffer, "Neighbour list indices");
+	GLuint neighbour_list_capacity = 0u;
+
+	NeighbourListStats const cleared_neighbour_stats[2] = {};
+	GLuint neighbourStatsBuffer;
+	glGenBuffers(1, &neighbourStatsBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, neighbourStatsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(cleared_neighbour_stats), cleared_neighbour_stats, GL_DYNAMIC_COPY);
+	utils::opengl::debug::nameObject(GL_BUFFER, neighbourStatsBuffer, "Neighbour list statistics");
+	AsyncReadback neighbour_stats_readback(sizeof(NeighbourListStats));
+
+	bool neighbour_lists_valid = false;
+	float neighbour_lists_skin = 0.0f;
+	GLuint neighbour_overflows = 0u;
+	unsigned int neighbour_rebuilds = 0u, neighbour_steps = 0u;
+	float neighbour_stats_time = 0.0f;
+	float neighbour_rebuild_rate = 0.0f, neighbour_steps_per_rebuild = 0.0f;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleBuffer);
+
+	// Every configuration of the SPH step is its own program, built the
+	// first time it gets selected; a variant failing to build keeps the
+	// previous one running.
+	sph_shader::VariantCache sph_variants(program_manager);
+	WorkGroupTuner work_group_tuner("work_group_sizes.txt");
+
+	// Statistics and samples of the particles, read back asynchronously
+	// instead of mapping the whole buffer.
+	BufferInspector buffer_inspector(program_manager);
+	buffer_inspector.register_buffer("Particles", particleBuffer, sizeof(particleParameter), static_cast<std::uint32_t>(particles.size()), {
+		{ "Position", offsetof(particleParameter, position), 2u },
+		{ "Velocity", offsetof(particleParameter, velocity), 2u },
+		{ "Predicted position", offsetof(particleParameter, predictedPosition), 2u },
+		{ "Density", offsetof(particleParameter, density), 2u },
+	});
+	auto const selected_sph_variant = [this]() {
+		sph_shader::Variant variant;
+		variant.dimensions = 2u;
+		variant.kernel = static_cast<sph_shader::Kernel>(sphKernel);
+		variant.particle_capacity = spawner.particleCount;
+		variant.viscosity = sphViscosity;
+		variant.interaction = sphInteraction;
+		variant.obstacles = sphObstacles;
+		return variant;
+	};
+	auto sph_variant = selected_sph_variant();
+	GLuint computeProgram = sph_variants.get(sph_variant);
 	if (computeProgram == 0) {
-		std::cerr << "Failed to create compute shader program." << std::endl;
+		LogError("Failed to create the SPH compute program");
 		return;
 	}
 	////calculation part
@@ -464,6 +565,10 @@ edaf80::project::run()
 	int frameCount = 0;
 	auto polygon_mode = bonobo::polygon_mode_t::fill;
 
+	sph_cluster::ViewerClient cluster_viewer;
+	sph_cluster::Snapshot cluster_snapshot;
+	int rendered_particles = spawner.particleCount;
+
 
 
 
@@ -511,6 +616,8 @@ edaf80::project::run()
 					"Rendering is suspended until the issue is solved. Once fixed, just reload the shaders again.",
 					"error");
 		}
+		if (program_manager.PollHotReload())
+			shader_reload_failed = false;
 		if (inputHandler.GetKeycodeState(GLFW_KEY_F3) & JUST_RELEASED)
 			show_logs = !show_logs;
 		if (inputHandler.GetKeycodeState(GLFW_KEY_F2) & JUST_RELEASED)
@@ -557,41 +664,183 @@ edaf80::project::run()
 			//}
 			//glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, positionBuffer);
 			//glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, velocityBuffer);
-			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleBuffer);
-			glUseProgram(computeProgram);
-			glUniform1f(glGetUniformLocation(computeProgram, "collisionDamping") , collisionDamping);
-			glUniform1f(glGetUniformLocation(computeProgram, "gravity"), gravity);
-			glUniform1f(glGetUniformLocation(computeProgram, "particleRadius"), particleRadius);
-			glUniform1f(glGetUniformLocation(computeProgram, "deltaTime"), float_deltaTime);
-			glUniform2fv(glGetUniformLocation(computeProgram, "boundsSize"), 1, glm::value_ptr(boundsSize));
-
-			glUniform1i(glGetUniformLocation(computeProgram, "numParticles"), particlesNum);
-			glUniform1f(glGetUniformLocation(computeProgram, "smoothingRadius"), smoothingRadius);
-			glUniform1f(glGetUniformLocation(computeProgram, "targetDensity"), targetDensity);
-			glUniform1f(glGetUniformLocation(computeProgram, "pressureMultiplier"), pressureMultiplier);
-			glUniform1f(glGetUniformLocation(computeProgram, "nearPressureMultiplier"), nearPressureMultiplier);
-			glUniform1f(glGetUniformLocation(computeProgram, "viscosityStrength"), viscosityStrength);
-
-			glUniform1f(glGetUniformLocation(computeProgram, "interactionInputRadius"), interactionRadius);
-			glUniform1f(glGetUniformLocation(computeProgram, "interactionInputStrength"), interactionStrength);
-			glUniform2fv(glGetUniformLocation(computeProgram, "interactionInputPoint"), 1, glm::value_ptr(mousePos));
-			glDispatchCompute(100, 1, 1);
-			//glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-			glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, particles.size() * sizeof(particleParameter), particles.data());
-			for (int i = 0; i < spawner.particleCount; i++) {
-				positions[i] = particles[i].position;
-				velocities[i] = particles[i].velocity;
+			// While attached to a CPU cluster run the GPU solver is paused and
+			// the particles are those of the latest snapshot received.
+			bool const cluster_attached = cluster_viewer.is_connected();
+			if (cluster_attached && cluster_viewer.poll(cluster_snapshot)) {
+				rendered_particles = static_cast<int>(std::min<std::size_t>(cluster_snapshot.positions.size(), positions.size()));
+				std::copy_n(cluster_snapshot.positions.begin(), rendered_particles, positions.begin());
+				std::copy_n(cluster_snapshot.velocities.begin(), rendered_particles, velocities.begin());
+			}
+			if (!cluster_attached) {
+				rendered_particles = spawner.particleCount;
+				auto const activity_grid_size = glm::ivec2(glm::ceil(boundsSize / activityCellSize)) + 1;
+				auto const activity_cell_count = static_cast<GLuint>(activity_grid_size.x * activity_grid_size.y);
+				if (activity_cell_count > activity_cell_capacity) {
+					activity_cell_capacity = activity_cell_count;
+					std::vector<GLuint> const cleared_cells(2u * activity_cell_capacity, 0u);
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityCellBuffer);
+					glBufferData(GL_SHADER_STORAGE_BUFFER, cleared_cells.size() * sizeof(GLuint), cleared_cells.data(), GL_DYNAMIC_COPY);
+				}
+				GLuint const activity_write_offset = activity_parity * activity_cell_capacity;
+				GLuint const activity_read_offset = (1u - activity_parity) * activity_cell_capacity;
+				GLuint const zero = 0u;
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityCellBuffer);
+				glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, activity_write_offset * sizeof(GLuint), activity_cell_capacity * sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityCounterBuffer);
+				glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, activity_parity * sizeof(GLuint), sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+				bool force_neighbour_rebuild = false;
+				if (useNeighbourList) {
+					if (neighbour_list_capacity != static_cast<GLuint>(maxNeighbours)) {
+						neighbour_list_capacity = static_cast<GLuint>(maxNeighbours);
+						glBindBuffer(GL_SHADER_STORAGE_BUFFER, neighbourIndexBuffer);
+						glBufferData(GL_SHADER_STORAGE_BUFFER, spawner.particleCount * neighbour_list_capacity * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+						neighbour_lists_valid = false;
+					}
+					force_neighbour_rebuild = !neighbour_lists_valid || neighbour_lists_skin != neighbourSkin;
+					neighbour_lists_valid = true;
+					neighbour_lists_skin = neighbourSkin;
+				}
+				else {
+					neighbour_lists_valid = false;
+				}
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, neighbourStatsBuffer);
+				glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, activity_parity * sizeof(NeighbourListStats), sizeof(NeighbourListStats), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, neighbourStatsBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, neighbourStateBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, neighbourIndexBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sleepCounterBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, activityCellBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, activityCounterBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleBuffer);
+				// The uniforms are shared by the simulation step and the
+				// work-group size measurements, which run it with a zero
+				// time step on scratch copies of every buffer it writes to.
+				auto const set_sph_uniforms = [&](GLuint program, float delta_time) {
+					glUniform1f(glGetUniformLocation(program, "collisionDamping") , collisionDamping);
+					glUniform1f(glGetUniformLocation(program, "gravity"), gravity);
+					glUniform1f(glGetUniformLocation(program, "particleRadius"), particleRadius);
+					glUniform1f(glGetUniformLocation(program, "deltaTime"), delta_time);
+					glUniform2fv(glGetUniformLocation(program, "boundsSize"), 1, glm::value_ptr(boundsSize));
+
+					glUniform1f(glGetUniformLocation(program, "smoothingRadius"), smoothingRadius);
+					glUniform1f(glGetUniformLocation(program, "targetDensity"), targetDensity);
+					glUniform1f(glGetUniformLocation(program, "pressureMultiplier"), pressureMultiplier);
+					glUniform1f(glGetUniformLocation(program, "nearPressureMultiplier"), nearPressureMultiplier);
+					glUniform1f(glGetUniformLocation(program, "viscosityStrength"), viscosityStrength);
+
+					glUniform1f(glGetUniformLocation(program, "interactionInputRadius"), interactionRadius);
+					glUniform1f(glGetUniformLocation(program, "interactionInputStrength"), interactionStrength);
+					glUniform2fv(glGetUniformLocation(program, "interactionInputPoint"), 1, glm::value_ptr(mousePos));
+					glUniform2iv(glGetUniformLocation(program, "periodicAxes"), 1, glm::value_ptr(periodicAxes));
+					glUniform1i(glGetUniformLocation(program, "enableSleeping"), enableSleeping ? 1 : 0);
+					glUniform1f(glGetUniformLocation(program, "sleepVelocityThreshold"), sleepVelocityThreshold);
+					glUniform1f(glGetUniformLocation(program, "sleepDensityThreshold"), sleepDensityThreshold);
+					glUniform1ui(glGetUniformLocation(program, "sleepFrameCount"), static_cast<GLuint>(sleepFrameCount));
+					glUniform1f(glGetUniformLocation(program, "activityCellSize"), activityCellSize);
+					glUniform2iv(glGetUniformLocation(program, "activityGridSize"), 1, glm::value_ptr(activity_grid_size));
+					glUniform1ui(glGetUniformLocation(program, "activityReadOffset"), activity_read_offset);
+					glUniform1ui(glGetUniformLocation(program, "activityWriteOffset"), activity_write_offset);
+					glUniform1ui(glGetUniformLocation(program, "activityCounterSlot"), activity_parity);
+					glUniform1i(glGetUniformLocation(program, "useNeighbourList"), useNeighbourList ? 1 : 0);
+					glUniform1i(glGetUniformLocation(program, "forceNeighbourRebuild"), force_neighbour_rebuild ? 1 : 0);
+					glUniform1f(glGetUniformLocation(program, "neighbourSkin"), neighbourSkin);
+					glUniform1ui(glGetUniformLocation(program, "maxNeighbours"), neighbour_list_capacity);
+					glUniform1ui(glGetUniformLocation(program, "neighbourReadSlot"), 1u - activity_parity);
+					glUniform1ui(glGetUniformLocation(program, "neighbourWriteSlot"), activity_parity);
+					glUniform2fv(glGetUniformLocation(program, "obstacleCentre"), 1, glm::value_ptr(obstacleCentre));
+					glUniform2fv(glGetUniformLocation(program, "obstacleSize"), 1, glm::value_ptr(obstacleSize));
+				};
+				auto requested_sph_variant = selected_sph_variant();
+				requested_sph_variant.work_group_size = work_group_tuner.select(requested_sph_variant.kernel_name(), sph_shader::Variant::work_group_size_candidates(),
+					[&](std::uint32_t work_group_size) {
+						auto variant = requested_sph_variant;
+						variant.work_group_size = work_group_size;
+						return sph_variants.get(variant);
+					},
+					[&](GLuint program, std::uint32_t work_group_size) {
+						glUseProgram(program);
+						set_sph_uniforms(program, 0.0f);
+						glDispatchCompute((requested_sph_variant.particle_capacity + work_group_size - 1u) / work_group_size, 1, 1);
+						glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+					},
+					{ 0u, 1u, 2u, 3u, 5u, 6u, 7u });
+				auto const requested_program = sph_variants.get(requested_sph_variant);
+				if (requested_program != 0u) {
+					sph_variant = requested_sph_variant;
+					computeProgram = requested_program;
+				}
+				glUseProgram(computeProgram);
+				set_sph_uniforms(computeProgram, float_deltaTime);
+				glDispatchCompute(sph_variant.work_group_count(), 1, 1);
+				//glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleBuffer);
+				glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, particles.size() * sizeof(particleParameter), particles.data());
+				for (int i = 0; i < spawner.particleCount; i++) {
+					positions[i] = particles[i].position;
+					velocities[i] = particles[i].velocity;
+				}
+				//test
+				//std::cout << velocities[100] << std::endl;
+				//glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, positions.size() * sizeof(glm::vec2), velocities.size() * sizeof(glm::vec2), velocities.data());
+				//glDeleteBuffers(1, &buffer);
+				//glDeleteProgram(computeProgram);
+				glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+				// The count of the step just issued is picked up once the GPU is
+				// done with it, so the value shown lags a frame or two behind.
+				active_particles_readback.request(activityCounterBuffer, activity_parity * sizeof(GLuint), sizeof(GLuint));
+				active_particles_readback.poll(&active_particles);
+				if (useNeighbourList) {
+					// Statistics are collected the same way, and the rates computed
+					// over the steps whose statistics came back.
+					if (neighbour_stats_readback.request(neighbourStatsBuffer, activity_parity * sizeof(NeighbourListStats), sizeof(NeighbourListStats)))
+						neighbour_stats_time += float_deltaTime;
+					NeighbourListStats finished_stats;
+					while (neighbour_stats_readback.poll(&finished_stats)) {
+						if (finished_stats.rebuilt != 0u) {
+							++neighbour_rebuilds;
+							neighbour_overflows = finished_stats.overflowCount;
+						}
+						++neighbour_steps;
+					}
+					if (neighbour_stats_time >= 1.0f) {
+						neighbour_rebuild_rate = neighbour_rebuilds / neighbour_stats_time;
+						neighbour_steps_per_rebuild = neighbour_steps / static_cast<float>(std::max(neighbour_rebuilds, 1u));
+						neighbour_rebuilds = 0u;
+						neighbour_steps = 0u;
+						neighbour_stats_time = 0.0f;
+					}
+				}
+				else {
+					neighbour_stats_readback.discard();
+				}
+				activity_parity = 1u - activity_parity;
+				glUseProgram(0);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0u);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, 0u);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, 0u);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, 0u);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, 0u);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0u);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0u);
+				//glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0u);
+			}
+
+			particle_instances.update(0u, positions.data(), rendered_particles);
+			particle_instances.update(1u, velocities.data(), rendered_particles);
+			circle.render_instanced(mCamera.GetWorldToClipMatrix(), particle_instances);
+			if (showPeriodicImages && (periodicAxes.x != 0 || periodicAxes.y != 0)) {
+				// Draw the neighbouring periodic images of the domain, so that
+				// particles leaving through one wall are seen entering again.
+				for (int y = -periodicAxes.y; y <= periodicAxes.y; ++y) {
+					for (int x = -periodicAxes.x; x <= periodicAxes.x; ++x) {
+						if (x == 0 && y == 0)
+							continue;
+						auto const image_offset = glm::vec3(glm::vec2(x, y) * boundsSize, 0.0f);
+						circle.render_instanced(mCamera.GetWorldToClipMatrix(), particle_instances, glm::translate(glm::mat4(1.0f), image_offset));
+					}
+				}
 			}
-			//test
-			//std::cout << velocities[100] << std::endl;
-			//glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, positions.size() * sizeof(glm::vec2), velocities.size() * sizeof(glm::vec2), velocities.data());
-			//glDeleteBuffers(1, &buffer);
-			//glDeleteProgram(computeProgram);
-			glUseProgram(0);
-			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0u);
-			//glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0u);
-
-			circle.render(mCamera.GetWorldToClipMatrix(),spawner.particleCount, positions, velocities);
 			//up_boundary_node.render(mCamera.GetWorldToClipMatrix());
 			//down_boundary_node.render(mCamera.GetWorldToClipMatrix());
 			//left_boundary_node.render(mCamera.GetWorldToClipMatrix());
@@ -599,6 +848,8 @@ edaf80::project::run()
 		}
 
 
+		buffer_inspector.update();
+
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
 		//
@@ -613,9 +864,67 @@ edaf80::project::run()
 			bonobo::uiSelectPolygonMode("Polygon mode", polygon_mode);
 			ImGui::SliderFloat("Boundary width", &boundsSize.x, 10.0f, 30.0f);
 			ImGui::SliderFloat("Boundary height", &boundsSize.y, 5.0f, 20.0f);
+			ImGui::Separator();
+			ImGui::CheckboxFlags("Periodic X", &periodicAxes.x, 1);
+			ImGui::CheckboxFlags("Periodic Y", &periodicAxes.y, 1);
+			ImGui::Checkbox("Show periodic images", &showPeriodicImages);
+			ImGui::Separator();
+			ImGui::Checkbox("Particle sleeping", &enableSleeping);
+			ImGui::SliderFloat("Sleep velocity threshold", &sleepVelocityThreshold, 0.0f, 1.0f);
+			ImGui::SliderFloat("Sleep density threshold", &sleepDensityThreshold, 0.0f, 0.1f);
+			ImGui::SliderInt("Sleep frames", &sleepFrameCount, 1, 120);
+			ImGui::Text("Active particles: %u", active_particles);
+			ImGui::Text("Sleeping particles: %u", spawner.particleCount - active_particles);
+			ImGui::Separator();
+			ImGui::Checkbox("Neighbour lists", &useNeighbourList);
+			ImGui::SliderFloat("Neighbour skin", &neighbourSkin, 0.0f, 0.5f);
+			ImGui::SliderInt("Max neighbours", &maxNeighbours, 8, 256);
+			if (useNeighbourList) {
+				auto const neighbour_memory = spawner.particleCount * (neighbour_state_size + neighbour_list_capacity * sizeof(GLuint)) + sizeof(cleared_neighbour_stats);
+				ImGui::Text("List rebuilds: %.1f/s (every %.1f steps)", neighbour_rebuild_rate, neighbour_steps_per_rebuild);
+				ImGui::Text("Overflowing particles: %u", neighbour_overflows);
+				ImGui::Text("List memory: %.1f KiB", neighbour_memory / 1024.0f);
+			}
+			ImGui::Separator();
+			ImGui::Combo("SPH kernel", &sphKernel, "Spiky\0Poly6\0");
+			if (ImGui::TreeNode("Work-group sizes")) {
+				work_group_tuner.render_ui();
+				ImGui::TreePop();
+			}
+			ImGui::Checkbox("Viscosity", &sphViscosity);
+			ImGui::Checkbox("Mouse interaction", &sphInteraction);
+			ImGui::Checkbox("Obstacle", &sphObstacles);
+			if (sphObstacles) {
+				ImGui::SliderFloat2("Obstacle centre", glm::value_ptr(obstacleCentre), -10.0f, 10.0f);
+				ImGui::SliderFloat2("Obstacle size", glm::value_ptr(obstacleSize), 0.0f, 10.0f);
+			}
+			ImGui::Text("Compiled SPH variants: %zu", sph_variants.size());
+			ImGui::Separator();
+			if (!cluster_viewer.is_connected()) {
+				ImGui::InputText("Cluster host", clusterHost, sizeof(clusterHost));
+				ImGui::InputInt("Cluster port", &clusterPort);
+				if (ImGui::Button("Attach to CPU cluster")) {
+					try {
+						cluster_viewer.connect(clusterHost, static_cast<std::uint16_t>(clusterPort));
+					}
+					catch (std::runtime_error const& e) {
+						LogError("Failed to attach to the CPU cluster: %s", e.what());
+					}
+				}
+			}
+			else {
+				ImGui::Text("Cluster step %llu: %d particles, %zu slabs", static_cast<unsigned long long>(cluster_snapshot.step),
+				            rendered_particles, cluster_snapshot.boundaries.empty() ? std::size_t(0) : cluster_snapshot.boundaries.size() - 1u);
+				if (ImGui::Button("Detach from CPU cluster"))
+					cluster_viewer.disconnect();
+			}
 		}
 		ImGui::End();
 
+		if (ImGui::Begin("Buffer Inspector", nullptr, ImGuiWindowFlags_None))
+			buffer_inspector.render_ui();
+		ImGui::End();
+
 		if (show_basis)
 			bonobo::renderBasis(basis_thickness_scale, basis_length_scale, mCamera.GetWorldToClipMatrix());
 		if (show_logs)
@@ -117,6 +117,34 @@ namespace edaf80
 		float interactionRadius = 2;
 		float interactionStrength = 90;
 
+		//periodic boundaries (per axis) and rendering of the periodic images
+		glm::ivec2 periodicAxes = glm::ivec2(0);
+		bool showPeriodicImages = true;
+
+		//particle sleeping
+		bool enableSleeping = true;
+		float sleepVelocityThreshold = 0.2f;
+		float sleepDensityThreshold = 0.02f;
+		int sleepFrameCount = 30;
+		float activityCellSize = 0.35f;
+
+		//Verlet neighbour lists
+		bool useNeighbourList = false;
+		float neighbourSkin = 0.1f;
+		int maxNeighbours = 64;
+
+		//variant of the templated SPH shader (EDAF80/sph.comp)
+		int sphKernel = 0;
+		bool sphViscosity = true;
+		bool sphInteraction = true;
+		bool sphObstacles = false;
+		glm::vec2 obstacleCentre = glm::vec2(0.0f, -2.5f);
+		glm::vec2 obstacleSize = glm::vec2(2.0f, 4.0f);
+
+		//read-only attachment to a CPU cluster run (EDAN35_sph_cluster)
+		char clusterHost[64] = "127.0.0.1";
+		int clusterPort = 47300;
+
 		float pi = 3.14159265359f;
 		
 	};
@@ -2,11 +2,18 @@
 #include "parametric_shapes.hpp"
 
 #include "config.hpp"
+#include "core/AsyncReadback.hpp"
 #include "core/Bonobo.h"
+#include "core/BufferInspector.hpp"
 #include "core/FPSCamera.h"
+#include "core/InstanceBuffer.hpp"
 #include "core/node.hpp"
 #include "core/helpers.hpp"
+#include "core/opengl.hpp"
 #include "core/ShaderProgramManager.hpp"
+#include "core/StreamBuffer.hpp"
+#include "core/WorkGroupTuner.hpp"
+#include "sph_shader.hpp"
 
 #include <imgui.h>
 #include <tinyfiledialogs.h>
@@ -15,8 +22,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <array>
 #include <clocale>
+#include <cmath>
+#include <cstddef>
 #include <cstdlib>
 #include <stdexcept>
 #include <random>
@@ -139,6 +149,27 @@ edaf80::project3D::run()
 		LogError("Failed to load fallback shader");
 		return;
 	}
+	GLuint culled_particle_shader = 0u;
+	program_manager.CreateAndRegisterProgram("Culled particles",
+		{ { ShaderType::vertex, "common/fallbackParticle3DCulled.vert" },
+		  { ShaderType::fragment, "common/fallbackParticle3D.frag" } },
+		culled_particle_shader);
+	if (culled_particle_shader == 0u) {
+		LogError("Failed to load culled particles shader");
+		return;
+	}
+	GLuint particle_cull_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Particle culling", "EDAF80/particle_cull.comp", particle_cull_shader);
+	if (particle_cull_shader == 0u) {
+		LogError("Failed to load particle culling shader");
+		return;
+	}
+	GLuint flip_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("FLIP/APIC", "EDAF80/flip.comp", flip_shader);
+	if (flip_shader == 0u) {
+		LogError("Failed to load FLIP/APIC shader");
+		return;
+	}
 	GLuint fallbackBoundary_shader = 0u;
 	program_manager.CreateAndRegisterProgram("FallbackBoundary",
 		{ { ShaderType::vertex, "common/fallback.vert" },
@@ -172,8 +203,7 @@ edaf80::project3D::run()
 	//for (int i = 0; i < 100; i++) {
 	//	velocities[i] += glm::vec2(5.0f, 0.0f);
 	//}
-	//auto const shape = parametric_shapes::createBriefCircleRingBatch3(particleRadius, particleRadius * 2, 10u, 2u, spawner.particleCount, &positions, &velocities);
-	auto const shape = parametric_shapes::createSphereBatch2(particleRadius, 10u, 10u, spawner.particleCount, positions, velocities);
+	auto const shape = parametric_shapes::createBriefSphere(particleRadius, 10u, 10u);
 	//auto const shape = parametric_shapes::createSphere(0.1f, 10u, 10u);
 	//for (int i = 0; i < 100; i++) {
 	//	positions[i] += glm::vec2(1.0f, 0.0f);
@@ -181,9 +211,37 @@ edaf80::project3D::run()
 	auto circle = Node();
 	circle.set_geometry(shape);
 	circle.set_program(&fallback_shader, set_uniforms);
+	// Positions and velocities of the particles, uploaded once per frame
+	// and read by every periodic image drawn.
+	InstanceBuffer particle_instances({ { 1u, InstanceBuffer::AttributeType::vec3 },
+	                                    { 2u, InstanceBuffer::AttributeType::vec3 } },
+	                                  spawner.particleCount);
+	particle_instances.attach(shape);
 	circle.get_transform().SetTranslate(glm::vec3(0.0f, 0.0f, 0.0f));
 	TRSTransformf& circle_rings_transform_ref = circle.get_transform();
-	
+
+	// World-space translations of the periodic images drawn this frame; the
+	// first one is always the domain itself.
+	GLuint const max_periodic_images = 27u;
+	std::array<glm::vec3, max_periodic_images> periodic_image_offsets;
+	periodic_image_offsets.fill(glm::vec3(0.0f));
+	GLuint periodic_image_count = 1u;
+
+	// Particles drawn from the culling results: one node per level of
+	// detail, each reading its own section of the visible indices list.
+	std::array<bonobo::mesh_data, 2> const lod_shapes = {
+		parametric_shapes::createSphere(particleRadius, 10u, 10u),
+		parametric_shapes::createSphere(particleRadius, 4u, 3u)
+	};
+	std::array<Node, 2> culled_particles;
+	for (std::size_t lod = 0; lod < culled_particles.size(); ++lod) {
+		GLuint const visible_offset = static_cast<GLuint>(lod) * particlesNum * max_periodic_images;
+		culled_particles[lod].set_geometry(lod_shapes[lod]);
+		culled_particles[lod].set_program(&culled_particle_shader, [visible_offset, &periodic_image_offsets](GLuint program) {
+			glUniform1ui(glGetUniformLocation(program, "visibleOffset"), visible_offset);
+			glUniform3fv(glGetUniformLocation(program, "imageOffsets"), static_cast<GLsizei>(periodic_image_offsets.size()), glm::value_ptr(periodic_image_offsets[0]));
+			});
+	}
 
 	std::vector<particleParameter> particles(spawner.particleCount);
 	for (int i = 0; i < spawner.particleCount; i++) {
@@ -227,14 +285,197 @@ edaf80::project3D::run()
 	glBufferData(GL_SHADER_STORAGE_BUFFER, particles.size() * sizeof(particleParameter), particles.data(), GL_DYNAMIC_DRAW);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleBuffer);
 
-	std::string computeShaderSource = readFile("F:/desktop/CourseFile/ComputerGraphics/src/EDAF80/computeShader3D.glsl");
-	if (computeShaderSource.empty()) {
-		std::cerr << "Failed to read compute shader source file." << std::endl;
-		return;
-	}
-	GLuint computeProgram = createComputeShaderProgram(computeShaderSource);
+	// Compacted lists of visible particle indices (one list per level of
+	// detail) and the matching indirect draw commands, both filled in by
+	// the culling pass.
+	GLuint visibleIndicesBuffer;
+	glGenBuffers(1, &visibleIndicesBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibleIndicesBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, lod_shapes.size() * particlesNum * max_periodic_images * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+	utils::opengl::debug::nameObject(GL_BUFFER, visibleIndicesBuffer, "Visible particle indices");
+
+	std::array<DrawElementsIndirectCommand, 2> draw_commands;
+	for (std::size_t lod = 0; lod < draw_commands.size(); ++lod)
+		draw_commands[lod] = { static_cast<GLuint>(lod_shapes[lod].indices_nb), 0u, 0u, 0u, 0u };
+	GLuint indirectBuffer;
+	glGenBuffers(1, &indirectBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, indirectBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(draw_commands), draw_commands.data(), GL_DYNAMIC_DRAW);
+	utils::opengl::debug::nameObject(GL_BUFFER, indirectBuffer, "Particle indirect draw commands");
+
+	// Activity tracking: per-particle count of consecutive settled steps,
+	// double-buffered cell flags set by moving particles, and the number of
+	// awake particles (one slot per frame parity, so that the count read
+	// back is the one of the previous step).
+	std::vector<GLuint> const sleep_counters(spawner.particleCount, 0u);
+	GLuint sleepCounterBuffer;
+	glGenBuffers(1, &sleepCounterBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, sleepCounterBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sleep_counters.size() * sizeof(GLuint), sleep_counters.data(), GL_DYNAMIC_COPY);
+	utils::opengl::debug::nameObject(GL_BUFFER, sleepCounterBuffer, "Particle sleep counters");
+
+	GLuint activityCellBuffer;
+	glGenBuffers(1, &activityCellBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityCellBuffer);
+	utils::opengl::debug::nameObject(GL_BUFFER, activityCellBuffer, "Particle activity cells");
+	GLuint activity_cell_capacity = 0u;
+
+	GLuint const active_particle_slots[2] = { 0u, 0u };
+	GLuint activityCounterBuffer;
+	glGenBuffers(1, &activityCounterBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityCounterBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(active_particle_slots), active_particle_slots, GL_DYNAMIC_COPY);
+	utils::opengl::debug::nameObject(GL_BUFFER, activityCounterBuffer, "Active particle counters");
+	GLuint activity_parity = 0u;
+	GLuint active_particles = spawner.particleCount;
+	AsyncReadback active_particles_readback(sizeof(GLuint));
+
+	// Verlet neighbour lists: a reference position and candidate count per
+	// particle (16 bytes in std430), up to maxNeighbours indices per particle
+	// (allocated on first use), and the rebuild statistics, one entry per
+	// frame parity.
+	struct NeighbourListStats {
+		GLuint rebuildRequested;
+		GLuint rebuilt;
+		GLuint overflowCount;
+		GLuint padding;
+	};
+	GLsizeiptr const neighbour_state_size = 4 * sizeof(GLuint);
+	GLuint neighbourStateBuffer;
+	glGenBuffers(1, &neighbourStateBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, neighbourStateBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, spawner.particleCount * neighbour_state_size, nullptr, GL_DYNAMIC_COPY);
+	utils::opengl::debug::nameObject(GL_BUFFER, neighbourStateBuffer, "Neighbour list states");
+
+	GLuint neighbourIndexBuffer;
+	glGenBuffers(1, &neighbourIndexBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, neighbourIndexBuffer);
+	utils::opengl::debug::nameObject(GL_BUFFER, neighbourIndexBuffer, "Neighbour list indices");
+	GLuint neighbour_list_capacity = 0u;
+
+	NeighbourListStats const cleared_neighbour_stats[2] = {};
+	GLuint neighbourStatsBuffer;
+	glGenBuffers(1, &neighbourStatsBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, neighbourStatsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(cleared_neighbour_stats), cleared_neighbour_stats, GL_DYNAMIC_COPY);
+	utils::opengl::debug::nameObject(GL_BUFFER, neighbourStatsBuffer, "Neighbour list statistics");
+	AsyncReadback neighbour_stats_readback(sizeof(NeighbourListStats));
+
+	bool neighbour_lists_valid = false;
+	float neighbour_lists_skin = 0.0f;
+	GLuint neighbour_overflows = 0u;
+	unsigned int neighbour_rebuilds = 0u, neighbour_steps = 0u;
+	float neighbour_stats_time = 0.0f;
+	float neighbour_rebuild_rate = 0.0f, neighbour_steps_per_rebuild = 0.0f;
+
+	// Sparse FLIP/APIC grid: cells are grouped in 8x8x8 bricks, allocated
+	// every step from a pool (grown on demand) through a page table indexed
+	// by brick coordinate. The pool holds, for every cell, the fixed-point
+	// momentum and weight accumulators and the velocities of its three low
+	// faces, then its particle count, divergence and pressure. The APIC
+	// affine velocity of every particle lives next to the particle buffer.
+	GLuint const flip_brick_cells = 512u;
+	GLsizeiptr const flip_face_accumulator_stride = 3 * 2 * sizeof(GLint);
+	GLsizeiptr const flip_face_stride = 3 * 4 * sizeof(float);
+	GLsizeiptr const flip_cell_stride = 4 * sizeof(GLuint);
+	GLsizeiptr const flip_brick_coordinate_stride = 4 * sizeof(GLint);
+	float const flip_fixed_point_scale = 65536.0f;
+	GLuint flipFaceAccumulatorBuffer;
+	glGenBuffers(1, &flipFaceAccumulatorBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipFaceAccumulatorBuffer);
+	utils::opengl::debug::nameObject(GL_BUFFER, flipFaceAccumulatorBuffer, "FLIP face accumulators");
+
+	GLuint flipFaceBuffer;
+	glGenBuffers(1, &flipFaceBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipFaceBuffer);
+	utils::opengl::debug::nameObject(GL_BUFFER, flipFaceBuffer, "FLIP face velocities");
+
+	GLuint flipCellBuffer;
+	glGenBuffers(1, &flipCellBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipCellBuffer);
+	utils::opengl::debug::nameObject(GL_BUFFER, flipCellBuffer, "FLIP cells");
+
+	GLuint flipBrickCoordinateBuffer;
+	glGenBuffers(1, &flipBrickCoordinateBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipBrickCoordinateBuffer);
+	utils::opengl::debug::nameObject(GL_BUFFER, flipBrickCoordinateBuffer, "FLIP brick coordinates");
+
+	GLuint flipPageTableBuffer;
+	glGenBuffers(1, &flipPageTableBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipPageTableBuffer);
+	utils::opengl::debug::nameObject(GL_BUFFER, flipPageTableBuffer, "FLIP brick page table");
+
+	// Number of requested bricks, then the indirect dispatch size of the
+	// per-cell stages (at a 4-byte aligned offset, as required).
+	GLuint const cleared_brick_allocator[5] = { 0u, 0u, 0u, 1u, 1u };
+	GLintptr const flip_dispatch_offset = 2 * sizeof(GLuint);
+	GLuint flipBrickAllocatorBuffer;
+	glGenBuffers(1, &flipBrickAllocatorBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipBrickAllocatorBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(cleared_brick_allocator), cleared_brick_allocator, GL_DYNAMIC_COPY);
+	utils::opengl::debug::nameObject(GL_BUFFER, flipBrickAllocatorBuffer, "FLIP brick allocator");
+
+	std::vector<glm::vec4> const cleared_affine(3u * spawner.particleCount, glm::vec4(0.0f));
+	GLuint flipAffineBuffer;
+	glGenBuffers(1, &flipAffineBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipAffineBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, cleared_affine.size() * sizeof(glm::vec4), cleared_affine.data(), GL_DYNAMIC_COPY);
+	utils::opengl::debug::nameObject(GL_BUFFER, flipAffineBuffer, "APIC affine velocities");
+
+	// The pose and velocities of the container, shared by the SPH and FLIP
+	// programs through uniform block binding 0; every frame writes them to
+	// a new slot, leaving those of the frames in flight untouched.
+	auto const container_alignment = StreamBuffer::uniform_alignment();
+	auto const container_stride = (static_cast<GLsizeiptr>(sizeof(ContainerTransform)) + container_alignment - 1) / container_alignment * container_alignment;
+	StreamBuffer containerStream(16 * container_stride);
+	utils::opengl::debug::nameObject(GL_BUFFER, containerStream.get_buffer(), "Container transform");
+
+	// The container is tilted about z then x, and offset along x.
+	float container_time = 0.0f;
+	glm::vec2 container_tilt = glm::vec2(0.0f);
+	glm::vec3 container_offset = glm::vec3(0.0f);
+	glm::vec2 container_mouse = glm::vec2(0.0f);
+	int previous_container_motion = containerMotion;
+	bool reset_container = false;
+
+	glm::ivec3 flip_grid_size = glm::ivec3(0);
+	glm::ivec3 flip_brick_grid_size = glm::ivec3(0);
+	GLuint flip_page_count = 0u, flip_brick_capacity = 0u, flip_requested_bricks = 0u;
+	unsigned int flip_overflowed_steps = 0u;
+	// Requested and overflowed bricks of the allocation of a step.
+	AsyncReadback flip_brick_readback(2 * sizeof(GLuint));
+	int previous_fluid_solver = fluidSolver;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleBuffer);
+
+	// Every configuration of the SPH step is its own program, built the
+	// first time it gets selected; a variant failing to build keeps the
+	// previous one running.
+	sph_shader::VariantCache sph_variants(program_manager);
+	WorkGroupTuner work_group_tuner("work_group_sizes.txt");
+
+	// Statistics and samples of the particles, read back asynchronously
+	// instead of mapping the whole buffer.
+	BufferInspector buffer_inspector(program_manager);
+	buffer_inspector.register_buffer("Particles", particleBuffer, sizeof(particleParameter), static_cast<std::uint32_t>(particles.size()), {
+		{ "Position", offsetof(particleParameter, position), 3u },
+		{ "Velocity", offsetof(particleParameter, velocity), 3u },
+		{ "Predicted position", offsetof(particleParameter, predictedPosition), 3u },
+		{ "Density", offsetof(particleParameter, density), 4u },
+	});
+	auto const selected_sph_variant = [this]() {
+		sph_shader::Variant variant;
+		variant.dimensions = 3u;
+		variant.kernel = static_cast<sph_shader::Kernel>(sphKernel);
+		variant.particle_capacity = spawner.particleCount;
+		variant.viscosity = sphViscosity;
+		variant.interaction = false;
+		variant.obstacles = sphObstacles;
+		return variant;
+	};
+	auto sph_variant = selected_sph_variant();
+	GLuint computeProgram = sph_variants.get(sph_variant);
 	if (computeProgram == 0) {
-		std::cerr << "Failed to create compute shader program." << std::endl;
+		LogError("Failed to create the SPH compute program");
 		return;
 	}
 	////calculation part
@@ -379,6 +620,8 @@ edaf80::project3D::run()
 					"Rendering is suspended until the issue is solved. Once fixed, just reload the shaders again.",
 					"error");
 		}
+		if (program_manager.PollHotReload())
+			shader_reload_failed = false;
 		if (inputHandler.GetKeycodeState(GLFW_KEY_F3) & JUST_RELEASED)
 			show_logs = !show_logs;
 		if (inputHandler.GetKeycodeState(GLFW_KEY_F2) & JUST_RELEASED)
@@ -386,6 +629,64 @@ edaf80::project3D::run()
 		if (inputHandler.GetKeycodeState(GLFW_KEY_F11) & JUST_RELEASED)
 			mWindowManager.ToggleFullscreenStatusForWindow(window);
 
+		// Move the container, then derive its velocities from the motion
+		// over the frame. Jumps (a reset, or a change of motion restarting
+		// the animation) move it without imparting any velocity.
+		{
+			auto const previous_tilt = container_tilt;
+			auto const previous_offset = container_offset;
+			bool teleported = reset_container || containerMotion != previous_container_motion;
+			if (reset_container) {
+				container_time = 0.0f;
+				container_tilt = glm::vec2(0.0f);
+				container_offset = glm::vec3(0.0f);
+				reset_container = false;
+			}
+			if (containerMotion == 1) {
+				if (containerMotion != previous_container_motion)
+					container_time = 0.0f;
+				container_time += float_deltaTime;
+				auto const wave = std::sin(2.0f * glm::pi<float>() * containerFrequency * container_time);
+				container_tilt = glm::vec2(0.0f, containerTiltAmplitude * wave);
+				container_offset = glm::vec3(containerShakeAmplitude * wave, 0.0f, 0.0f);
+			}
+			auto const mouse_position = inputHandler.GetMousePosition();
+			if (containerMotion == 2
+			    && (inputHandler.GetMouseState(GLFW_MOUSE_BUTTON_RIGHT) & PRESSED)
+			    && !(inputHandler.GetMouseState(GLFW_MOUSE_BUTTON_RIGHT) & JUST_PRESSED)) {
+				auto const mouse_delta = mouse_position - container_mouse;
+				container_tilt.x += mouse_delta.y * containerMouseSensitivity;
+				container_tilt.y -= mouse_delta.x * containerMouseSensitivity;
+				container_tilt = glm::clamp(container_tilt, -containerMaxTilt, containerMaxTilt);
+			}
+			container_mouse = mouse_position;
+			previous_container_motion = containerMotion;
+
+			auto const rotate_z = glm::rotate(glm::mat4(1.0f), container_tilt.y, glm::vec3(0.0f, 0.0f, 1.0f));
+			localToWorld = glm::translate(glm::mat4(1.0f), container_offset)
+			             * rotate_z
+			             * glm::rotate(glm::mat4(1.0f), container_tilt.x, glm::vec3(1.0f, 0.0f, 0.0f));
+			worldToLocal = glm::inverse(localToWorld);
+
+			ContainerTransform container;
+			container.localToWorld = localToWorld;
+			container.worldToLocal = worldToLocal;
+			container.linearVelocity = glm::vec4(0.0f);
+			container.angularVelocity = glm::vec4(0.0f);
+			if (!teleported && float_deltaTime > 0.0f) {
+				// For R = Rz(tilt.y) Rx(tilt.x), the angular velocity is
+				// tilt.y' ez + Rz(tilt.y) (tilt.x' ex).
+				auto const tilt_rate = (container_tilt - previous_tilt) / float_deltaTime;
+				auto const angular_velocity = glm::vec3(0.0f, 0.0f, tilt_rate.y)
+				                            + glm::mat3(rotate_z) * glm::vec3(tilt_rate.x, 0.0f, 0.0f);
+				container.linearVelocity = glm::vec4((container_offset - previous_offset) / float_deltaTime, 0.0f);
+				container.angularVelocity = glm::vec4(angular_velocity, 0.0f);
+			}
+			auto const container_slot = containerStream.write(&container, sizeof(container), container_stride);
+			if (container_slot >= 0)
+				glBindBufferRange(GL_UNIFORM_BUFFER, 0u, containerStream.get_buffer(), container_slot, sizeof(container));
+		}
+
 
 		// Retrieve the actual framebuffer size: for HiDPI monitors,
 		// you might end up with a framebuffer larger than what you
@@ -423,49 +724,332 @@ edaf80::project3D::run()
 			//glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, positionBuffer);
 			//glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, velocityBuffer);
 			//-------------------------------------------------
+			auto const activity_grid_size = glm::ivec3(glm::ceil(boundsSize / activityCellSize)) + 1;
+			auto const activity_cell_count = static_cast<GLuint>(activity_grid_size.x * activity_grid_size.y * activity_grid_size.z);
+			if (activity_cell_count > activity_cell_capacity) {
+				activity_cell_capacity = activity_cell_count;
+				std::vector<GLuint> const cleared_cells(2u * activity_cell_capacity, 0u);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityCellBuffer);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, cleared_cells.size() * sizeof(GLuint), cleared_cells.data(), GL_DYNAMIC_COPY);
+			}
+			GLuint const activity_write_offset = activity_parity * activity_cell_capacity;
+			GLuint const activity_read_offset = (1u - activity_parity) * activity_cell_capacity;
+			GLuint const zero = 0u;
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityCellBuffer);
+			glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, activity_write_offset * sizeof(GLuint), activity_cell_capacity * sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityCounterBuffer);
+			glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, activity_parity * sizeof(GLuint), sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+			bool force_neighbour_rebuild = false;
+			if (useNeighbourList) {
+				if (neighbour_list_capacity != static_cast<GLuint>(maxNeighbours)) {
+					neighbour_list_capacity = static_cast<GLuint>(maxNeighbours);
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, neighbourIndexBuffer);
+					glBufferData(GL_SHADER_STORAGE_BUFFER, spawner.particleCount * neighbour_list_capacity * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+					neighbour_lists_valid = false;
+				}
+				force_neighbour_rebuild = !neighbour_lists_valid || neighbour_lists_skin != neighbourSkin;
+				neighbour_lists_valid = true;
+				neighbour_lists_skin = neighbourSkin;
+			}
+			else {
+				neighbour_lists_valid = false;
+			}
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, neighbourStatsBuffer);
+			glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, activity_parity * sizeof(NeighbourListStats), sizeof(NeighbourListStats), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, neighbourStatsBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, neighbourStateBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, neighbourIndexBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sleepCounterBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, activityCellBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, activityCounterBuffer);
 			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleBuffer);
+			// The uniforms are shared by the simulation step and the
+			// work-group size measurements, which run it with a zero
+			// time step on scratch copies of every buffer it writes to.
+			auto const set_sph_uniforms = [&](GLuint program, float delta_time) {
+				glUniform1f(glGetUniformLocation(program, "collisionDamping"), collisionDamping);
+				glUniform1f(glGetUniformLocation(program, "gravity"), gravity);
+				glUniform1f(glGetUniformLocation(program, "particleRadius"), particleRadius);
+				glUniform1f(glGetUniformLocation(program, "deltaTime"), delta_time);
+				glUniform3fv(glGetUniformLocation(program, "boundsSize"), 1, glm::value_ptr(boundsSize));
+
+				glUniform1f(glGetUniformLocation(program, "smoothingRadius"), smoothingRadius);
+				glUniform1f(glGetUniformLocation(program, "targetDensity"), targetDensity);
+				glUniform1f(glGetUniformLocation(program, "pressureMultiplier"), pressureMultiplier);
+				glUniform1f(glGetUniformLocation(program, "nearPressureMultiplier"), nearPressureMultiplier);
+				glUniform1f(glGetUniformLocation(program, "viscosityStrength"), viscosityStrength);
+
+				glUniform3iv(glGetUniformLocation(program, "periodicAxes"), 1, glm::value_ptr(periodicAxes));
+				glUniform1i(glGetUniformLocation(program, "enableSleeping"), enableSleeping ? 1 : 0);
+				glUniform1f(glGetUniformLocation(program, "sleepVelocityThreshold"), sleepVelocityThreshold);
+				glUniform1f(glGetUniformLocation(program, "sleepDensityThreshold"), sleepDensityThreshold);
+				glUniform1ui(glGetUniformLocation(program, "sleepFrameCount"), static_cast<GLuint>(sleepFrameCount));
+				glUniform1f(glGetUniformLocation(program, "activityCellSize"), activityCellSize);
+				glUniform3iv(glGetUniformLocation(program, "activityGridSize"), 1, glm::value_ptr(activity_grid_size));
+				glUniform1ui(glGetUniformLocation(program, "activityReadOffset"), activity_read_offset);
+				glUniform1ui(glGetUniformLocation(program, "activityWriteOffset"), activity_write_offset);
+				glUniform1ui(glGetUniformLocation(program, "activityCounterSlot"), activity_parity);
+				glUniform1i(glGetUniformLocation(program, "useNeighbourList"), useNeighbourList ? 1 : 0);
+				glUniform1i(glGetUniformLocation(program, "forceNeighbourRebuild"), force_neighbour_rebuild ? 1 : 0);
+				glUniform1f(glGetUniformLocation(program, "neighbourSkin"), neighbourSkin);
+				glUniform1ui(glGetUniformLocation(program, "maxNeighbours"), neighbour_list_capacity);
+				glUniform1ui(glGetUniformLocation(program, "neighbourReadSlot"), 1u - activity_parity);
+				glUniform1ui(glGetUniformLocation(program, "neighbourWriteSlot"), activity_parity);
+				glUniform3fv(glGetUniformLocation(program, "obstacleCentre"), 1, glm::value_ptr(obstacleCentre));
+				glUniform3fv(glGetUniformLocation(program, "obstacleSize"), 1, glm::value_ptr(obstacleSize));
+			};
+			auto requested_sph_variant = selected_sph_variant();
+			requested_sph_variant.work_group_size = sph_variant.work_group_size;
+			if (fluidSolver == 0)
+				requested_sph_variant.work_group_size = work_group_tuner.select(requested_sph_variant.kernel_name(), sph_shader::Variant::work_group_size_candidates(),
+					[&](std::uint32_t work_group_size) {
+						auto variant = requested_sph_variant;
+						variant.work_group_size = work_group_size;
+						return sph_variants.get(variant);
+					},
+					[&](GLuint program, std::uint32_t work_group_size) {
+						glUseProgram(program);
+						set_sph_uniforms(program, 0.0f);
+						glDispatchCompute((requested_sph_variant.particle_capacity + work_group_size - 1u) / work_group_size, 1, 1);
+						glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+					},
+					{ 0u, 1u, 2u, 3u, 5u, 6u, 7u });
+			auto const requested_program = sph_variants.get(requested_sph_variant);
+			if (requested_program != 0u) {
+				sph_variant = requested_sph_variant;
+				computeProgram = requested_program;
+			}
 			glUseProgram(computeProgram);
-			glUniform1f(glGetUniformLocation(computeProgram, "collisionDamping"), collisionDamping);
-			glUniform1f(glGetUniformLocation(computeProgram, "gravity"), gravity);
-			glUniform1f(glGetUniformLocation(computeProgram, "particleRadius"), particleRadius);
-			glUniform1f(glGetUniformLocation(computeProgram, "deltaTime"), float_deltaTime);
-			glUniform3fv(glGetUniformLocation(computeProgram, "boundsSize"), 1, glm::value_ptr(boundsSize));
-
-			glUniform1i(glGetUniformLocation(computeProgram, "numParticles"), particlesNum);
-			glUniform1f(glGetUniformLocation(computeProgram, "smoothingRadius"), smoothingRadius);
-			glUniform1f(glGetUniformLocation(computeProgram, "targetDensity"), targetDensity);
-			glUniform1f(glGetUniformLocation(computeProgram, "pressureMultiplier"), pressureMultiplier);
-			glUniform1f(glGetUniformLocation(computeProgram, "nearPressureMultiplier"), nearPressureMultiplier);
-			glUniform1f(glGetUniformLocation(computeProgram, "viscosityStrength"), viscosityStrength);
-
-			glUniformMatrix4fv(glGetUniformLocation(computeProgram, "localToWorld"), 1, GL_FALSE, glm::value_ptr(localToWorld));
-			glUniformMatrix4fv(glGetUniformLocation(computeProgram, "worldToLocal"), 1, GL_FALSE, glm::value_ptr(worldToLocal));
-
-			glDispatchCompute(125, 1, 1);
-			//glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-			glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, particles.size() * sizeof(particleParameter), particles.data());
-			for (int i = 0; i < spawner.particleCount; i++) {
-				positions[i] = particles[i].position;
-				velocities[i] = particles[i].velocity;
+			set_sph_uniforms(computeProgram, float_deltaTime);
+
+			if (fluidSolver == 0) {
+				glDispatchCompute(sph_variant.work_group_count(), 1, 1);
+			}
+			else {
+				// FLIP/APIC step: the same particles are advanced through
+				// a sparse staggered grid instead of the SPH forces.
+				auto const grid_size = glm::max(glm::ivec3(glm::round(boundsSize / flipCellSize)), glm::ivec3(1));
+				if (grid_size != flip_grid_size) {
+					flip_grid_size = grid_size;
+					flip_brick_grid_size = (grid_size + 7) / 8;
+					flip_page_count = static_cast<GLuint>(flip_brick_grid_size.x * flip_brick_grid_size.y * flip_brick_grid_size.z);
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipPageTableBuffer);
+					glBufferData(GL_SHADER_STORAGE_BUFFER, flip_page_count * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+					flip_requested_bricks = std::min(flip_requested_bricks, flip_page_count);
+					flip_brick_readback.discard();
+				}
+				auto const resize_brick_pool = [&](GLuint capacity) {
+					flip_brick_capacity = capacity;
+					GLsizeiptr const pool_cells = static_cast<GLsizeiptr>(capacity) * flip_brick_cells;
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipFaceAccumulatorBuffer);
+					glBufferData(GL_SHADER_STORAGE_BUFFER, pool_cells * flip_face_accumulator_stride, nullptr, GL_DYNAMIC_COPY);
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipFaceBuffer);
+					glBufferData(GL_SHADER_STORAGE_BUFFER, pool_cells * flip_face_stride, nullptr, GL_DYNAMIC_COPY);
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipCellBuffer);
+					glBufferData(GL_SHADER_STORAGE_BUFFER, pool_cells * flip_cell_stride, nullptr, GL_DYNAMIC_COPY);
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipBrickCoordinateBuffer);
+					glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * flip_brick_coordinate_stride, nullptr, GL_DYNAMIC_COPY);
+				};
+				if (flip_brick_capacity == 0u)
+					resize_brick_pool(std::max(flip_page_count / 4u, 1u));
+				if (fluidSolver != previous_fluid_solver) {
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipAffineBuffer);
+					glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32F, GL_RED, GL_FLOAT, nullptr);
+				}
+
+				auto const cell_size = boundsSize / glm::vec3(grid_size);
+				glUseProgram(flip_shader);
+				glUniform1ui(glGetUniformLocation(flip_shader, "numParticles"), particlesNum);
+				glUniform3iv(glGetUniformLocation(flip_shader, "gridSize"), 1, glm::value_ptr(grid_size));
+				glUniform3iv(glGetUniformLocation(flip_shader, "brickGridSize"), 1, glm::value_ptr(flip_brick_grid_size));
+				glUniform3fv(glGetUniformLocation(flip_shader, "cellSize"), 1, glm::value_ptr(cell_size));
+				glUniform3fv(glGetUniformLocation(flip_shader, "boundsSize"), 1, glm::value_ptr(boundsSize));
+				glUniform3iv(glGetUniformLocation(flip_shader, "periodicAxes"), 1, glm::value_ptr(periodicAxes));
+				glUniform1f(glGetUniformLocation(flip_shader, "deltaTime"), std::min(float_deltaTime, 1.0f / 30.0f));
+				glUniform1f(glGetUniformLocation(flip_shader, "gravity"), gravity);
+				glUniform1f(glGetUniformLocation(flip_shader, "collisionDamping"), collisionDamping);
+				glUniform1f(glGetUniformLocation(flip_shader, "fixedPointScale"), flip_fixed_point_scale);
+				glUniform1f(glGetUniformLocation(flip_shader, "flipRatio"), flipRatio);
+				glUniform1i(glGetUniformLocation(flip_shader, "useApic"), fluidSolver == 2 ? 1 : 0);
+
+				auto const run_flip_stage = [&flip_shader](GLint stage, GLuint invocations) {
+					glUniform1i(glGetUniformLocation(flip_shader, "flipStage"), stage);
+					glDispatchCompute((invocations + 127u) / 128u, 1, 1);
+					glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+				};
+				// Per-cell stages only run over the allocated bricks, with
+				// the dispatch size written by the allocation.
+				auto const run_flip_brick_stage = [&flip_shader, flip_dispatch_offset](GLint stage) {
+					glUniform1i(glGetUniformLocation(flip_shader, "flipStage"), stage);
+					glDispatchComputeIndirect(flip_dispatch_offset);
+					glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+				};
+				// Grow the pool as soon as the fluid fills three quarters of
+				// it, as reported by the latest allocation the GPU is done
+				// with, so that it rarely overflows during the few steps the
+				// readback lags behind. Reading the counts of this step
+				// instead would wait for it. Steps that still overflowed are
+				// reported: their particles outside the pool skipped the
+				// grid transfers and only fell under gravity.
+				GLuint flip_brick_counts[2] = { 0u, 0u };
+				while (flip_brick_readback.poll(flip_brick_counts)) {
+					flip_requested_bricks = flip_brick_counts[0];
+					if (flip_brick_counts[1] > 0u) {
+						++flip_overflowed_steps;
+						LogWarning("The FLIP brick pool overflowed by %u bricks (%u in pool)", flip_brick_counts[1], flip_requested_bricks - flip_brick_counts[1]);
+					}
+				}
+				if (flip_requested_bricks > flip_brick_capacity - flip_brick_capacity / 4u) {
+					auto const grown_capacity = std::min(flip_requested_bricks + flip_requested_bricks / 2u, flip_page_count);
+					if (grown_capacity > flip_brick_capacity)
+						resize_brick_pool(grown_capacity);
+				}
+
+				GLuint const empty_page = 0xFFFFFFFFu;
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipPageTableBuffer);
+				glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &empty_page);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, flipBrickAllocatorBuffer);
+				glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(cleared_brick_allocator), cleared_brick_allocator);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, flipFaceAccumulatorBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, flipFaceBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, flipCellBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, flipAffineBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, flipPageTableBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, flipBrickCoordinateBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, flipBrickAllocatorBuffer);
+				glUniform1ui(glGetUniformLocation(flip_shader, "brickPoolCapacity"), flip_brick_capacity);
+				run_flip_stage(0, particlesNum);
+
+				glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, flipBrickAllocatorBuffer);
+				glUniform1i(glGetUniformLocation(flip_shader, "flipStage"), 1);
+				glDispatchCompute(1, 1, 1);
+				glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+				flip_brick_readback.request(flipBrickAllocatorBuffer, 0, 2 * sizeof(GLuint));
+				run_flip_brick_stage(2);
+				run_flip_stage(3, particlesNum);
+				run_flip_brick_stage(4);
+				run_flip_brick_stage(5);
+				for (int i = 0; i < flipPressureIterations; ++i) {
+					for (GLint parity = 0; parity < 2; ++parity) {
+						glUniform1i(glGetUniformLocation(flip_shader, "parity"), parity);
+						run_flip_brick_stage(6);
+					}
+				}
+				run_flip_brick_stage(7);
+				run_flip_stage(8, particlesNum);
+				glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0u);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, 0u);
+			}
+			previous_fluid_solver = fluidSolver;
+
+			periodic_image_count = 1u;
+			if (showPeriodicImages) {
+				for (int z = -periodicAxes.z; z <= periodicAxes.z; ++z)
+					for (int y = -periodicAxes.y; y <= periodicAxes.y; ++y)
+						for (int x = -periodicAxes.x; x <= periodicAxes.x; ++x) {
+							if (x == 0 && y == 0 && z == 0)
+								continue;
+							auto const image_offset_local = glm::vec3(x, y, z) * boundsSize;
+							periodic_image_offsets[periodic_image_count++] = glm::mat3(localToWorld) * image_offset_local;
+						}
+			}
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, 0u);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, 0u);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, 0u);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, 0u);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0u);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0u);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+			// The count of the step just issued is picked up once the GPU is
+			// done with it, so the value shown lags a frame or two behind.
+			active_particles_readback.request(activityCounterBuffer, activity_parity * sizeof(GLuint), sizeof(GLuint));
+			active_particles_readback.poll(&active_particles);
+			if (useNeighbourList) {
+				// Statistics are collected the same way, and the rates computed
+				// over the steps whose statistics came back.
+				if (neighbour_stats_readback.request(neighbourStatsBuffer, activity_parity * sizeof(NeighbourListStats), sizeof(NeighbourListStats)))
+					neighbour_stats_time += float_deltaTime;
+				NeighbourListStats finished_stats;
+				while (neighbour_stats_readback.poll(&finished_stats)) {
+					if (finished_stats.rebuilt != 0u) {
+						++neighbour_rebuilds;
+						neighbour_overflows = finished_stats.overflowCount;
+					}
+					++neighbour_steps;
+				}
+				if (neighbour_stats_time >= 1.0f) {
+					neighbour_rebuild_rate = neighbour_rebuilds / neighbour_stats_time;
+					neighbour_steps_per_rebuild = neighbour_steps / static_cast<float>(std::max(neighbour_rebuilds, 1u));
+					neighbour_rebuilds = 0u;
+					neighbour_steps = 0u;
+					neighbour_stats_time = 0.0f;
+				}
+			}
+			else {
+				neighbour_stats_readback.discard();
+			}
+			activity_parity = 1u - activity_parity;
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleBuffer);
+			if (useGpuCulling) {
+				// Reset the instance counts, then let the culling pass
+				// append every visible particle to the list of its level
+				// of detail; nothing is read back to the CPU.
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, indirectBuffer);
+				glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(draw_commands), draw_commands.data());
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, visibleIndicesBuffer);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, indirectBuffer);
+				glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+				auto const frustum_planes = mCamera.GetFrustumPlanes();
+				glUseProgram(particle_cull_shader);
+				glUniform1ui(glGetUniformLocation(particle_cull_shader, "numParticles"), particlesNum);
+				glUniform1ui(glGetUniformLocation(particle_cull_shader, "listCapacity"), particlesNum * max_periodic_images);
+				glUniform1ui(glGetUniformLocation(particle_cull_shader, "imageCount"), periodic_image_count);
+				glUniform3fv(glGetUniformLocation(particle_cull_shader, "imageOffsets"), static_cast<GLsizei>(periodic_image_offsets.size()), glm::value_ptr(periodic_image_offsets[0]));
+				glUniform1f(glGetUniformLocation(particle_cull_shader, "particleRadius"), particleRadius);
+				glUniform4fv(glGetUniformLocation(particle_cull_shader, "frustumPlanes"), static_cast<GLsizei>(frustum_planes.size()), glm::value_ptr(frustum_planes[0]));
+				glUniform1i(glGetUniformLocation(particle_cull_shader, "enableLod"), useCullingLod ? 1 : 0);
+				glUniform3fv(glGetUniformLocation(particle_cull_shader, "cameraPosition"), 1, glm::value_ptr(mCamera.mWorld.GetTranslation()));
+				glUniform1f(glGetUniformLocation(particle_cull_shader, "projectionScale"), 0.5f * mCamera.mProjection[1][1] * static_cast<float>(framebuffer_height));
+				glUniform1f(glGetUniformLocation(particle_cull_shader, "lodPixelThreshold"), lodPixelThreshold);
+				glDispatchCompute((particlesNum + 127u) / 128u, 1, 1);
+				glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+			}
+			else {
+				glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, particles.size() * sizeof(particleParameter), particles.data());
+				for (int i = 0; i < spawner.particleCount; i++) {
+					positions[i] = particles[i].position;
+					velocities[i] = particles[i].velocity;
+				}
 			}
-	/*		for (int i = 0; i < spawner.particleCount; i++) {
-				std::cout << particles[i].position << std::endl;
-				std::cout << particles[i].velocity << std::endl;
-			}*/
-			//std::cout << particles[1000].position << std::endl;
 			//test
 			//glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, positions.size() * sizeof(glm::vec2), velocities.size() * sizeof(glm::vec2), velocities.data());
 			//glDeleteBuffers(1, &buffer);
 			//glDeleteProgram(computeProgram);
 			glUseProgram(0);
-			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0u);
 			//------------------------------------------
 			//glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0u);
 			//circle.render(mCamera.GetWorldToClipMatrix());
-			circle.render(mCamera.GetWorldToClipMatrix(), spawner.particleCount, positions, velocities);
+			if (useGpuCulling) {
+				for (std::size_t lod = 0; lod < culled_particles.size(); ++lod)
+					culled_particles[lod].render_indirect(mCamera.GetWorldToClipMatrix(), indirectBuffer, static_cast<GLintptr>(lod * sizeof(DrawElementsIndirectCommand)));
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, 0u);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, 0u);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0u);
+			}
+			else {
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0u);
+				particle_instances.update(0u, positions);
+				particle_instances.update(1u, velocities);
+				for (GLuint image = 0u; image < periodic_image_count; ++image)
+					circle.render_instanced(mCamera.GetWorldToClipMatrix(), particle_instances, glm::translate(glm::mat4(1.0f), periodic_image_offsets[image]));
+			}
 		}
 
 
+		buffer_inspector.update();
+
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
 		//
@@ -478,9 +1062,82 @@ edaf80::project3D::run()
 			ImGui::SliderFloat("Basis thickness scale", &basis_thickness_scale, 0.0f, 100.0f);
 			ImGui::SliderFloat("Basis length scale", &basis_length_scale, 0.0f, 100.0f);
 			bonobo::uiSelectPolygonMode("Polygon mode", polygon_mode);
+			ImGui::Separator();
+			ImGui::CheckboxFlags("Periodic X", &periodicAxes.x, 1);
+			ImGui::CheckboxFlags("Periodic Y", &periodicAxes.y, 1);
+			ImGui::CheckboxFlags("Periodic Z", &periodicAxes.z, 1);
+			ImGui::Checkbox("Show periodic images", &showPeriodicImages);
+			ImGui::Separator();
+			ImGui::Combo("Container motion", &containerMotion, "Static\0Sloshing\0Mouse (right drag)\0");
+			if (containerMotion == 1) {
+				ImGui::SliderFloat("Tilt amplitude [rad]", &containerTiltAmplitude, 0.0f, 0.6f);
+				ImGui::SliderFloat("Shake amplitude", &containerShakeAmplitude, 0.0f, 1.0f);
+				ImGui::SliderFloat("Frequency [Hz]", &containerFrequency, 0.05f, 2.0f);
+			}
+			else if (containerMotion == 2) {
+				ImGui::SliderFloat("Mouse sensitivity", &containerMouseSensitivity, 0.001f, 0.02f);
+			}
+			if (ImGui::Button("Reset container"))
+				reset_container = true;
+			ImGui::Separator();
+			ImGui::Checkbox("GPU frustum culling", &useGpuCulling);
+			ImGui::Checkbox("Sphere LOD", &useCullingLod);
+			ImGui::SliderFloat("LOD threshold [px]", &lodPixelThreshold, 1.0f, 32.0f);
+			ImGui::Separator();
+			ImGui::Checkbox("Particle sleeping", &enableSleeping);
+			ImGui::SliderFloat("Sleep velocity threshold", &sleepVelocityThreshold, 0.0f, 1.0f);
+			ImGui::SliderFloat("Sleep density threshold", &sleepDensityThreshold, 0.0f, 0.1f);
+			ImGui::SliderInt("Sleep frames", &sleepFrameCount, 1, 120);
+			if (fluidSolver == 0) {
+				ImGui::Text("Active particles: %u", active_particles);
+				ImGui::Text("Sleeping particles: %u", spawner.particleCount - active_particles);
+			}
+			ImGui::Separator();
+			ImGui::Checkbox("Neighbour lists", &useNeighbourList);
+			ImGui::SliderFloat("Neighbour skin", &neighbourSkin, 0.0f, 0.5f);
+			ImGui::SliderInt("Max neighbours", &maxNeighbours, 8, 256);
+			if (useNeighbourList) {
+				auto const neighbour_memory = spawner.particleCount * (neighbour_state_size + neighbour_list_capacity * sizeof(GLuint)) + sizeof(cleared_neighbour_stats);
+				ImGui::Text("List rebuilds: %.1f/s (every %.1f steps)", neighbour_rebuild_rate, neighbour_steps_per_rebuild);
+				ImGui::Text("Overflowing particles: %u", neighbour_overflows);
+				ImGui::Text("List memory: %.1f KiB", neighbour_memory / 1024.0f);
+			}
+			ImGui::Separator();
+			ImGui::Combo("Fluid solver", &fluidSolver, "SPH\0FLIP\0APIC\0");
+			if (fluidSolver == 0) {
+				ImGui::Combo("SPH kernel", &sphKernel, "Spiky\0Poly6\0");
+				if (ImGui::TreeNode("Work-group sizes")) {
+					work_group_tuner.render_ui();
+					ImGui::TreePop();
+				}
+				ImGui::Checkbox("Viscosity", &sphViscosity);
+				ImGui::Checkbox("Obstacle", &sphObstacles);
+				if (sphObstacles) {
+					ImGui::SliderFloat3("Obstacle centre", glm::value_ptr(obstacleCentre), -3.0f, 3.0f);
+					ImGui::SliderFloat3("Obstacle size", glm::value_ptr(obstacleSize), 0.0f, 3.0f);
+				}
+				ImGui::Text("Compiled SPH variants: %zu", sph_variants.size());
+			}
+			if (fluidSolver != 0) {
+				if (fluidSolver == 1)
+					ImGui::SliderFloat("FLIP ratio", &flipRatio, 0.0f, 1.0f);
+				ImGui::SliderFloat("Grid cell size", &flipCellSize, 0.05f, 0.5f);
+				ImGui::SliderInt("Pressure iterations", &flipPressureIterations, 1, 200);
+				ImGui::Text("Grid: %d x %d x %d cells", flip_grid_size.x, flip_grid_size.y, flip_grid_size.z);
+				auto const pool_cell_bytes = flip_face_accumulator_stride + flip_face_stride + flip_cell_stride;
+				ImGui::Text("Bricks: %u used, %u in pool, %u in container", std::min(flip_requested_bricks, flip_brick_capacity), flip_brick_capacity, flip_page_count);
+				ImGui::Text("Steps with an overflowing pool: %u", flip_overflowed_steps);
+				ImGui::Text("Grid memory: %.1f KiB (dense: %.1f KiB)",
+				            flip_brick_capacity * flip_brick_cells * pool_cell_bytes / 1024.0f,
+				            flip_grid_size.x * flip_grid_size.y * flip_grid_size.z * pool_cell_bytes / 1024.0f);
+			}
 		}
 		ImGui::End();
 
+		if (ImGui::Begin("Buffer Inspector", nullptr, ImGuiWindowFlags_None))
+			buffer_inspector.render_ui();
+		ImGui::End();
+
 		if (show_basis)
 			bonobo::renderBasis(basis_thickness_scale, basis_length_scale, mCamera.GetWorldToClipMatrix());
 		if (show_logs)
@@ -89,12 +89,31 @@ namespace edaf80
 		GLuint createComputeShaderProgram(const std::string& computeShaderSource);
 		std::string readFile(const std::string& filePath);
 		ParticleSpawner3D spawner = ParticleSpawner3D();
+		// Members are 16-byte aligned to match the std430 layout of
+		// `particleParameters` in the compute shaders, where a vec3
+		// occupies a full vec4 slot.
 		struct alignas(16) particleParameter {
-			glm::vec3 position;
-			glm::vec3 velocity;
-			glm::vec3 predictedPosition;
+			alignas(16) glm::vec3 position;
+			alignas(16) glm::vec3 velocity;
+			alignas(16) glm::vec3 predictedPosition;
 			glm::vec4 density;
 		};
+		//! \brief Layout of the parameters read by glDrawElementsIndirect().
+		struct DrawElementsIndirectCommand {
+			GLuint count;
+			GLuint instanceCount;
+			GLuint firstIndex;
+			GLuint baseVertex;
+			GLuint baseInstance;
+		};
+		//! \brief Layout (std140) of `containerBlock` in the SPH and FLIP
+		//!        shaders, uploaded once per frame.
+		struct ContainerTransform {
+			glm::mat4 localToWorld;
+			glm::mat4 worldToLocal;
+			glm::vec4 linearVelocity;  //!< of the container origin, world space
+			glm::vec4 angularVelocity; //!< about the container origin, world space, in rad/s
+		};
 	private:
 		FPSCameraf     mCamera;
 		InputHandler   inputHandler;
@@ -116,9 +135,55 @@ namespace edaf80
 		float nearPressureMultiplier = 2.25f;
 		float viscosityStrength = 0.001f;
 
+		//GPU culling of the particle instances
+		bool useGpuCulling = true;
+		bool useCullingLod = true;
+		float lodPixelThreshold = 6.0f;
+
 		glm::mat4 localToWorld = glm::mat4(1.0);
 		glm::mat4 worldToLocal = glm::mat4(1.0);
 
+		//moving container: 0 = static, 1 = sloshing animation, 2 = tilted
+		//by dragging with the right mouse button
+		int containerMotion = 0;
+		float containerTiltAmplitude = 0.2f;//radians
+		float containerShakeAmplitude = 0.3f;
+		float containerFrequency = 0.5f;//Hz
+		float containerMouseSensitivity = 0.005f;//radians per pixel
+		float containerMaxTilt = 0.6f;
+
+		//periodic boundaries (per container axis) and rendering of the
+		//periodic images
+		glm::ivec3 periodicAxes = glm::ivec3(0);
+		bool showPeriodicImages = true;
+
+		//particle sleeping
+		bool enableSleeping = true;
+		float sleepVelocityThreshold = 0.25f;
+		float sleepDensityThreshold = 0.02f;
+		int sleepFrameCount = 30;
+		float activityCellSize = 0.2f;
+
+		//Verlet neighbour lists
+		bool useNeighbourList = false;
+		float neighbourSkin = 0.1f;
+		int maxNeighbours = 128;
+
+		//variant of the templated SPH shader (EDAF80/sph.comp); the
+		//obstacle lives in the local space of the container
+		int sphKernel = 0;
+		bool sphViscosity = true;
+		bool sphObstacles = false;
+		glm::vec3 obstacleCentre = glm::vec3(0.0f, -0.5f, 0.0f);
+		glm::vec3 obstacleSize = glm::vec3(1.0f, 1.0f, 1.0f);
+
+		//hybrid FLIP/APIC solver on a staggered grid over the container
+		//(0 = SPH, 1 = FLIP, 2 = APIC)
+		int fluidSolver = 0;
+		float flipRatio = 0.95f;
+		float flipCellSize = 0.1f;
+		int flipPressureIterations = 40;
+
 		float pi = 3.14159265359f;
 
 	};
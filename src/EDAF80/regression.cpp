@@ -0,0 +1,601 @@
+#include "sph_cpu.hpp"
+#include "sph_shader.hpp"
+
+#include "core/Bonobo.h"
+#include "core/FPSCamera.h"
+#include "core/InputHandler.h"
+#include "core/opengl.hpp"
+#include "core/various.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <clocale>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//! Golden-state regression harness for the SPH solvers.
+//!
+//! Every scenario starts from a fixed-seed particle block, runs a fixed
+//! number of steps and reduces the final particle state to statistics
+//! (centre of mass, energies, density histogram) which are compared with
+//! stored golden values within tolerances, since the GPU solvers are not
+//! bitwise reproducible. The runtime of each scenario is reported next to
+//! the one recorded with the golden state.
+//!
+//! A scenario without a golden file fails until one is recorded with
+//! --update, and so do the GPU scenarios when no OpenGL context can be
+//! created, unless they are explicitly left out with --cpu-only.
+
+#ifndef REGRESSION_GOLDEN_DIR
+#	define REGRESSION_GOLDEN_DIR "golden"
+#endif
+#ifndef SPH_SHADER_DIR
+#	define SPH_SHADER_DIR "shaders/EDAF80"
+#endif
+
+namespace
+{
+	std::size_t const histogram_bins = 16u;
+
+	//! \brief Final particle state, 2D scenarios leaving z at 0.
+	struct State {
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> velocities;
+		std::vector<float> densities;
+		double milliseconds = 0.0; //!< time spent in the steps only
+	};
+
+	struct Statistics {
+		std::uint32_t particles = 0u;
+		std::uint32_t non_finite = 0u;
+		glm::vec3 centre_of_mass = glm::vec3(0.0f);
+		float kinetic_energy = 0.0f;   //!< per particle
+		float potential_energy = 0.0f; //!< per particle, from the floor
+		std::array<float, histogram_bins> density_histogram = {}; //!< fractions of density / targetDensity over [0, 2)
+		double milliseconds = 0.0;
+	};
+
+	struct Tolerances {
+		float centre_of_mass;    //!< absolute, in world units
+		float energy;            //!< relative to the golden total energy
+		float histogram;         //!< L1 distance between the histograms
+	};
+
+	struct Scenario {
+		std::string name;
+		std::string description;
+		bool needs_gl;
+		std::uint32_t steps;
+		float delta_time;
+		float target_density;
+		float gravity;
+		float floor_height;
+		Tolerances tolerances;
+		std::function<State(Scenario const&)> run;
+	};
+
+	struct Options {
+		bool update = false;
+		bool cpu_only = false;
+		float max_slowdown = 0.0f; //!< 0 only reports the speed
+		std::string golden_directory = REGRESSION_GOLDEN_DIR;
+		std::string report_path;
+		std::vector<std::string> filters;
+	};
+
+	Statistics compute_statistics(Scenario const& scenario, State const& state)
+	{
+		Statistics statistics;
+		statistics.particles = static_cast<std::uint32_t>(state.positions.size());
+		statistics.milliseconds = state.milliseconds;
+
+		std::uint32_t finite = 0u;
+		glm::dvec3 centre_of_mass(0.0);
+		double kinetic = 0.0, potential = 0.0;
+		for (std::size_t i = 0u; i < state.positions.size(); ++i) {
+			auto const& position = state.positions[i];
+			auto const& velocity = state.velocities[i];
+			if (!std::isfinite(position.x + position.y + position.z + velocity.x + velocity.y + velocity.z)) {
+				++statistics.non_finite;
+				continue;
+			}
+			++finite;
+			centre_of_mass += glm::dvec3(position);
+			kinetic += 0.5 * glm::dot(velocity, velocity);
+			potential += -scenario.gravity * (position.y - scenario.floor_height);
+
+			float const relative_density = state.densities[i] / scenario.target_density;
+			auto const bin = static_cast<std::size_t>(glm::clamp(relative_density * 0.5f, 0.0f, 1.0f) * (histogram_bins - 1u) + 0.5f);
+			statistics.density_histogram[bin] += 1.0f;
+		}
+		if (finite > 0u) {
+			statistics.centre_of_mass = glm::vec3(centre_of_mass / static_cast<double>(finite));
+			statistics.kinetic_energy = static_cast<float>(kinetic / finite);
+			statistics.potential_energy = static_cast<float>(potential / finite);
+			for (auto& bin : statistics.density_histogram)
+				bin /= static_cast<float>(finite);
+		}
+		return statistics;
+	}
+
+	std::string golden_path(Options const& options, Scenario const& scenario)
+	{
+		return options.golden_directory + "/" + scenario.name + ".golden";
+	}
+
+	void write_golden(std::string const& path, Scenario const& scenario, Statistics const& statistics)
+	{
+		std::ofstream file(path);
+		if (!file)
+			throw std::runtime_error("Failed to write " + path);
+		file << std::setprecision(9)
+		     << "# " << scenario.description << ", " << scenario.steps << " steps\n"
+		     << "particles " << statistics.particles << "\n"
+		     << "centre_of_mass " << statistics.centre_of_mass.x << " " << statistics.centre_of_mass.y << " " << statistics.centre_of_mass.z << "\n"
+		     << "kinetic_energy " << statistics.kinetic_energy << "\n"
+		     << "potential_energy " << statistics.potential_energy << "\n"
+		     << "density_histogram";
+		for (auto const bin : statistics.density_histogram)
+			file << " " << bin;
+		file << "\n"
+		     << "milliseconds " << statistics.milliseconds << "\n";
+	}
+
+	bool read_golden(std::string const& path, Statistics& statistics)
+	{
+		std::ifstream file(path);
+		if (!file)
+			return false;
+		std::string line;
+		while (std::getline(file, line)) {
+			std::istringstream stream(line);
+			std::string key;
+			if (!(stream >> key) || key[0] == '#')
+				continue;
+			if (key == "particles")
+				stream >> statistics.particles;
+			else if (key == "centre_of_mass")
+				stream >> statistics.centre_of_mass.x >> statistics.centre_of_mass.y >> statistics.centre_of_mass.z;
+			else if (key == "kinetic_energy")
+				stream >> statistics.kinetic_energy;
+			else if (key == "potential_energy")
+				stream >> statistics.potential_energy;
+			else if (key == "density_histogram")
+				for (auto& bin : statistics.density_histogram)
+					stream >> bin;
+			else if (key == "milliseconds")
+				stream >> statistics.milliseconds;
+		}
+		return true;
+	}
+
+	struct Comparison {
+		float centre_of_mass_error = 0.0f;
+		float energy_error = 0.0f;
+		float histogram_distance = 0.0f;
+		std::vector<std::string> failures;
+	};
+
+	Comparison compare(Scenario const& scenario, Statistics const& golden, Statistics const& current)
+	{
+		Comparison comparison;
+		comparison.centre_of_mass_error = glm::length(current.centre_of_mass - golden.centre_of_mass);
+		float const golden_energy = golden.kinetic_energy + golden.potential_energy;
+		float const current_energy = current.kinetic_energy + current.potential_energy;
+		comparison.energy_error = std::abs(current_energy - golden_energy) / std::max(std::abs(golden_energy), 1e-6f);
+		for (std::size_t i = 0u; i < histogram_bins; ++i)
+			comparison.histogram_distance += std::abs(current.density_histogram[i] - golden.density_histogram[i]);
+
+		if (current.particles != golden.particles)
+			comparison.failures.push_back("particle count " + std::to_string(current.particles) + " != " + std::to_string(golden.particles));
+		if (current.non_finite != 0u)
+			comparison.failures.push_back(std::to_string(current.non_finite) + " non-finite particles");
+		if (!(comparison.centre_of_mass_error <= scenario.tolerances.centre_of_mass))
+			comparison.failures.push_back("centre of mass moved by " + std::to_string(comparison.centre_of_mass_error));
+		if (!(comparison.energy_error <= scenario.tolerances.energy))
+			comparison.failures.push_back("energy differs by " + std::to_string(comparison.energy_error * 100.0f) + "%");
+		if (!(comparison.histogram_distance <= scenario.tolerances.histogram))
+			comparison.failures.push_back("density histogram distance " + std::to_string(comparison.histogram_distance));
+		return comparison;
+	}
+
+	template<typename F>
+	double time_steps(F&& step, std::uint32_t steps)
+	{
+		auto const start = std::chrono::steady_clock::now();
+		for (std::uint32_t i = 0u; i < steps; ++i)
+			step();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	State run_cpu_2d(Scenario const& scenario)
+	{
+		sph_cpu::Parameters parameters;
+		parameters.gravity = scenario.gravity;
+		parameters.target_density = scenario.target_density;
+		// 2000 particles with the particle spacing of the 10000 of the project.
+		float const block_scale = std::sqrt(2000.0f / 10000.0f);
+		auto particles = sph_cpu::spawn_block(2000u, glm::vec2(2.0f, 0.5f) * block_scale, glm::vec2(7.0f, 5.0f) * block_scale, 0.025f, 1u);
+
+		sph_cpu::Solver solver;
+		State state;
+		state.milliseconds = time_steps([&]() { solver.step(particles, parameters, scenario.delta_time); }, scenario.steps);
+		for (auto const& particle : particles) {
+			state.positions.emplace_back(particle.position, 0.0f);
+			state.velocities.emplace_back(particle.velocity, 0.0f);
+			state.densities.push_back(particle.densities.x);
+		}
+		return state;
+	}
+
+	GLuint create_buffer(GLsizeiptr size, void const* data, std::string const& name)
+	{
+		GLuint buffer = 0u;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_COPY);
+		if (data == nullptr) {
+			GLuint const zero = 0u;
+			glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+		}
+		utils::opengl::debug::nameObject(GL_BUFFER, buffer, name);
+		return buffer;
+	}
+
+	GLuint create_compute_program(std::string const& path, sph_shader::Variant const& variant)
+	{
+		auto const source = utils::slurp_file(path);
+		if (source.empty())
+			throw std::runtime_error("Failed to read " + path);
+		auto const shader = utils::opengl::shader::generate_shader(GL_COMPUTE_SHADER, utils::opengl::shader::insert_defines(source, variant.defines()));
+		if (shader == 0u)
+			throw std::runtime_error("Failed to compile " + path);
+		auto const program = utils::opengl::shader::generate_program({ shader });
+		glDeleteShader(shader);
+		if (program == 0u)
+			throw std::runtime_error("Failed to link " + path);
+		return program;
+	}
+
+	//! \brief Step a GPU solver with sleeping, neighbour lists and the mouse
+	//!        interaction disabled; the auxiliary buffers are still bound
+	//!        since the shaders declare them.
+	template<typename Particle, typename SetUniforms>
+	std::vector<Particle> run_gpu_solver(Scenario const& scenario, sph_shader::Variant variant, std::vector<Particle> const& initial,
+	                                     SetUniforms const& set_uniforms, double& milliseconds)
+	{
+		variant.particle_capacity = static_cast<std::uint32_t>(initial.size());
+		auto const program = create_compute_program(std::string(SPH_SHADER_DIR) + "/sph.comp", variant);
+		auto const work_groups = variant.work_group_count();
+		auto const count = static_cast<GLsizeiptr>(initial.size());
+		GLuint const buffers[] = {
+			create_buffer(count * sizeof(Particle), initial.data(), "Regression particles"),
+			create_buffer(count * sizeof(GLuint), nullptr, "Regression sleep counters"),
+			create_buffer(2 * sizeof(GLuint), nullptr, "Regression activity cells"),
+			create_buffer(2 * 4 * sizeof(GLuint), nullptr, "Regression neighbour statistics"),
+			0u,
+			create_buffer(2 * sizeof(GLuint), nullptr, "Regression activity counters"),
+			create_buffer(count * 4 * sizeof(GLuint), nullptr, "Regression neighbour states"),
+			create_buffer(sizeof(GLuint), nullptr, "Regression neighbour indices"),
+		};
+		for (GLuint binding = 0u; binding < 8u; ++binding)
+			if (buffers[binding] != 0u)
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffers[binding]);
+
+		glUseProgram(program);
+		set_uniforms(program);
+		glUniform1f(glGetUniformLocation(program, "deltaTime"), scenario.delta_time);
+		glUniform1f(glGetUniformLocation(program, "gravity"), scenario.gravity);
+		glUniform1f(glGetUniformLocation(program, "targetDensity"), scenario.target_density);
+		glUniform1f(glGetUniformLocation(program, "interactionInputStrength"), 0.0f);
+		glUniform1i(glGetUniformLocation(program, "enableSleeping"), 0);
+		glUniform1i(glGetUniformLocation(program, "useNeighbourList"), 0);
+		glUniform1ui(glGetUniformLocation(program, "maxNeighbours"), 0u);
+		glUniform1ui(glGetUniformLocation(program, "activityCounterSlot"), 0u);
+		glUniform1ui(glGetUniformLocation(program, "neighbourWriteSlot"), 0u);
+		glUniform1ui(glGetUniformLocation(program, "neighbourReadSlot"), 1u);
+
+		// Wait for the last dispatch inside the timed loop, so that the
+		// timing covers the GPU work and not only its submission.
+		glFinish();
+		std::uint32_t step = 0u;
+		milliseconds = time_steps([work_groups, &step, &scenario]() {
+			glDispatchCompute(work_groups, 1, 1);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+			if (++step == scenario.steps)
+				glFinish();
+		}, scenario.steps);
+
+		std::vector<Particle> particles(initial.size());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[0]);
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(Particle), particles.data());
+
+		glUseProgram(0u);
+		for (GLuint binding = 0u; binding < 8u; ++binding)
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0u);
+		for (auto const buffer : buffers)
+			if (buffer != 0u)
+				glDeleteBuffers(1, &buffer);
+		glDeleteProgram(program);
+		return particles;
+	}
+
+	//! \brief Particle layout of the 2D variants of sph.comp.
+	struct GpuParticle2D {
+		glm::vec2 position;
+		glm::vec2 velocity;
+		glm::vec2 predicted_position;
+		glm::vec2 densities;
+		glm::uvec4 unused;
+	};
+
+	State run_gpu_2d(Scenario const& scenario)
+	{
+		std::vector<GpuParticle2D> initial;
+		for (auto const& particle : sph_cpu::spawn_block(10000u, glm::vec2(2.0f, 0.5f), glm::vec2(7.0f, 5.0f), 0.025f, 1u)) {
+			GpuParticle2D gpu_particle = {};
+			gpu_particle.position = particle.position;
+			gpu_particle.predicted_position = particle.position;
+			initial.push_back(gpu_particle);
+		}
+
+		State state;
+		sph_shader::Variant variant;
+		variant.dimensions = 2u;
+		auto const particles = run_gpu_solver(scenario, variant, initial, [](GLuint program) {
+			glUniform1f(glGetUniformLocation(program, "collisionDamping"), 0.8f);
+			glUniform2fv(glGetUniformLocation(program, "boundsSize"), 1, glm::value_ptr(glm::vec2(17.1f, 9.0f)));
+			glUniform1f(glGetUniformLocation(program, "smoothingRadius"), 0.35f);
+			glUniform1f(glGetUniformLocation(program, "pressureMultiplier"), 500.0f);
+			glUniform1f(glGetUniformLocation(program, "nearPressureMultiplier"), 18.0f);
+			glUniform1f(glGetUniformLocation(program, "viscosityStrength"), 0.06f);
+			glUniform2iv(glGetUniformLocation(program, "periodicAxes"), 1, glm::value_ptr(glm::ivec2(0)));
+		}, state.milliseconds);
+		for (auto const& particle : particles) {
+			state.positions.emplace_back(particle.position, 0.0f);
+			state.velocities.emplace_back(particle.velocity, 0.0f);
+			state.densities.push_back(particle.densities.x);
+		}
+		return state;
+	}
+
+	//! \brief Particle layout of the 3D variants of sph.comp (vec3 padded
+	//!        to 16 bytes).
+	struct GpuParticle3D {
+		glm::vec4 position;
+		glm::vec4 velocity;
+		glm::vec4 predicted_position;
+		glm::vec4 densities;
+	};
+
+	State run_gpu_3d(Scenario const& scenario)
+	{
+		// Same 25^3 lattice as ParticleSpawner3D, at rest.
+		int const per_axis = 25;
+		glm::vec3 const centre(0.0f, -0.47f, 0.0f);
+		float const size = 3.7f;
+		std::vector<GpuParticle3D> initial;
+		for (int x = 0; x < per_axis; ++x)
+			for (int y = 0; y < per_axis; ++y)
+				for (int z = 0; z < per_axis; ++z) {
+					auto const t = glm::vec3(x, y, z) / (per_axis - 1.0f);
+					GpuParticle3D particle = {};
+					particle.position = glm::vec4((t - 0.5f) * size + centre, 0.0f);
+					particle.predicted_position = particle.position;
+					initial.push_back(particle);
+				}
+
+		State state;
+		sph_shader::Variant variant;
+		variant.dimensions = 3u;
+		variant.interaction = false;
+
+		// A container at rest at the origin (containerBlock in sph.comp).
+		struct {
+			glm::mat4 local_to_world = glm::mat4(1.0f);
+			glm::mat4 world_to_local = glm::mat4(1.0f);
+			glm::vec4 linear_velocity = glm::vec4(0.0f);
+			glm::vec4 angular_velocity = glm::vec4(0.0f);
+		} const container;
+		GLuint container_buffer = 0u;
+		glGenBuffers(1, &container_buffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, container_buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(container), &container, GL_STATIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0u);
+		glBindBufferBase(GL_UNIFORM_BUFFER, 0u, container_buffer);
+
+		auto const particles = run_gpu_solver(scenario, variant, initial, [](GLuint program) {
+			glUniform1f(glGetUniformLocation(program, "collisionDamping"), 0.8f);
+			glUniform3fv(glGetUniformLocation(program, "boundsSize"), 1, glm::value_ptr(glm::vec3(4.6f, 2.16f, 5.0f)));
+			glUniform1f(glGetUniformLocation(program, "smoothingRadius"), 5.2f);
+			glUniform1f(glGetUniformLocation(program, "pressureMultiplier"), 288.0f);
+			glUniform1f(glGetUniformLocation(program, "nearPressureMultiplier"), 2.25f);
+			glUniform1f(glGetUniformLocation(program, "viscosityStrength"), 0.001f);
+			glUniform3iv(glGetUniformLocation(program, "periodicAxes"), 1, glm::value_ptr(glm::ivec3(0)));
+		}, state.milliseconds);
+		glBindBufferBase(GL_UNIFORM_BUFFER, 0u, 0u);
+		glDeleteBuffers(1, &container_buffer);
+		for (auto const& particle : particles) {
+			state.positions.emplace_back(particle.position);
+			state.velocities.emplace_back(particle.velocity);
+			state.densities.push_back(particle.densities.x);
+		}
+		return state;
+	}
+
+	std::vector<Scenario> make_scenarios()
+	{
+		return {
+			{ "cpu2d_dam_break", "CPU port of the 2D solver, 2000 particles", false,
+			  600u, 1.0f / 120.0f, 55.0f, -6.0f, -4.5f, { 0.05f, 0.05f, 0.1f }, run_cpu_2d },
+			{ "gpu2d_dam_break", "2D sph.comp, 10000 particles", true,
+			  600u, 1.0f / 120.0f, 55.0f, -6.0f, -4.5f, { 0.15f, 0.1f, 0.2f }, run_gpu_2d },
+			{ "gpu3d_dam_break", "3D sph.comp, 15625 particles", true,
+			  300u, 1.0f / 120.0f, 630.0f, -10.0f, -1.08f, { 0.1f, 0.1f, 0.2f }, run_gpu_3d },
+		};
+	}
+
+	void print_usage(char const* executable)
+	{
+		std::cout << "Usage: " << executable << " [options] [scenario...]\n"
+		          << "  --update              record the current results as golden state\n"
+		          << "  --cpu-only            skip the scenarios needing an OpenGL context\n"
+		          << "  --golden-dir DIR      directory of the golden files (default " << REGRESSION_GOLDEN_DIR << ")\n"
+		          << "  --report FILE         also write the report as CSV\n"
+		          << "  --max-slowdown X      fail scenarios more than X times slower than their golden run\n"
+		          << "Scenarios:";
+		for (auto const& scenario : make_scenarios())
+			std::cout << " " << scenario.name;
+		std::cout << std::endl;
+	}
+
+	Options parse_options(int argc, char* argv[])
+	{
+		Options options;
+		for (int i = 1; i < argc; ++i) {
+			std::string const option = argv[i];
+			bool const has_value = i + 1 < argc;
+			if (option == "--update")
+				options.update = true;
+			else if (option == "--cpu-only")
+				options.cpu_only = true;
+			else if (option == "--golden-dir" && has_value)
+				options.golden_directory = argv[++i];
+			else if (option == "--report" && has_value)
+				options.report_path = argv[++i];
+			else if (option == "--max-slowdown" && has_value)
+				options.max_slowdown = std::stof(argv[++i]);
+			else if (option.compare(0, 2, "--") != 0)
+				options.filters.push_back(option);
+			else
+				throw std::invalid_argument("Unknown option " + option);
+		}
+		return options;
+	}
+
+	int run(Options const& options, WindowManager& window_manager)
+	{
+		auto scenarios = make_scenarios();
+		if (!options.filters.empty())
+			scenarios.erase(std::remove_if(scenarios.begin(), scenarios.end(), [&options](Scenario const& scenario) {
+				return std::find(options.filters.begin(), options.filters.end(), scenario.name) == options.filters.end();
+			}), scenarios.end());
+
+		// A hidden window provides the context of the GPU scenarios.
+		GLFWwindow* window = nullptr;
+		InputHandler input_handler;
+		FPSCameraf camera(0.5f * glm::half_pi<float>(), 1.0f, 0.01f, 1000.0f);
+		bool const needs_gl = !options.cpu_only && std::any_of(scenarios.begin(), scenarios.end(), [](Scenario const& scenario) { return scenario.needs_gl; });
+		if (needs_gl) {
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			WindowManager::WindowDatum window_datum{ input_handler, camera, 64, 64, 0, 0, 0, 0 };
+			window = window_manager.CreateGLFWWindow("EDAN35: regression", window_datum, 1u);
+			if (window == nullptr)
+				std::cerr << "No OpenGL context available: the GPU scenarios fail, run with --cpu-only to skip them" << std::endl;
+		}
+
+		std::ofstream report;
+		if (!options.report_path.empty()) {
+			report.open(options.report_path);
+			if (!report)
+				throw std::runtime_error("Failed to create " + options.report_path);
+			report << "scenario,status,steps,milliseconds,ms_per_step,golden_milliseconds,speedup,centre_of_mass_error,energy_error,histogram_distance\n";
+		}
+
+		bool all_passed = true;
+		std::cout << std::left << std::setw(18) << "scenario" << std::setw(10) << "status" << std::right
+		          << std::setw(12) << "ms/step" << std::setw(10) << "speedup" << std::setw(12) << "com err"
+		          << std::setw(12) << "energy err" << std::setw(12) << "hist dist" << std::endl;
+		for (auto const& scenario : scenarios) {
+			std::string status;
+			std::string note;
+			Comparison comparison;
+			Statistics golden, current;
+			bool const has_golden = read_golden(golden_path(options, scenario), golden);
+			if (scenario.needs_gl && options.cpu_only) {
+				status = "skipped";
+				note = "needs an OpenGL context, left out by --cpu-only";
+			}
+			else if (scenario.needs_gl && window == nullptr) {
+				status = "FAIL";
+				comparison.failures.push_back("no OpenGL context available");
+			}
+			else if (!has_golden && !options.update) {
+				status = "FAIL";
+				comparison.failures.push_back("no golden state, run with --update to record one");
+			}
+			else {
+				current = compute_statistics(scenario, scenario.run(scenario));
+				if (options.update) {
+					write_golden(golden_path(options, scenario), scenario, current);
+					status = "updated";
+				}
+				else {
+					comparison = compare(scenario, golden, current);
+					if (options.max_slowdown > 0.0f && current.milliseconds > golden.milliseconds * options.max_slowdown)
+						comparison.failures.push_back("slower than the golden run by more than " + std::to_string(options.max_slowdown) + "x");
+					status = comparison.failures.empty() ? "pass" : "FAIL";
+				}
+			}
+			all_passed = all_passed && comparison.failures.empty();
+
+			double const ms_per_step = current.milliseconds / scenario.steps;
+			double const speedup = has_golden && current.milliseconds > 0.0 ? golden.milliseconds / current.milliseconds : 0.0;
+			std::cout << std::left << std::setw(18) << scenario.name << std::setw(10) << status << std::right << std::fixed
+			          << std::setprecision(3) << std::setw(12) << ms_per_step << std::setw(9) << speedup << "x"
+			          << std::setprecision(4) << std::setw(12) << comparison.centre_of_mass_error
+			          << std::setw(12) << comparison.energy_error << std::setw(12) << comparison.histogram_distance << std::endl;
+			if (!note.empty())
+				std::cout << "    " << note << std::endl;
+			for (auto const& failure : comparison.failures)
+				std::cout << "    " << failure << std::endl;
+			if (report)
+				report << scenario.name << "," << status << "," << scenario.steps << "," << current.milliseconds << "," << ms_per_step
+				       << "," << golden.milliseconds << "," << speedup << "," << comparison.centre_of_mass_error
+				       << "," << comparison.energy_error << "," << comparison.histogram_distance << "\n";
+		}
+
+		if (window != nullptr)
+			window_manager.DestroyWindow(window);
+		return all_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::setlocale(LC_ALL, "");
+
+	Options options;
+	try {
+		options = parse_options(argc, argv);
+	}
+	catch (std::exception const& e) {
+		std::cerr << e.what() << std::endl;
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	Bonobo framework;
+
+	try {
+		return run(options, framework.GetWindowManager());
+	}
+	catch (std::runtime_error const& e) {
+		LogError(e.what());
+		return EXIT_FAILURE;
+	}
+}
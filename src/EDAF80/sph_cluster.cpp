@@ -0,0 +1,369 @@
+#include "sph_cluster.hpp"
+
+#if defined(_WIN32)
+#	include <winsock2.h>
+#	include <ws2tcpip.h>
+#else
+#	include <arpa/inet.h>
+#	include <netdb.h>
+#	include <netinet/in.h>
+#	include <netinet/tcp.h>
+#	include <sys/select.h>
+#	include <sys/socket.h>
+#	include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+#if defined(_WIN32)
+	using native_socket = SOCKET;
+	using io_size = int;
+	int const send_flags = 0;
+	void close_native(native_socket socket) { closesocket(socket); }
+#else
+	using native_socket = int;
+	using io_size = std::size_t;
+	// Report a closed peer as an error instead of raising SIGPIPE.
+#	if defined(MSG_NOSIGNAL)
+	int const send_flags = MSG_NOSIGNAL;
+#	else
+	int const send_flags = 0;
+#	endif
+	void close_native(native_socket socket) { ::close(socket); }
+#endif
+
+	std::uintptr_t const invalid_handle = ~std::uintptr_t(0);
+
+	native_socket to_native(std::uintptr_t handle)
+	{
+		return static_cast<native_socket>(handle);
+	}
+
+	std::uintptr_t from_native(native_socket socket)
+	{
+		return static_cast<std::uintptr_t>(socket);
+	}
+
+	bool is_native_valid(native_socket socket)
+	{
+#if defined(_WIN32)
+		return socket != INVALID_SOCKET;
+#else
+		return socket >= 0;
+#endif
+	}
+
+	void set_no_delay(native_socket socket)
+	{
+		// Halo exchanges are latency bound: do not wait to coalesce them.
+		int const enabled = 1;
+		setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char const*>(&enabled), sizeof(enabled));
+	}
+
+	struct MessageHeader {
+		sph_cluster::MessageType type;
+		std::uint32_t padding;
+		std::uint64_t size;
+	};
+}
+
+sph_cluster::NetworkSession::NetworkSession()
+{
+#if defined(_WIN32)
+	WSADATA data;
+	if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+		throw std::runtime_error("Failed to initialise Winsock");
+#endif
+}
+
+sph_cluster::NetworkSession::~NetworkSession()
+{
+#if defined(_WIN32)
+	WSACleanup();
+#endif
+}
+
+sph_cluster::Socket::Socket(std::uintptr_t handle) : _handle(handle)
+{
+}
+
+sph_cluster::Socket::~Socket()
+{
+	close();
+}
+
+sph_cluster::Socket::Socket(Socket&& other) noexcept : _handle(other._handle)
+{
+	other._handle = invalid_handle;
+}
+
+sph_cluster::Socket&
+sph_cluster::Socket::operator=(Socket&& other) noexcept
+{
+	if (this != &other) {
+		close();
+		std::swap(_handle, other._handle);
+	}
+	return *this;
+}
+
+sph_cluster::Socket
+sph_cluster::Socket::connect(std::string const& host, std::uint16_t port)
+{
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	addrinfo* addresses = nullptr;
+	auto const port_string = std::to_string(port);
+	if (getaddrinfo(host.c_str(), port_string.c_str(), &hints, &addresses) != 0 || addresses == nullptr)
+		throw std::runtime_error("Failed to resolve " + host);
+
+	Socket connection;
+	for (auto address = addresses; address != nullptr; address = address->ai_next) {
+		auto const socket = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (!is_native_valid(socket))
+			continue;
+		if (::connect(socket, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0) {
+			set_no_delay(socket);
+			connection = Socket(from_native(socket));
+			break;
+		}
+		close_native(socket);
+	}
+	freeaddrinfo(addresses);
+
+	if (!connection.is_valid())
+		throw std::runtime_error("Failed to connect to " + host + ":" + port_string);
+	return connection;
+}
+
+bool
+sph_cluster::Socket::is_valid() const
+{
+	return is_native_valid(to_native(_handle));
+}
+
+void
+sph_cluster::Socket::close()
+{
+	if (is_valid())
+		close_native(to_native(_handle));
+	_handle = invalid_handle;
+}
+
+void
+sph_cluster::Socket::send_all(void const* data, std::size_t size)
+{
+	auto bytes = static_cast<char const*>(data);
+	while (size > 0u) {
+		auto const sent = ::send(to_native(_handle), bytes, static_cast<io_size>(std::min<std::size_t>(size, 1u << 30)), send_flags);
+		if (sent <= 0)
+			throw std::runtime_error("Connection lost while sending");
+		bytes += sent;
+		size -= static_cast<std::size_t>(sent);
+	}
+}
+
+void
+sph_cluster::Socket::receive_all(void* data, std::size_t size)
+{
+	auto bytes = static_cast<char*>(data);
+	while (size > 0u) {
+		auto const received = ::recv(to_native(_handle), bytes, static_cast<io_size>(std::min<std::size_t>(size, 1u << 30)), 0);
+		if (received <= 0)
+			throw std::runtime_error("Connection lost while receiving");
+		bytes += received;
+		size -= static_cast<std::size_t>(received);
+	}
+}
+
+bool
+sph_cluster::Socket::wait_readable(int timeout_ms) const
+{
+	if (!is_valid())
+		return false;
+	auto const socket = to_native(_handle);
+	fd_set readable;
+	FD_ZERO(&readable);
+	FD_SET(socket, &readable);
+	timeval timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+	return select(static_cast<int>(socket + 1), &readable, nullptr, nullptr, &timeout) > 0;
+}
+
+std::string
+sph_cluster::Socket::peer_host() const
+{
+	sockaddr_storage address = {};
+	socklen_t length = sizeof(address);
+	if (getpeername(to_native(_handle), reinterpret_cast<sockaddr*>(&address), &length) != 0)
+		throw std::runtime_error("Failed to query the peer address");
+	char host[NI_MAXHOST];
+	if (getnameinfo(reinterpret_cast<sockaddr*>(&address), length, host, sizeof(host), nullptr, 0, NI_NUMERICHOST) != 0)
+		throw std::runtime_error("Failed to format the peer address");
+	return host;
+}
+
+sph_cluster::Listener::Listener(std::uint16_t port)
+{
+	auto const socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (!is_native_valid(socket))
+		throw std::runtime_error("Failed to create a listening socket");
+	_socket = Socket(from_native(socket));
+
+	int const reuse = 1;
+	setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char const*>(&reuse), sizeof(reuse));
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+	if (bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+	    || listen(socket, SOMAXCONN) != 0)
+		throw std::runtime_error("Failed to listen on port " + std::to_string(port));
+}
+
+sph_cluster::Socket
+sph_cluster::Listener::accept()
+{
+	auto const socket = ::accept(to_native(_socket.handle()), nullptr, nullptr);
+	if (!is_native_valid(socket))
+		throw std::runtime_error("Failed to accept a connection");
+	set_no_delay(socket);
+	return Socket(from_native(socket));
+}
+
+sph_cluster::MessageWriter&
+sph_cluster::MessageWriter::write_string(std::string const& value)
+{
+	return write_vector(std::vector<char>(value.begin(), value.end()));
+}
+
+std::string
+sph_cluster::MessageReader::read_string()
+{
+	auto const characters = read_vector<char>();
+	return std::string(characters.begin(), characters.end());
+}
+
+std::uint8_t const*
+sph_cluster::MessageReader::consume(std::size_t size)
+{
+	if (size > _bytes.size() - _offset)
+		throw std::runtime_error("Truncated cluster message");
+	auto const data = _bytes.data() + _offset;
+	_offset += size;
+	return data;
+}
+
+void
+sph_cluster::send_message(Socket& socket, MessageType type, std::vector<std::uint8_t> const& payload)
+{
+	MessageHeader const header = { type, 0u, payload.size() };
+	socket.send_all(&header, sizeof(header));
+	if (!payload.empty())
+		socket.send_all(payload.data(), payload.size());
+}
+
+sph_cluster::Message
+sph_cluster::receive_message(Socket& socket)
+{
+	MessageHeader header;
+	socket.receive_all(&header, sizeof(header));
+	Message message;
+	message.type = header.type;
+	message.payload.resize(static_cast<std::size_t>(header.size));
+	if (!message.payload.empty())
+		socket.receive_all(message.payload.data(), message.payload.size());
+	return message;
+}
+
+sph_cluster::Message
+sph_cluster::expect_message(Socket& socket, MessageType type)
+{
+	auto message = receive_message(socket);
+	if (message.type != type)
+		throw std::runtime_error("Unexpected cluster message " + std::to_string(static_cast<std::uint32_t>(message.type))
+		                         + " instead of " + std::to_string(static_cast<std::uint32_t>(type)));
+	return message;
+}
+
+std::vector<float>
+sph_cluster::uniform_boundaries(std::uint32_t slab_count, float domain_width)
+{
+	std::vector<float> boundaries(slab_count + 1u);
+	for (std::uint32_t i = 0u; i <= slab_count; ++i)
+		boundaries[i] = domain_width * (static_cast<float>(i) / slab_count - 0.5f);
+	return boundaries;
+}
+
+void
+sph_cluster::rebalance_boundaries(std::vector<float>& boundaries, std::vector<double> const& step_times, float min_width, float max_shift)
+{
+	// Proportional controller on the relative time difference of the two
+	// slabs sharing each boundary: the slower one gives away up to a
+	// quarter of the narrower width per call.
+	float const gain = 0.25f;
+	for (std::size_t i = 1u; i + 1u < boundaries.size(); ++i) {
+		double const total = step_times[i - 1u] + step_times[i];
+		if (total <= 0.0)
+			continue;
+		float const imbalance = static_cast<float>((step_times[i - 1u] - step_times[i]) / total);
+		float const narrower = std::min(boundaries[i] - boundaries[i - 1u], boundaries[i + 1u] - boundaries[i]);
+		float const shift = glm::clamp(-imbalance * gain * narrower, -max_shift, max_shift);
+		boundaries[i] = glm::clamp(boundaries[i] + shift, boundaries[i - 1u] + min_width, boundaries[i + 1u] - min_width);
+	}
+}
+
+std::uint32_t
+sph_cluster::slab_of(std::vector<float> const& boundaries, float x)
+{
+	auto const interior_begin = boundaries.begin() + 1;
+	auto const interior_end = boundaries.end() - 1;
+	return static_cast<std::uint32_t>(std::upper_bound(interior_begin, interior_end, x) - interior_begin);
+}
+
+void
+sph_cluster::ViewerClient::connect(std::string const& host, std::uint16_t port)
+{
+	_socket = Socket::connect(host, port);
+	send_message(_socket, MessageType::hello, MessageWriter().write(Role::viewer).bytes());
+}
+
+void
+sph_cluster::ViewerClient::disconnect()
+{
+	_socket.close();
+}
+
+bool
+sph_cluster::ViewerClient::poll(Snapshot& snapshot)
+{
+	bool updated = false;
+	try {
+		while (_socket.wait_readable(0)) {
+			auto const message = receive_message(_socket);
+			if (message.type == MessageType::shutdown) {
+				_socket.close();
+				break;
+			}
+			if (message.type != MessageType::snapshot)
+				continue;
+			MessageReader reader(message.payload);
+			snapshot.step = reader.read<std::uint64_t>();
+			snapshot.boundaries = reader.read_vector<float>();
+			snapshot.positions = reader.read_vector<glm::vec2>();
+			snapshot.velocities = reader.read_vector<glm::vec2>();
+			updated = true;
+		}
+	}
+	catch (std::runtime_error const&) {
+		_socket.close();
+	}
+	return updated;
+}
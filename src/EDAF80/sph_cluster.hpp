@@ -0,0 +1,211 @@
+#pragma once
+
+#include "sph_cpu.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//! \brief Slab decomposition of the CPU SPH solver over several processes.
+//!
+//! A coordinator splits the domain along x into one slab per worker
+//! process; workers talk to their left and right neighbours over TCP to
+//! migrate particles and exchange halos, and the coordinator moves the
+//! slab boundaries to balance the measured step times. Viewers connect to
+//! the coordinator and only ever receive snapshots.
+namespace sph_cluster
+{
+	std::uint16_t const default_port = 47300;
+
+	//! \brief Keeps the platform socket library initialised (WSAStartup on
+	//!        Windows, nothing elsewhere) for as long as it is alive.
+	class NetworkSession {
+	public:
+		NetworkSession();
+		~NetworkSession();
+		NetworkSession(NetworkSession const&) = delete;
+		NetworkSession& operator=(NetworkSession const&) = delete;
+	};
+
+	//! \brief Blocking TCP stream; all errors are reported by throwing
+	//!        std::runtime_error.
+	class Socket {
+	public:
+		Socket() = default;
+		explicit Socket(std::uintptr_t handle);
+		~Socket();
+		Socket(Socket&& other) noexcept;
+		Socket& operator=(Socket&& other) noexcept;
+		Socket(Socket const&) = delete;
+		Socket& operator=(Socket const&) = delete;
+
+		static Socket connect(std::string const& host, std::uint16_t port);
+
+		bool is_valid() const;
+		void close();
+		void send_all(void const* data, std::size_t size);
+		void receive_all(void* data, std::size_t size);
+
+		//! \brief Wait up to |timeout_ms| milliseconds (0 to poll) for data
+		//!        or an incoming connection to be available.
+		bool wait_readable(int timeout_ms) const;
+
+		//! \brief Numeric address of the remote end.
+		std::string peer_host() const;
+
+		std::uintptr_t handle() const { return _handle; }
+
+	private:
+		std::uintptr_t _handle = ~std::uintptr_t(0);
+	};
+
+	//! \brief Listening socket bound to |port| on all interfaces.
+	class Listener {
+	public:
+		explicit Listener(std::uint16_t port);
+		Socket accept();
+		bool has_pending(int timeout_ms) const { return _socket.wait_readable(timeout_ms); }
+
+	private:
+		Socket _socket;
+	};
+
+	enum class MessageType : std::uint32_t {
+		hello,       //!< role of the connecting process
+		assignment,  //!< rank, peers, parameters and initial particles of a worker
+		ready,       //!< worker listens for its right neighbour
+		start,       //!< all workers are ready, connect to the neighbours
+		step,        //!< step index, time step, slab boundaries, snapshot request
+		step_result, //!< particle count, compute time and optional snapshot data
+		exchange,    //!< particles or densities sent to a neighbouring slab
+		snapshot,    //!< gathered state sent to the viewers
+		shutdown
+	};
+
+	enum class Role : std::uint32_t {
+		worker,
+		viewer
+	};
+
+	//! \brief Appends trivially-copyable values to a message payload.
+	class MessageWriter {
+	public:
+		template<typename T>
+		MessageWriter& write(T const& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be sent");
+			auto const offset = _bytes.size();
+			_bytes.resize(offset + sizeof(T));
+			std::memcpy(_bytes.data() + offset, &value, sizeof(T));
+			return *this;
+		}
+
+		template<typename T>
+		MessageWriter& write_vector(std::vector<T> const& values)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be sent");
+			write(static_cast<std::uint64_t>(values.size()));
+			auto const offset = _bytes.size();
+			_bytes.resize(offset + values.size() * sizeof(T));
+			if (!values.empty())
+				std::memcpy(_bytes.data() + offset, values.data(), values.size() * sizeof(T));
+			return *this;
+		}
+
+		MessageWriter& write_string(std::string const& value);
+
+		std::vector<std::uint8_t> const& bytes() const { return _bytes; }
+
+	private:
+		std::vector<std::uint8_t> _bytes;
+	};
+
+	//! \brief Reads back what a MessageWriter wrote, in the same order.
+	class MessageReader {
+	public:
+		explicit MessageReader(std::vector<std::uint8_t> const& bytes) : _bytes(bytes) {}
+
+		template<typename T>
+		T read()
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be received");
+			T value;
+			std::memcpy(&value, consume(sizeof(T)), sizeof(T));
+			return value;
+		}
+
+		template<typename T>
+		std::vector<T> read_vector()
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be received");
+			auto const count = read<std::uint64_t>();
+			if (count > (_bytes.size() - _offset) / sizeof(T))
+				throw std::runtime_error("Truncated cluster message");
+			std::vector<T> values(static_cast<std::size_t>(count));
+			if (count != 0u)
+				std::memcpy(values.data(), consume(values.size() * sizeof(T)), values.size() * sizeof(T));
+			return values;
+		}
+
+		std::string read_string();
+
+	private:
+		std::uint8_t const* consume(std::size_t size);
+
+		std::vector<std::uint8_t> const& _bytes;
+		std::size_t _offset = 0u;
+	};
+
+	struct Message {
+		MessageType type;
+		std::vector<std::uint8_t> payload;
+	};
+
+	void send_message(Socket& socket, MessageType type, std::vector<std::uint8_t> const& payload = {});
+	Message receive_message(Socket& socket);
+
+	//! \brief Receive a message and throw if it is not of type |type|.
+	Message expect_message(Socket& socket, MessageType type);
+
+	//! \brief |slab_count| + 1 boundaries splitting [-width/2, width/2]
+	//!        into slabs of equal width.
+	std::vector<float> uniform_boundaries(std::uint32_t slab_count, float domain_width);
+
+	//! \brief Move the interior boundaries so that slabs that took longer
+	//!        than their neighbour shrink, by at most |max_shift| per call
+	//!        and never below |min_width|.
+	void rebalance_boundaries(std::vector<float>& boundaries, std::vector<double> const& step_times, float min_width, float max_shift);
+
+	//! \brief Index of the slab containing |x|, the outer slabs extending
+	//!        to infinity.
+	std::uint32_t slab_of(std::vector<float> const& boundaries, float x);
+
+	struct Snapshot {
+		std::uint64_t step = 0u;
+		std::vector<float> boundaries;
+		std::vector<glm::vec2> positions;
+		std::vector<glm::vec2> velocities;
+	};
+
+	//! \brief Read-only connection of a viewer to a running coordinator.
+	class ViewerClient {
+	public:
+		void connect(std::string const& host, std::uint16_t port);
+		void disconnect();
+		bool is_connected() const { return _socket.is_valid(); }
+
+		//! \brief Drain the pending snapshots without blocking; returns
+		//!        true if |snapshot| was replaced by a newer one. The
+		//!        connection is closed if the coordinator went away.
+		bool poll(Snapshot& snapshot);
+
+	private:
+		NetworkSession _session;
+		Socket _socket;
+	};
+}
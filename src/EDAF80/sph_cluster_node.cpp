@@ -0,0 +1,465 @@
+#include "sph_cluster.hpp"
+#include "sph_cpu.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	struct Options {
+		std::string mode;
+		std::string host = "127.0.0.1";
+		std::uint16_t port = sph_cluster::default_port;
+		std::uint32_t workers = 2u;
+		std::uint32_t particle_count = 10000u;
+		std::uint64_t steps = 0u; //!< 0 runs until the process is killed
+		float delta_time = 1.0f / 120.0f;
+		std::uint32_t snapshot_interval = 2u;
+		std::uint32_t report_interval = 600u;
+		bool spawn_workers = false;
+		std::string executable;
+	};
+
+	//! \brief Extra distance on top of the smoothing radius when selecting
+	//!        halo particles, as fraction of the smoothing radius: the
+	//!        predicted positions used by the neighbour search may have
+	//!        crossed the slab boundary by a fraction of a cell.
+	float const halo_margin = 0.25f;
+
+	void print_usage(char const* executable)
+	{
+		std::cout << "Usage:\n"
+		          << "  " << executable << " coordinator [--port P] [--workers N] [--particles K] [--steps S]\n"
+		          << "                 [--dt T] [--snapshot-interval I] [--spawn]\n"
+		          << "  " << executable << " worker [--host H] [--port P]\n"
+		          << "\n"
+		          << "Workers connect to the coordinator at H:P and listen for their right\n"
+		          << "neighbour on P+1+rank. Viewers (EDAN35_project) attach to H:P.\n";
+	}
+
+	Options parse_options(int argc, char* argv[])
+	{
+		Options options;
+		options.executable = argv[0];
+		if (argc < 2)
+			throw std::invalid_argument("Missing mode");
+		options.mode = argv[1];
+		if (options.mode != "coordinator" && options.mode != "worker")
+			throw std::invalid_argument("Unknown mode " + options.mode);
+
+		for (int i = 2; i < argc; ++i) {
+			std::string const option = argv[i];
+			if (option == "--spawn") {
+				options.spawn_workers = true;
+				continue;
+			}
+			if (i + 1 >= argc)
+				throw std::invalid_argument("Missing value for " + option);
+			std::string const value = argv[++i];
+			if (option == "--host")
+				options.host = value;
+			else if (option == "--port")
+				options.port = static_cast<std::uint16_t>(std::stoul(value));
+			else if (option == "--workers")
+				options.workers = static_cast<std::uint32_t>(std::stoul(value));
+			else if (option == "--particles")
+				options.particle_count = static_cast<std::uint32_t>(std::stoul(value));
+			else if (option == "--steps")
+				options.steps = std::stoull(value);
+			else if (option == "--dt")
+				options.delta_time = std::stof(value);
+			else if (option == "--snapshot-interval")
+				options.snapshot_interval = std::max(1u, static_cast<std::uint32_t>(std::stoul(value)));
+			else
+				throw std::invalid_argument("Unknown option " + option);
+		}
+		if (options.workers == 0u)
+			throw std::invalid_argument("At least one worker is needed");
+		return options;
+	}
+
+	//! \brief Swap payloads with the left and right neighbours.
+	//!
+	//! Each link is served by the lower rank sending first and the higher
+	//! rank receiving first, links being handled from left to right, so
+	//! that blocking sends of large payloads can never wait on each other.
+	void exchange_with_neighbours(sph_cluster::Socket& left, sph_cluster::Socket& right,
+	                              sph_cluster::MessageWriter const& to_left, sph_cluster::MessageWriter const& to_right,
+	                              sph_cluster::Message& from_left, sph_cluster::Message& from_right)
+	{
+		if (left.is_valid()) {
+			from_left = sph_cluster::expect_message(left, sph_cluster::MessageType::exchange);
+			sph_cluster::send_message(left, sph_cluster::MessageType::exchange, to_left.bytes());
+		}
+		if (right.is_valid()) {
+			sph_cluster::send_message(right, sph_cluster::MessageType::exchange, to_right.bytes());
+			from_right = sph_cluster::expect_message(right, sph_cluster::MessageType::exchange);
+		}
+	}
+
+	template<typename T>
+	std::vector<T> read_exchanged(sph_cluster::Message const& message)
+	{
+		if (message.payload.empty())
+			return {};
+		return sph_cluster::MessageReader(message.payload).read_vector<T>();
+	}
+
+	class Worker {
+	public:
+		explicit Worker(sph_cluster::Socket coordinator) : _coordinator(std::move(coordinator))
+		{
+		}
+
+		void run()
+		{
+			sph_cluster::send_message(_coordinator, sph_cluster::MessageType::hello, sph_cluster::MessageWriter().write(sph_cluster::Role::worker).bytes());
+
+			auto const assignment = sph_cluster::expect_message(_coordinator, sph_cluster::MessageType::assignment);
+			sph_cluster::MessageReader reader(assignment.payload);
+			_rank = reader.read<std::uint32_t>();
+			_count = reader.read<std::uint32_t>();
+			auto const listen_port = reader.read<std::uint16_t>();
+			auto const left_host = reader.read_string();
+			auto const left_port = reader.read<std::uint16_t>();
+			_parameters = reader.read<sph_cpu::Parameters>();
+			_owned = reader.read_vector<sph_cpu::Particle>();
+
+			// Every worker listens before any of them connects, so that the
+			// connections below cannot be refused.
+			std::unique_ptr<sph_cluster::Listener> right_listener;
+			if (_rank + 1u < _count)
+				right_listener.reset(new sph_cluster::Listener(listen_port));
+			sph_cluster::send_message(_coordinator, sph_cluster::MessageType::ready);
+			sph_cluster::expect_message(_coordinator, sph_cluster::MessageType::start);
+			if (_rank > 0u)
+				_left = sph_cluster::Socket::connect(left_host, left_port);
+			if (right_listener)
+				_right = right_listener->accept();
+
+			std::cout << "Worker " << _rank << "/" << _count << " owns " << _owned.size() << " particles" << std::endl;
+
+			for (;;) {
+				auto const message = sph_cluster::receive_message(_coordinator);
+				if (message.type == sph_cluster::MessageType::shutdown)
+					break;
+				if (message.type != sph_cluster::MessageType::step)
+					throw std::runtime_error("Unexpected message from the coordinator");
+				step(message);
+			}
+		}
+
+	private:
+		void step(sph_cluster::Message const& command)
+		{
+			sph_cluster::MessageReader reader(command.payload);
+			reader.read<std::uint64_t>();
+			auto const delta_time = reader.read<float>();
+			auto const boundaries = reader.read_vector<float>();
+			auto const want_snapshot = reader.read<std::uint32_t>() != 0u;
+			float const lower = boundaries[_rank];
+			float const upper = boundaries[_rank + 1u];
+
+			migrate(lower, upper);
+
+			auto const compute_start = std::chrono::steady_clock::now();
+			_solver.predict(_owned, _parameters, delta_time);
+			auto compute_time = std::chrono::steady_clock::now() - compute_start;
+
+			// Send the owned particles that the neighbours need to see.
+			float const halo_width = _parameters.smoothing_radius * (1.0f + halo_margin);
+			_left_halo.clear();
+			_right_halo.clear();
+			std::vector<sph_cpu::Particle> to_left, to_right;
+			for (std::uint32_t i = 0u; i < _owned.size(); ++i) {
+				float const x = _owned[i].predicted_position.x;
+				if (_left.is_valid() && x < lower + halo_width) {
+					_left_halo.push_back(i);
+					to_left.push_back(_owned[i]);
+				}
+				if (_right.is_valid() && x >= upper - halo_width) {
+					_right_halo.push_back(i);
+					to_right.push_back(_owned[i]);
+				}
+			}
+			sph_cluster::Message from_left, from_right;
+			exchange_with_neighbours(_left, _right,
+			                         sph_cluster::MessageWriter().write_vector(to_left), sph_cluster::MessageWriter().write_vector(to_right),
+			                         from_left, from_right);
+			_halo = read_exchanged<sph_cpu::Particle>(from_left);
+			auto const halo_from_left = _halo.size();
+			auto const right_halo = read_exchanged<sph_cpu::Particle>(from_right);
+			_halo.insert(_halo.end(), right_halo.begin(), right_halo.end());
+
+			auto const density_start = std::chrono::steady_clock::now();
+			_solver.compute_densities(_owned, _halo, _parameters);
+			compute_time += std::chrono::steady_clock::now() - density_start;
+
+			// Pressure needs the densities of the halo particles, which only
+			// their owners can compute: send ours back in the same order.
+			std::vector<glm::vec2> left_densities, right_densities;
+			for (auto const i : _left_halo)
+				left_densities.push_back(_owned[i].densities);
+			for (auto const i : _right_halo)
+				right_densities.push_back(_owned[i].densities);
+			sph_cluster::Message left_reply, right_reply;
+			exchange_with_neighbours(_left, _right,
+			                         sph_cluster::MessageWriter().write_vector(left_densities), sph_cluster::MessageWriter().write_vector(right_densities),
+			                         left_reply, right_reply);
+			auto const densities_from_left = read_exchanged<glm::vec2>(left_reply);
+			auto const densities_from_right = read_exchanged<glm::vec2>(right_reply);
+			if (densities_from_left.size() != halo_from_left || densities_from_right.size() != _halo.size() - halo_from_left)
+				throw std::runtime_error("Halo densities do not match the halo particles");
+			for (std::size_t i = 0u; i < densities_from_left.size(); ++i)
+				_halo[i].densities = densities_from_left[i];
+			for (std::size_t i = 0u; i < densities_from_right.size(); ++i)
+				_halo[halo_from_left + i].densities = densities_from_right[i];
+
+			auto const forces_start = std::chrono::steady_clock::now();
+			_solver.apply_forces(_owned, _halo, _parameters, delta_time);
+			compute_time += std::chrono::steady_clock::now() - forces_start;
+
+			sph_cluster::MessageWriter result;
+			result.write(static_cast<std::uint64_t>(_owned.size()))
+			      .write(std::chrono::duration<double>(compute_time).count());
+			if (want_snapshot) {
+				std::vector<glm::vec2> positions, velocities;
+				positions.reserve(_owned.size());
+				velocities.reserve(_owned.size());
+				for (auto const& particle : _owned) {
+					positions.push_back(particle.position);
+					velocities.push_back(particle.velocity);
+				}
+				result.write_vector(positions).write_vector(velocities);
+			}
+			sph_cluster::send_message(_coordinator, sph_cluster::MessageType::step_result, result.bytes());
+		}
+
+		//! \brief Hand the particles that left the slab over to the
+		//!        neighbour on that side; particles that crossed more than
+		//!        one slab keep travelling over the next steps.
+		void migrate(float lower, float upper)
+		{
+			std::vector<sph_cpu::Particle> to_left, to_right;
+			auto const staying = std::remove_if(_owned.begin(), _owned.end(),
+				[&](sph_cpu::Particle const& particle) {
+					if (_left.is_valid() && particle.position.x < lower) {
+						to_left.push_back(particle);
+						return true;
+					}
+					if (_right.is_valid() && particle.position.x >= upper) {
+						to_right.push_back(particle);
+						return true;
+					}
+					return false;
+				});
+			_owned.erase(staying, _owned.end());
+
+			sph_cluster::Message from_left, from_right;
+			exchange_with_neighbours(_left, _right,
+			                         sph_cluster::MessageWriter().write_vector(to_left), sph_cluster::MessageWriter().write_vector(to_right),
+			                         from_left, from_right);
+			for (auto const* message : { &from_left, &from_right }) {
+				auto const arrived = read_exchanged<sph_cpu::Particle>(*message);
+				_owned.insert(_owned.end(), arrived.begin(), arrived.end());
+			}
+		}
+
+		sph_cluster::Socket _coordinator;
+		sph_cluster::Socket _left;
+		sph_cluster::Socket _right;
+		std::uint32_t _rank = 0u;
+		std::uint32_t _count = 1u;
+		sph_cpu::Parameters _parameters;
+		sph_cpu::Solver _solver;
+		std::vector<sph_cpu::Particle> _owned;
+		std::vector<sph_cpu::Particle> _halo;
+		std::vector<std::uint32_t> _left_halo;
+		std::vector<std::uint32_t> _right_halo;
+	};
+
+	void spawn_local_workers(Options const& options)
+	{
+		for (std::uint32_t i = 0u; i < options.workers; ++i) {
+			std::string command = "\"" + options.executable + "\" worker --host 127.0.0.1 --port " + std::to_string(options.port);
+#if defined(_WIN32)
+			command = "start \"\" /B " + command;
+#else
+			command += " &";
+#endif
+			if (std::system(command.c_str()) != 0)
+				throw std::runtime_error("Failed to launch worker " + std::to_string(i));
+		}
+	}
+
+	int run_coordinator(Options const& options)
+	{
+		sph_cluster::NetworkSession session;
+		sph_cluster::Listener listener(options.port);
+		if (options.spawn_workers)
+			spawn_local_workers(options);
+
+		std::vector<sph_cluster::Socket> workers, viewers;
+		auto const accept_connection = [&listener, &workers, &viewers](bool accept_workers) {
+			auto connection = listener.accept();
+			auto const hello = sph_cluster::expect_message(connection, sph_cluster::MessageType::hello);
+			auto const role = sph_cluster::MessageReader(hello.payload).read<sph_cluster::Role>();
+			if (role == sph_cluster::Role::viewer) {
+				viewers.push_back(std::move(connection));
+				std::cout << "Viewer attached (" << viewers.size() << " connected)" << std::endl;
+			}
+			else if (accept_workers) {
+				workers.push_back(std::move(connection));
+				std::cout << "Worker " << workers.size() - 1u << " connected" << std::endl;
+			}
+			else {
+				std::cerr << "Ignoring a worker connecting to a running simulation" << std::endl;
+			}
+		};
+		std::cout << "Waiting for " << options.workers << " workers on port " << options.port << std::endl;
+		while (workers.size() < options.workers)
+			accept_connection(true);
+
+		// The domain is split along x, with walls on that axis: wrapping it
+		// would make the first and last slabs neighbours.
+		sph_cpu::Parameters parameters;
+		parameters.periodic_axes.x = 0;
+		auto const worker_count = static_cast<std::uint32_t>(workers.size());
+		auto boundaries = sph_cluster::uniform_boundaries(worker_count, parameters.bounds_size.x);
+		float const min_width = 2.0f * parameters.smoothing_radius * (1.0f + halo_margin);
+		float const max_shift = 0.5f * parameters.smoothing_radius;
+		if (parameters.bounds_size.x < worker_count * min_width)
+			throw std::runtime_error("Too many workers for the width of the domain");
+
+		std::vector<std::vector<sph_cpu::Particle>> slabs(worker_count);
+		for (auto const& particle : sph_cpu::spawn_block(options.particle_count, glm::vec2(2.0f, 0.5f), glm::vec2(7.0f, 5.0f), 0.025f, std::random_device{}()))
+			slabs[sph_cluster::slab_of(boundaries, particle.position.x)].push_back(particle);
+
+		for (std::uint32_t rank = 0u; rank < worker_count; ++rank) {
+			sph_cluster::MessageWriter assignment;
+			assignment.write(rank)
+			          .write(worker_count)
+			          .write(static_cast<std::uint16_t>(options.port + 1u + rank))
+			          .write_string(rank > 0u ? workers[rank - 1u].peer_host() : std::string())
+			          .write(static_cast<std::uint16_t>(options.port + rank))
+			          .write(parameters)
+			          .write_vector(slabs[rank]);
+			sph_cluster::send_message(workers[rank], sph_cluster::MessageType::assignment, assignment.bytes());
+		}
+		for (auto& worker : workers)
+			sph_cluster::expect_message(worker, sph_cluster::MessageType::ready);
+		for (auto& worker : workers)
+			sph_cluster::send_message(worker, sph_cluster::MessageType::start);
+
+		std::vector<double> step_times(worker_count, 0.0);
+		std::vector<std::uint64_t> particle_counts(worker_count, 0u);
+		for (std::uint64_t step = 0u; options.steps == 0u || step < options.steps; ++step) {
+			while (listener.has_pending(0))
+				accept_connection(false);
+
+			bool const want_snapshot = !viewers.empty() && step % options.snapshot_interval == 0u;
+			sph_cluster::MessageWriter command;
+			command.write(step)
+			       .write(options.delta_time)
+			       .write_vector(boundaries)
+			       .write(static_cast<std::uint32_t>(want_snapshot ? 1u : 0u));
+			for (auto& worker : workers)
+				sph_cluster::send_message(worker, sph_cluster::MessageType::step, command.bytes());
+
+			std::vector<glm::vec2> positions, velocities;
+			for (std::uint32_t rank = 0u; rank < worker_count; ++rank) {
+				auto const result = sph_cluster::expect_message(workers[rank], sph_cluster::MessageType::step_result);
+				sph_cluster::MessageReader reader(result.payload);
+				particle_counts[rank] = reader.read<std::uint64_t>();
+				auto const step_time = reader.read<double>();
+				// Smooth the timings so that a single slow step (scheduler
+				// noise) does not move the boundaries.
+				step_times[rank] = step == 0u ? step_time : 0.9 * step_times[rank] + 0.1 * step_time;
+				if (want_snapshot) {
+					auto const slab_positions = reader.read_vector<glm::vec2>();
+					auto const slab_velocities = reader.read_vector<glm::vec2>();
+					positions.insert(positions.end(), slab_positions.begin(), slab_positions.end());
+					velocities.insert(velocities.end(), slab_velocities.begin(), slab_velocities.end());
+				}
+			}
+
+			if (want_snapshot) {
+				sph_cluster::MessageWriter snapshot;
+				snapshot.write(step)
+				        .write_vector(boundaries)
+				        .write_vector(positions)
+				        .write_vector(velocities);
+				for (auto viewer = viewers.begin(); viewer != viewers.end();) {
+					try {
+						sph_cluster::send_message(*viewer, sph_cluster::MessageType::snapshot, snapshot.bytes());
+						++viewer;
+					}
+					catch (std::runtime_error const&) {
+						viewer = viewers.erase(viewer);
+						std::cout << "Viewer detached (" << viewers.size() << " connected)" << std::endl;
+					}
+				}
+			}
+
+			sph_cluster::rebalance_boundaries(boundaries, step_times, min_width, max_shift);
+
+			if (options.report_interval != 0u && step % options.report_interval == 0u) {
+				std::cout << "Step " << step << ":";
+				for (std::uint32_t rank = 0u; rank < worker_count; ++rank)
+					std::cout << " [" << boundaries[rank] << ", " << boundaries[rank + 1u] << ") "
+					          << particle_counts[rank] << " particles " << step_times[rank] * 1000.0 << " ms;";
+				std::cout << std::endl;
+			}
+		}
+
+		for (auto& worker : workers)
+			sph_cluster::send_message(worker, sph_cluster::MessageType::shutdown);
+		for (auto& viewer : viewers) {
+			try {
+				sph_cluster::send_message(viewer, sph_cluster::MessageType::shutdown);
+			}
+			catch (std::runtime_error const&) {
+			}
+		}
+		return EXIT_SUCCESS;
+	}
+
+	int run_worker(Options const& options)
+	{
+		sph_cluster::NetworkSession session;
+		Worker worker(sph_cluster::Socket::connect(options.host, options.port));
+		worker.run();
+		return EXIT_SUCCESS;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	try {
+		options = parse_options(argc, argv);
+	}
+	catch (std::exception const& e) {
+		std::cerr << e.what() << std::endl;
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	try {
+		return options.mode == "coordinator" ? run_coordinator(options) : run_worker(options);
+	}
+	catch (std::runtime_error const& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+}
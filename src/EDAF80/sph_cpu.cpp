@@ -0,0 +1,270 @@
+#include "sph_cpu.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace
+{
+	//! \brief Kernels of the compute shader, with their scaling factors
+	//!        evaluated once per smoothing radius.
+	struct Kernels {
+		explicit Kernels(float radius) :
+			radius(radius),
+			spiky_pow2(6.0f / (std::pow(radius, 4.0f) * glm::pi<float>())),
+			spiky_pow3(10.0f / (std::pow(radius, 5.0f) * glm::pi<float>())),
+			spiky_pow2_derivative(12.0f / (std::pow(radius, 4.0f) * glm::pi<float>())),
+			spiky_pow3_derivative(30.0f / (std::pow(radius, 5.0f) * glm::pi<float>())),
+			poly6(4.0f / (std::pow(radius, 8.0f) * glm::pi<float>()))
+		{
+		}
+
+		float DensityKernel(float dst) const
+		{
+			float const v = radius - dst;
+			return dst < radius ? v * v * spiky_pow2 : 0.0f;
+		}
+
+		float NearDensityKernel(float dst) const
+		{
+			float const v = radius - dst;
+			return dst < radius ? v * v * spiky_pow3 : 0.0f;
+		}
+
+		float DensityDerivative(float dst) const
+		{
+			float const v = radius - dst;
+			return dst <= radius ? -v * spiky_pow2_derivative : 0.0f;
+		}
+
+		float NearDensityDerivative(float dst) const
+		{
+			float const v = radius - dst;
+			return dst <= radius ? -v * v * spiky_pow3_derivative : 0.0f;
+		}
+
+		float ViscosityKernel(float dst) const
+		{
+			float const v = radius * radius - dst * dst;
+			return dst < radius ? v * v * v * poly6 : 0.0f;
+		}
+
+		float radius;
+		float spiky_pow2;
+		float spiky_pow3;
+		float spiky_pow2_derivative;
+		float spiky_pow3_derivative;
+		float poly6;
+	};
+
+	glm::ivec2 GetCell2D(glm::vec2 position, float radius)
+	{
+		return glm::ivec2(glm::floor(position / radius));
+	}
+
+	void HandleCollisions(sph_cpu::Particle& particle, sph_cpu::Parameters const& parameters)
+	{
+		glm::vec2 const half_size = parameters.bounds_size * 0.5f;
+		for (int axis = 0; axis < 2; ++axis) {
+			float& pos = particle.position[axis];
+			if (parameters.periodic_axes[axis] != 0) {
+				pos -= parameters.bounds_size[axis] * std::floor(pos / parameters.bounds_size[axis] + 0.5f);
+			}
+			else if (half_size[axis] - std::abs(pos) <= 0.0f) {
+				pos = std::copysign(half_size[axis], pos);
+				particle.velocity[axis] *= -parameters.collision_damping;
+			}
+		}
+	}
+}
+
+template<typename F>
+void
+sph_cpu::Solver::for_each_neighbour(glm::vec2 position, std::vector<Particle> const& owned, std::vector<Particle> const& halo, Parameters const& parameters, F&& f) const
+{
+	float const radius = parameters.smoothing_radius;
+	float const sqr_radius = radius * radius;
+
+	// Periodic axes are handled by also querying around the images of the
+	// position shifted by one domain size; each query is clipped to the grid.
+	glm::ivec2 const images = parameters.periodic_axes;
+	for (int iy = -images.y; iy <= images.y; ++iy) {
+		for (int ix = -images.x; ix <= images.x; ++ix) {
+			glm::vec2 const query = position + glm::vec2(ix, iy) * parameters.bounds_size;
+			glm::ivec2 const origin = GetCell2D(query, radius) - _grid_origin;
+			glm::ivec2 const lower = glm::max(origin - 1, glm::ivec2(0));
+			glm::ivec2 const upper = glm::min(origin + 1, _grid_size - 1);
+			for (int y = lower.y; y <= upper.y; ++y) {
+				for (int x = lower.x; x <= upper.x; ++x) {
+					auto const cell = static_cast<std::size_t>(y * _grid_size.x + x);
+					for (auto s = _cell_starts[cell]; s < _cell_starts[cell + 1]; ++s) {
+						auto const n = _sorted_indices[s];
+						glm::vec2 const offset = candidate(owned, halo, n).predicted_position - query;
+						float const sqr_dst = glm::dot(offset, offset);
+						if (sqr_dst > sqr_radius)
+							continue;
+						f(n, offset, std::sqrt(sqr_dst));
+					}
+				}
+			}
+		}
+	}
+}
+
+std::vector<sph_cpu::Particle>
+sph_cpu::spawn_block(std::uint32_t count, glm::vec2 centre, glm::vec2 size, float jitter_strength, std::uint32_t seed)
+{
+	std::mt19937 generator(seed);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	glm::vec2 const s = size;
+	int const num_x = static_cast<int>(std::ceil(std::sqrt(s.x / s.y * count + (s.x - s.y) * (s.x - s.y) / (4 * s.y * s.y)) - (s.x - s.y) / (2 * s.y)));
+	int const num_y = static_cast<int>(std::ceil(count / static_cast<float>(num_x)));
+
+	std::vector<Particle> particles;
+	particles.reserve(count);
+	for (int y = 0; y < num_y; ++y) {
+		for (int x = 0; x < num_x && particles.size() < count; ++x) {
+			float const tx = num_x <= 1 ? 0.5f : x / (num_x - 1.0f);
+			float const ty = num_y <= 1 ? 0.5f : y / (num_y - 1.0f);
+			float const angle = distribution(generator) * glm::two_pi<float>();
+			glm::vec2 const jitter = glm::vec2(std::cos(angle), std::sin(angle)) * jitter_strength * (distribution(generator) - 0.5f);
+
+			Particle particle = {};
+			particle.position = glm::vec2((tx - 0.5f) * size.x, (ty - 0.5f) * size.y) + jitter + centre;
+			particle.predicted_position = particle.position;
+			particle.id = static_cast<std::uint32_t>(particles.size());
+			particles.push_back(particle);
+		}
+	}
+	return particles;
+}
+
+void
+sph_cpu::Solver::step(std::vector<Particle>& particles, Parameters const& parameters, float delta_time)
+{
+	std::vector<Particle> const no_halo;
+	predict(particles, parameters, delta_time);
+	compute_densities(particles, no_halo, parameters);
+	apply_forces(particles, no_halo, parameters, delta_time);
+}
+
+void
+sph_cpu::Solver::predict(std::vector<Particle>& owned, Parameters const& parameters, float delta_time) const
+{
+	for (auto& particle : owned) {
+		particle.velocity.y += parameters.gravity * delta_time;
+		particle.predicted_position = particle.position + particle.velocity * parameters.prediction_factor;
+	}
+}
+
+void
+sph_cpu::Solver::compute_densities(std::vector<Particle>& owned, std::vector<Particle> const& halo, Parameters const& parameters)
+{
+	build_grid(owned, halo, parameters);
+
+	Kernels const kernels(parameters.smoothing_radius);
+	for (auto& particle : owned) {
+		glm::vec2 densities(0.0f);
+		for_each_neighbour(particle.predicted_position, owned, halo, parameters,
+			[&densities, &kernels](std::uint32_t, glm::vec2, float dst) {
+				densities.x += kernels.DensityKernel(dst);
+				densities.y += kernels.NearDensityKernel(dst);
+			});
+		particle.densities = densities;
+	}
+}
+
+void
+sph_cpu::Solver::apply_forces(std::vector<Particle>& owned, std::vector<Particle> const& halo, Parameters const& parameters, float delta_time)
+{
+	// Viscosity reads the neighbours' velocities from before this step,
+	// independently of the order in which the particles get updated.
+	_velocities.resize(owned.size() + halo.size());
+	for (std::size_t i = 0; i < owned.size(); ++i)
+		_velocities[i] = owned[i].velocity;
+	for (std::size_t i = 0; i < halo.size(); ++i)
+		_velocities[owned.size() + i] = halo[i].velocity;
+
+	auto const pressure_from_density = [&parameters](float density) {
+		return (density - parameters.target_density) * parameters.pressure_multiplier;
+	};
+	auto const near_pressure_from_density = [&parameters](float near_density) {
+		return parameters.near_pressure_multiplier * near_density;
+	};
+
+	Kernels const kernels(parameters.smoothing_radius);
+	for (std::uint32_t i = 0; i < owned.size(); ++i) {
+		auto& particle = owned[i];
+		float const density = particle.densities.x;
+		float const pressure = pressure_from_density(density);
+		float const near_pressure = near_pressure_from_density(particle.densities.y);
+		glm::vec2 const velocity = _velocities[i];
+
+		glm::vec2 pressure_force(0.0f);
+		glm::vec2 viscosity_force(0.0f);
+		for_each_neighbour(particle.predicted_position, owned, halo, parameters,
+			[&](std::uint32_t n, glm::vec2 offset, float dst) {
+				viscosity_force += (_velocities[n] - velocity) * kernels.ViscosityKernel(dst);
+				if (n == i)
+					return;
+				auto const& neighbour = candidate(owned, halo, n);
+				glm::vec2 const dir = dst > 0.0f ? offset / dst : glm::vec2(0.0f, 1.0f);
+				float const shared_pressure = (pressure + pressure_from_density(neighbour.densities.x)) * 0.5f;
+				float const shared_near_pressure = (near_pressure + near_pressure_from_density(neighbour.densities.y)) * 0.5f;
+				pressure_force += dir * kernels.DensityDerivative(dst) * shared_pressure;
+				pressure_force += dir * kernels.NearDensityDerivative(dst) * shared_near_pressure;
+			});
+
+		// Same scaling of the pressure acceleration as the compute shader.
+		if (density > 0.0f)
+			particle.velocity += 0.0005f * pressure_force / density * delta_time;
+		particle.velocity += viscosity_force * parameters.viscosity_strength * delta_time;
+		particle.position += particle.velocity * delta_time;
+		HandleCollisions(particle, parameters);
+	}
+}
+
+void
+sph_cpu::Solver::build_grid(std::vector<Particle> const& owned, std::vector<Particle> const& halo, Parameters const& parameters)
+{
+	auto const count = static_cast<std::uint32_t>(owned.size() + halo.size());
+	_sorted_indices.resize(count);
+	if (count == 0u) {
+		_grid_size = glm::ivec2(0);
+		_cell_starts.assign(1u, 0u);
+		return;
+	}
+
+	glm::ivec2 min_cell(std::numeric_limits<int>::max());
+	glm::ivec2 max_cell(std::numeric_limits<int>::lowest());
+	for (std::uint32_t i = 0; i < count; ++i) {
+		auto const cell = GetCell2D(candidate(owned, halo, i).predicted_position, parameters.smoothing_radius);
+		min_cell = glm::min(min_cell, cell);
+		max_cell = glm::max(max_cell, cell);
+	}
+	_grid_origin = min_cell;
+	_grid_size = max_cell - min_cell + 1;
+
+	// Counting sort of the particles by cell.
+	auto const cell_index = [this, &parameters](glm::vec2 position) {
+		auto const cell = GetCell2D(position, parameters.smoothing_radius) - _grid_origin;
+		return static_cast<std::uint32_t>(cell.y * _grid_size.x + cell.x);
+	};
+	_cell_starts.assign(static_cast<std::size_t>(_grid_size.x) * _grid_size.y + 1u, 0u);
+	for (std::uint32_t i = 0; i < count; ++i)
+		++_cell_starts[cell_index(candidate(owned, halo, i).predicted_position) + 1u];
+	for (std::size_t c = 1; c < _cell_starts.size(); ++c)
+		_cell_starts[c] += _cell_starts[c - 1];
+	std::vector<std::uint32_t> cursors(_cell_starts.begin(), _cell_starts.end() - 1);
+	for (std::uint32_t i = 0; i < count; ++i)
+		_sorted_indices[cursors[cell_index(candidate(owned, halo, i).predicted_position)]++] = i;
+}
+
+sph_cpu::Particle const&
+sph_cpu::Solver::candidate(std::vector<Particle> const& owned, std::vector<Particle> const& halo, std::uint32_t index) const
+{
+	return index < owned.size() ? owned[index] : halo[index - owned.size()];
+}
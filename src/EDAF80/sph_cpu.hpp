@@ -0,0 +1,78 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+//! \brief CPU port of the 2D SPH step of `sph.comp`, split into the three
+//!        phases needed to run it on a slab of a decomposed domain: halo
+//!        particles owned by neighbouring slabs only ever contribute to the
+//!        owned particles, they are never advanced.
+namespace sph_cpu
+{
+	//! \brief Particle state, trivially copyable so that it can be sent
+	//!        as-is between processes.
+	struct Particle {
+		glm::vec2 position;
+		glm::vec2 velocity;
+		glm::vec2 predicted_position;
+		glm::vec2 densities; //!< x: density, y: near density
+		std::uint32_t id;
+	};
+
+	//! \brief Mirror of the uniforms consumed by the 2D compute shader.
+	struct Parameters {
+		float collision_damping = 0.8f;
+		float gravity = -6.0f;
+		glm::vec2 bounds_size = glm::vec2(17.1f, 9.0f);
+		glm::ivec2 periodic_axes = glm::ivec2(0);
+
+		float smoothing_radius = 0.35f;
+		float target_density = 55.0f;
+		float pressure_multiplier = 500.0f;
+		float near_pressure_multiplier = 18.0f;
+		float viscosity_strength = 0.06f;
+		float prediction_factor = 1.0f / 120.0f;
+	};
+
+	//! \brief Block of |count| particles at rest filling |size| around
+	//!        |centre|, laid out like edaf80::ParticleSpawner does.
+	std::vector<Particle> spawn_block(std::uint32_t count, glm::vec2 centre, glm::vec2 size, float jitter_strength, std::uint32_t seed);
+
+	class Solver {
+	public:
+		//! \brief Advance a whole, undecomposed domain by one step.
+		void step(std::vector<Particle>& particles, Parameters const& parameters, float delta_time);
+
+		//! \brief Apply gravity and compute the predicted positions of the
+		//!        owned particles.
+		void predict(std::vector<Particle>& owned, Parameters const& parameters, float delta_time) const;
+
+		//! \brief Compute the densities of the owned particles, using the
+		//!        predicted positions of both owned and halo particles.
+		void compute_densities(std::vector<Particle>& owned, std::vector<Particle> const& halo, Parameters const& parameters);
+
+		//! \brief Apply pressure and viscosity, integrate and resolve the
+		//!        collisions with the container; the densities of the halo
+		//!        particles must be up to date.
+		void apply_forces(std::vector<Particle>& owned, std::vector<Particle> const& halo, Parameters const& parameters, float delta_time);
+
+	private:
+		//! \brief Bucket owned and halo particles (indices past the owned
+		//!        count refer to the halo) in a dense grid of
+		//!        smoothing-radius cells covering their bounding box.
+		void build_grid(std::vector<Particle> const& owned, std::vector<Particle> const& halo, Parameters const& parameters);
+
+		Particle const& candidate(std::vector<Particle> const& owned, std::vector<Particle> const& halo, std::uint32_t index) const;
+
+		template<typename F>
+		void for_each_neighbour(glm::vec2 position, std::vector<Particle> const& owned, std::vector<Particle> const& halo, Parameters const& parameters, F&& f) const;
+
+		glm::ivec2 _grid_origin = glm::ivec2(0);
+		glm::ivec2 _grid_size = glm::ivec2(0);
+		std::vector<std::uint32_t> _cell_starts;
+		std::vector<std::uint32_t> _sorted_indices;
+		std::vector<glm::vec2> _velocities;
+	};
+}
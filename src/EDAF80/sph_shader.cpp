@@ -0,0 +1,78 @@
+#include "sph_shader.hpp"
+
+#include "core/Log.h"
+
+#include <sstream>
+
+namespace
+{
+	char const* density_kernel_name(sph_shader::Kernel kernel)
+	{
+		return kernel == sph_shader::Kernel::poly6 ? "poly6" : "spiky";
+	}
+}
+
+std::string
+sph_shader::Variant::key() const
+{
+	return kernel_name() + " wg" + std::to_string(work_group_size);
+}
+
+std::string
+sph_shader::Variant::kernel_name() const
+{
+	std::ostringstream oss;
+	oss << "SPH " << dimensions << "D " << density_kernel_name(kernel) << " n" << particle_capacity;
+	if (viscosity)
+		oss << " viscosity";
+	if (interaction)
+		oss << " interaction";
+	if (obstacles)
+		oss << " obstacles";
+	return oss.str();
+}
+
+std::vector<std::uint32_t>
+sph_shader::Variant::work_group_size_candidates()
+{
+	return { 32u, 64u, 128u, 256u, 512u, 1024u };
+}
+
+ShaderProgramManager::ShaderDefines
+sph_shader::Variant::defines() const
+{
+	return {
+		{ "SPH_DIMENSIONS", std::to_string(dimensions) },
+		{ "SPH_KERNEL", kernel == Kernel::poly6 ? "SPH_KERNEL_POLY6" : "SPH_KERNEL_SPIKY" },
+		{ "SPH_WORK_GROUP_SIZE", std::to_string(work_group_size) },
+		{ "SPH_PARTICLE_CAPACITY", std::to_string(particle_capacity) + "u" },
+		{ "SPH_VISCOSITY", viscosity ? "1" : "0" },
+		{ "SPH_INTERACTION", interaction ? "1" : "0" },
+		{ "SPH_OBSTACLES", obstacles ? "1" : "0" },
+	};
+}
+
+std::uint32_t
+sph_shader::Variant::work_group_count() const
+{
+	return (particle_capacity + work_group_size - 1u) / work_group_size;
+}
+
+sph_shader::VariantCache::VariantCache(ShaderProgramManager& program_manager) : _program_manager(program_manager)
+{
+}
+
+GLuint
+sph_shader::VariantCache::get(Variant const& variant)
+{
+	auto const key = variant.key();
+	auto const cached = _programs.find(key);
+	if (cached != _programs.end())
+		return cached->second;
+
+	auto& entry = *_programs.emplace(key, 0u).first;
+	_program_manager.CreateAndRegisterComputeProgram(entry.first.c_str(), "EDAF80/sph.comp", variant.defines(), entry.second);
+	if (entry.second == 0u)
+		LogError("Failed to build the SPH variant '%s'", entry.first.c_str());
+	return entry.second;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "core/ShaderProgramManager.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+//! \brief Variants of the templated SPH step `EDAF80/sph.comp`: each
+//!        configuration is compiled on its own, with its constants and
+//!        feature flags injected as `#define`s.
+namespace sph_shader
+{
+	enum class Kernel : std::uint32_t {
+		spiky, //!< spiky (pow2) density kernel
+		poly6  //!< poly6 density kernel and its derivative
+	};
+
+	struct Variant {
+		std::uint32_t dimensions = 2u;
+		Kernel kernel = Kernel::spiky;
+		std::uint32_t work_group_size = 128u;
+		std::uint32_t particle_capacity = 0u;
+		bool viscosity = true;
+		bool interaction = true;
+		bool obstacles = false;
+
+		//! \brief Unique name of the variant, also used as program name.
+		std::string key() const;
+
+		//! \brief Name of the variant regardless of its work-group size,
+		//!        under which that size gets tuned.
+		std::string kernel_name() const;
+
+		//! \brief Work-group sizes worth trying for this kernel.
+		static std::vector<std::uint32_t> work_group_size_candidates();
+
+		ShaderProgramManager::ShaderDefines defines() const;
+
+		//! \brief Number of work groups covering all the particles.
+		std::uint32_t work_group_count() const;
+	};
+
+	//! \brief Compile every variant once, the first time it is requested.
+	//!
+	//! Programs are registered with the program manager, which owns them
+	//! and rebuilds them when reloading, so the cache must not outlive it.
+	class VariantCache {
+	public:
+		explicit VariantCache(ShaderProgramManager& program_manager);
+
+		//! \brief Program of |variant|, or 0 if it failed to build.
+		GLuint get(Variant const& variant);
+
+		std::size_t size() const { return _programs.size(); }
+
+	private:
+		ShaderProgramManager& _program_manager;
+		// Node-based, so that the program names and handles registered
+		// with the manager stay valid as the cache grows.
+		std::map<std::string, GLuint> _programs;
+	};
+}
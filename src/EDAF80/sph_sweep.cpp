@@ -0,0 +1,317 @@
+#include "sph_cpu.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	//! \brief Solver parameters that can be swept, under the names used by
+	//!        the interactive project.
+	std::vector<std::pair<std::string, float sph_cpu::Parameters::*>> const sweepable_parameters = {
+		{ "targetDensity",          &sph_cpu::Parameters::target_density },
+		{ "pressureMultiplier",     &sph_cpu::Parameters::pressure_multiplier },
+		{ "nearPressureMultiplier", &sph_cpu::Parameters::near_pressure_multiplier },
+		{ "viscosityStrength",      &sph_cpu::Parameters::viscosity_strength },
+		{ "smoothingRadius",        &sph_cpu::Parameters::smoothing_radius },
+		{ "gravity",                &sph_cpu::Parameters::gravity },
+		{ "collisionDamping",       &sph_cpu::Parameters::collision_damping },
+	};
+
+	enum class Sampling {
+		grid,
+		latin_hypercube
+	};
+
+	struct Range {
+		float sph_cpu::Parameters::* member;
+		float min;
+		float max;
+		std::uint32_t points;
+	};
+
+	struct Spec {
+		Sampling sampling = Sampling::grid;
+		std::uint32_t samples = 16u;
+		std::uint32_t seed = 1u;
+		std::uint32_t steps = 1200u;
+		float delta_time = 1.0f / 120.0f;
+		std::uint32_t particles = 2000u;
+		std::uint32_t threads = 0u;
+		float stability_tolerance = 0.05f;
+		std::string output = "sweep.csv";
+		std::vector<Range> ranges;
+	};
+
+	struct Metrics {
+		bool stable = false;
+		long long nan_step = -1;
+		float max_density_error = 0.0f;
+		float final_density_error = 0.0f;
+		float energy_drift = 0.0f;
+		float max_kinetic_energy = 0.0f;
+		float final_kinetic_energy = 0.0f;
+		double wall_seconds = 0.0;
+	};
+
+	void print_usage(char const* executable)
+	{
+		std::cout << "Usage: " << executable << " <spec file>\n"
+		          << "\n"
+		          << "The spec file has one setting per line, '#' starting a comment:\n"
+		          << "  sampling grid|lhs       grid: cartesian product of the ranges,\n"
+		          << "                          lhs: Latin hypercube of 'samples' runs\n"
+		          << "  samples N               number of Latin-hypercube runs\n"
+		          << "  seed N                  seed of the sampling and of the particle jitter\n"
+		          << "  steps N                 steps per run\n"
+		          << "  dt T                    time step\n"
+		          << "  particles N             particles per run\n"
+		          << "  threads N               concurrent runs, 0 for one per core\n"
+		          << "  stability_tolerance X   largest energy gain of a stable run\n"
+		          << "  output FILE             CSV file, one row per run\n"
+		          << "  <parameter> MIN MAX [N] swept range, N points on a grid\n"
+		          << "\n"
+		          << "Parameters:";
+		for (auto const& parameter : sweepable_parameters)
+			std::cout << " " << parameter.first;
+		std::cout << std::endl;
+	}
+
+	Spec parse_spec(std::string const& path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			throw std::runtime_error("Failed to open " + path);
+
+		Spec spec;
+		std::string line;
+		for (unsigned int line_number = 1u; std::getline(file, line); ++line_number) {
+			line = line.substr(0, line.find('#'));
+			std::istringstream stream(line);
+			std::string key;
+			if (!(stream >> key))
+				continue;
+
+			auto const parameter = std::find_if(sweepable_parameters.begin(), sweepable_parameters.end(),
+			                                    [&key](std::pair<std::string, float sph_cpu::Parameters::*> const& p) { return p.first == key; });
+			bool valid = true;
+			if (parameter != sweepable_parameters.end()) {
+				Range range = { parameter->second, 0.0f, 0.0f, 1u };
+				valid = static_cast<bool>(stream >> range.min);
+				range.max = range.min;
+				if (valid && stream >> range.max)
+					stream >> range.points;
+				range.points = std::max(range.points, 1u);
+				spec.ranges.push_back(range);
+			}
+			else if (key == "sampling") {
+				std::string value;
+				stream >> value;
+				valid = value == "grid" || value == "lhs";
+				spec.sampling = value == "lhs" ? Sampling::latin_hypercube : Sampling::grid;
+			}
+			else if (key == "samples")
+				valid = static_cast<bool>(stream >> spec.samples);
+			else if (key == "seed")
+				valid = static_cast<bool>(stream >> spec.seed);
+			else if (key == "steps")
+				valid = static_cast<bool>(stream >> spec.steps);
+			else if (key == "dt")
+				valid = static_cast<bool>(stream >> spec.delta_time);
+			else if (key == "particles")
+				valid = static_cast<bool>(stream >> spec.particles);
+			else if (key == "threads")
+				valid = static_cast<bool>(stream >> spec.threads);
+			else if (key == "stability_tolerance")
+				valid = static_cast<bool>(stream >> spec.stability_tolerance);
+			else if (key == "output")
+				valid = static_cast<bool>(stream >> spec.output);
+			else
+				valid = false;
+			if (!valid)
+				throw std::runtime_error(path + ":" + std::to_string(line_number) + ": invalid setting '" + line + "'");
+		}
+		return spec;
+	}
+
+	//! \brief Parameter sets of all runs, following the sampling of |spec|.
+	std::vector<sph_cpu::Parameters> sample(Spec const& spec)
+	{
+		std::vector<sph_cpu::Parameters> runs;
+		if (spec.sampling == Sampling::grid) {
+			std::size_t run_count = 1u;
+			for (auto const& range : spec.ranges)
+				run_count *= range.points;
+			runs.resize(run_count);
+			for (std::size_t run = 0u; run < run_count; ++run) {
+				// Mixed-radix decomposition of the run index, first range
+				// varying fastest.
+				std::size_t index = run;
+				for (auto const& range : spec.ranges) {
+					auto const point = index % range.points;
+					index /= range.points;
+					float const t = range.points > 1u ? point / static_cast<float>(range.points - 1u) : 0.0f;
+					runs[run].*range.member = range.min + t * (range.max - range.min);
+				}
+			}
+		}
+		else {
+			// Each range is split into one stratum per run, and every
+			// stratum is used exactly once per parameter.
+			std::mt19937 generator(spec.seed);
+			std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+			runs.resize(spec.samples);
+			std::vector<std::uint32_t> strata(spec.samples);
+			for (auto const& range : spec.ranges) {
+				std::iota(strata.begin(), strata.end(), 0u);
+				std::shuffle(strata.begin(), strata.end(), generator);
+				for (std::uint32_t run = 0u; run < spec.samples; ++run) {
+					float const t = (strata[run] + distribution(generator)) / spec.samples;
+					runs[run].*range.member = range.min + t * (range.max - range.min);
+				}
+			}
+		}
+		return runs;
+	}
+
+	Metrics simulate(Spec const& spec, sph_cpu::Parameters const& parameters, std::vector<sph_cpu::Particle> particles)
+	{
+		auto const start_time = std::chrono::steady_clock::now();
+
+		// Unit mass per particle; the potential energy is measured from the
+		// floor of the container.
+		float const floor_height = -0.5f * parameters.bounds_size.y;
+		auto const energies = [&parameters, floor_height](std::vector<sph_cpu::Particle> const& state) {
+			double kinetic = 0.0, potential = 0.0;
+			for (auto const& particle : state) {
+				kinetic += 0.5 * glm::dot(particle.velocity, particle.velocity);
+				potential += -parameters.gravity * (particle.position.y - floor_height);
+			}
+			return std::make_pair(kinetic, potential);
+		};
+		auto const initial_energies = energies(particles);
+		double const initial_energy = initial_energies.first + initial_energies.second;
+
+		Metrics metrics;
+		sph_cpu::Solver solver;
+		for (std::uint32_t step = 0u; step < spec.steps; ++step) {
+			solver.step(particles, parameters, spec.delta_time);
+
+			bool finite = true;
+			float compression = 0.0f;
+			double density_error = 0.0;
+			for (auto const& particle : particles) {
+				finite = finite && std::isfinite(particle.position.x) && std::isfinite(particle.position.y)
+				                && std::isfinite(particle.velocity.x) && std::isfinite(particle.velocity.y);
+				float const error = (particle.densities.x - parameters.target_density) / parameters.target_density;
+				compression = std::max(compression, error);
+				density_error += std::abs(error);
+			}
+			if (!finite) {
+				metrics.nan_step = step;
+				break;
+			}
+
+			auto const step_energies = energies(particles);
+			metrics.max_density_error = std::max(metrics.max_density_error, compression);
+			metrics.final_density_error = static_cast<float>(density_error / std::max<std::size_t>(particles.size(), 1u));
+			metrics.final_kinetic_energy = static_cast<float>(step_energies.first);
+			metrics.max_kinetic_energy = std::max(metrics.max_kinetic_energy, metrics.final_kinetic_energy);
+			if (initial_energy > 0.0)
+				metrics.energy_drift = static_cast<float>((step_energies.first + step_energies.second - initial_energy) / initial_energy);
+		}
+
+		// Walls only dissipate energy: a run that gained some blew up.
+		metrics.stable = metrics.nan_step < 0 && metrics.energy_drift <= spec.stability_tolerance;
+		metrics.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+		return metrics;
+	}
+
+	int run_sweep(Spec const& spec)
+	{
+		auto const runs = sample(spec);
+		if (runs.empty())
+			throw std::runtime_error("The spec does not describe any run");
+
+		// Same initial state for every run, with the block scaled so that
+		// its particle spacing matches the 10000 particles of the project.
+		float const block_scale = std::sqrt(spec.particles / 10000.0f);
+		auto const initial_particles = sph_cpu::spawn_block(spec.particles, glm::vec2(2.0f, 0.5f) * block_scale,
+		                                                    glm::vec2(7.0f, 5.0f) * block_scale, 0.025f, spec.seed);
+
+		std::ofstream csv(spec.output);
+		if (!csv)
+			throw std::runtime_error("Failed to create " + spec.output);
+		csv << "run";
+		for (auto const& parameter : sweepable_parameters)
+			csv << "," << parameter.first;
+		csv << ",stable,nan_step,max_density_error,final_density_error,energy_drift,max_kinetic_energy,final_kinetic_energy,wall_seconds\n";
+		csv.flush();
+
+		unsigned int const thread_count = std::max(1u, std::min(spec.threads != 0u ? spec.threads : std::thread::hardware_concurrency(),
+		                                                        static_cast<unsigned int>(runs.size())));
+		std::cout << runs.size() << " runs of " << spec.steps << " steps on " << thread_count << " threads" << std::endl;
+
+		// Rows are written as soon as runs complete, so that an interrupted
+		// sweep keeps its results; the run column restores the order.
+		std::atomic<std::size_t> next_run(0u);
+		std::mutex output_mutex;
+		std::size_t completed = 0u;
+		auto const worker = [&]() {
+			for (auto run = next_run++; run < runs.size(); run = next_run++) {
+				auto const metrics = simulate(spec, runs[run], initial_particles);
+
+				std::lock_guard<std::mutex> lock(output_mutex);
+				csv << run;
+				for (auto const& parameter : sweepable_parameters)
+					csv << "," << runs[run].*parameter.second;
+				csv << "," << (metrics.stable ? 1 : 0) << "," << metrics.nan_step
+				    << "," << metrics.max_density_error << "," << metrics.final_density_error
+				    << "," << metrics.energy_drift << "," << metrics.max_kinetic_energy
+				    << "," << metrics.final_kinetic_energy << "," << metrics.wall_seconds << "\n";
+				csv.flush();
+				std::cout << "[" << ++completed << "/" << runs.size() << "] run " << run
+				          << (metrics.stable ? " stable" : " unstable") << " in " << metrics.wall_seconds << " s" << std::endl;
+			}
+		};
+		std::vector<std::thread> threads;
+		for (unsigned int i = 0u; i < thread_count; ++i)
+			threads.emplace_back(worker);
+		for (auto& thread : threads)
+			thread.join();
+
+		std::cout << "Results written to " << spec.output << std::endl;
+		return EXIT_SUCCESS;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 2) {
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	try {
+		return run_sweep(parse_spec(argv[1]));
+	}
+	catch (std::runtime_error const& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,717 @@
+#include "stable_fluids.hpp"
+
+#include "config.hpp"
+#include "core/Bonobo.h"
+#include "core/FPSCamera.h"
+#include "core/helpers.hpp"
+#include "core/opengl.hpp"
+#include "core/ShaderProgramManager.hpp"
+
+#include <imgui.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <tinyfiledialogs.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <clocale>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	template <class E> constexpr auto toU(E const& e)
+	{
+		return static_cast<std::underlying_type_t<E>>(e);
+	}
+
+	//! Velocity faces and dye are ping-ponged between two textures: the
+	//! advection passes read from one and write to the other.
+	struct FluidTextures {
+		std::array<GLuint, 2> velocity_u; // (N+1) x M faces
+		std::array<GLuint, 2> velocity_v; // N x (M+1) faces
+		std::array<GLuint, 2> dye;        // N x M cells
+		GLuint curl;
+		GLuint display;
+	};
+	FluidTextures createFluidTextures(glm::ivec2 const& grid_size);
+	void deleteFluidTextures(FluidTextures& textures);
+	void clearFluidTextures(FluidTextures const& textures);
+
+	//! One level of the multigrid hierarchy; level 0 is the simulation
+	//! grid and each following level halves the resolution.
+	struct MultigridLevel {
+		glm::ivec2 size;
+		float cell_size;
+		GLuint pressure;
+		GLuint rhs;
+	};
+	std::vector<MultigridLevel> createMultigridLevels(glm::ivec2 const& grid_size, int coarsest_size);
+	void deleteMultigridLevels(std::vector<MultigridLevel>& levels);
+
+	enum class ElapsedTimeQuery : uint32_t {
+		VelocityAdvection = 0u,
+		Forces,
+		Vorticity,
+		PressureSolve,
+		DyeAdvection,
+		Visualisation,
+		Count
+	};
+	using ElapsedTimeQueries = std::array<GLuint, toU(ElapsedTimeQuery::Count)>;
+	ElapsedTimeQueries createElapsedTimeQueries();
+
+	GLuint createLinearSampler();
+
+	void dispatchGrid(glm::ivec2 const& size)
+	{
+		glDispatchCompute((size.x + 7) / 8, (size.y + 7) / 8, 1);
+	}
+
+	void imageBarrier()
+	{
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+
+	void bindSampledTexture(GLuint unit, GLuint texture, GLuint sampler)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glBindSampler(unit, sampler);
+	}
+} // namespace
+
+
+edaf80::StableFluids::StableFluids(WindowManager& windowManager) :
+	mCamera(0.5f * glm::half_pi<float>(),
+	        static_cast<float>(config::resolution_x) / static_cast<float>(config::resolution_y),
+	        0.01f, 1000.0f),
+	inputHandler(), mWindowManager(windowManager), window(nullptr)
+{
+	WindowManager::WindowDatum window_datum{ inputHandler, mCamera, config::resolution_x, config::resolution_y, 0, 0, 0, 0};
+
+	window = mWindowManager.CreateGLFWWindow("EDAN35: stable fluids", window_datum, config::msaa_rate);
+	if (window == nullptr) {
+		throw std::runtime_error("Failed to get a window: aborting!");
+	}
+
+	bonobo::init();
+}
+
+edaf80::StableFluids::~StableFluids()
+{
+	bonobo::deinit();
+}
+
+void
+edaf80::StableFluids::run()
+{
+	//
+	// Load all the shader programs used
+	//
+	ShaderProgramManager program_manager;
+	GLuint advect_velocity_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Advect velocity",
+	                                                "EDAF80/stable_fluids/advect_velocity.comp",
+	                                                advect_velocity_shader);
+	if (advect_velocity_shader == 0u) {
+		LogError("Failed to load velocity advection shader");
+		return;
+	}
+
+	GLuint add_forces_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Add forces",
+	                                                "EDAF80/stable_fluids/add_forces.comp",
+	                                                add_forces_shader);
+	if (add_forces_shader == 0u) {
+		LogError("Failed to load external forces shader");
+		return;
+	}
+
+	GLuint vorticity_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Vorticity",
+	                                                "EDAF80/stable_fluids/vorticity.comp",
+	                                                vorticity_shader);
+	if (vorticity_shader == 0u) {
+		LogError("Failed to load vorticity shader");
+		return;
+	}
+
+	GLuint vorticity_confinement_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Vorticity confinement",
+	                                                "EDAF80/stable_fluids/vorticity_confinement.comp",
+	                                                vorticity_confinement_shader);
+	if (vorticity_confinement_shader == 0u) {
+		LogError("Failed to load vorticity confinement shader");
+		return;
+	}
+
+	GLuint divergence_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Divergence",
+	                                                "EDAF80/stable_fluids/divergence.comp",
+	                                                divergence_shader);
+	if (divergence_shader == 0u) {
+		LogError("Failed to load divergence shader");
+		return;
+	}
+
+	GLuint smooth_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Multigrid smooth",
+	                                                "EDAF80/stable_fluids/mg_smooth.comp",
+	                                                smooth_shader);
+	if (smooth_shader == 0u) {
+		LogError("Failed to load multigrid smoothing shader");
+		return;
+	}
+
+	GLuint restrict_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Multigrid restrict",
+	                                                "EDAF80/stable_fluids/mg_restrict.comp",
+	                                                restrict_shader);
+	if (restrict_shader == 0u) {
+		LogError("Failed to load multigrid restriction shader");
+		return;
+	}
+
+	GLuint prolongate_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Multigrid prolongate",
+	                                                "EDAF80/stable_fluids/mg_prolongate.comp",
+	                                                prolongate_shader);
+	if (prolongate_shader == 0u) {
+		LogError("Failed to load multigrid prolongation shader");
+		return;
+	}
+
+	GLuint subtract_gradient_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Subtract pressure gradient",
+	                                                "EDAF80/stable_fluids/subtract_gradient.comp",
+	                                                subtract_gradient_shader);
+	if (subtract_gradient_shader == 0u) {
+		LogError("Failed to load pressure gradient shader");
+		return;
+	}
+
+	GLuint advect_dye_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Advect dye",
+	                                                "EDAF80/stable_fluids/advect_dye.comp",
+	                                                advect_dye_shader);
+	if (advect_dye_shader == 0u) {
+		LogError("Failed to load dye advection shader");
+		return;
+	}
+
+	GLuint visualise_shader = 0u;
+	program_manager.CreateAndRegisterComputeProgram("Visualise fluid",
+	                                                "EDAF80/stable_fluids/visualise.comp",
+	                                                visualise_shader);
+	if (visualise_shader == 0u) {
+		LogError("Failed to load visualisation shader");
+		return;
+	}
+
+	//
+	// Setup OpenGL objects
+	//
+	FluidTextures textures = createFluidTextures(gridSize);
+	std::vector<MultigridLevel> levels = createMultigridLevels(gridSize, coarsestLevelSize);
+	ElapsedTimeQueries const elapsed_time_queries = createElapsedTimeQueries();
+	GLuint const linear_sampler = createLinearSampler();
+	glm::ivec2 allocated_grid_size = gridSize;
+	int allocated_coarsest_size = coarsestLevelSize;
+	std::size_t velocity_read = 0;
+	std::size_t dye_read = 0;
+
+	auto const set_grid_uniforms = [](GLuint program, glm::ivec2 const& grid_size, float delta_time) {
+		glUniform2iv(glGetUniformLocation(program, "gridSize"), 1, glm::value_ptr(grid_size));
+		glUniform1f(glGetUniformLocation(program, "deltaTime"), delta_time);
+	};
+
+	// Red-black Gauss-Seidel sweeps on one level of the hierarchy.
+	auto const smooth = [&](MultigridLevel const& level, int iterations) {
+		glUseProgram(smooth_shader);
+		glUniform2iv(glGetUniformLocation(smooth_shader, "levelSize"), 1, glm::value_ptr(level.size));
+		glUniform1f(glGetUniformLocation(smooth_shader, "cellSize"), level.cell_size);
+		glBindImageTexture(0, level.pressure, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+		glBindImageTexture(1, level.rhs, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		for (int i = 0; i < iterations; ++i) {
+			for (int parity = 0; parity < 2; ++parity) {
+				glUniform1i(glGetUniformLocation(smooth_shader, "parity"), parity);
+				dispatchGrid(level.size);
+				imageBarrier();
+			}
+		}
+	};
+
+	auto const restrict_residual = [&](MultigridLevel const& fine, MultigridLevel const& coarse) {
+		glUseProgram(restrict_shader);
+		glUniform2iv(glGetUniformLocation(restrict_shader, "fineSize"), 1, glm::value_ptr(fine.size));
+		glUniform1f(glGetUniformLocation(restrict_shader, "fineCellSize"), fine.cell_size);
+		glBindImageTexture(0, fine.pressure, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(1, fine.rhs, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(2, coarse.rhs, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glBindImageTexture(3, coarse.pressure, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		dispatchGrid(coarse.size);
+		imageBarrier();
+	};
+
+	auto const prolongate = [&](MultigridLevel const& coarse, MultigridLevel const& fine) {
+		glUseProgram(prolongate_shader);
+		glUniform2iv(glGetUniformLocation(prolongate_shader, "fineSize"), 1, glm::value_ptr(fine.size));
+		glUniform2iv(glGetUniformLocation(prolongate_shader, "coarseSize"), 1, glm::value_ptr(coarse.size));
+		glBindImageTexture(0, fine.pressure, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+		glBindImageTexture(1, coarse.pressure, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		dispatchGrid(fine.size);
+		imageBarrier();
+	};
+
+
+	auto lastTime = std::chrono::high_resolution_clock::now();
+	std::array<GLuint64, toU(ElapsedTimeQuery::Count)> pass_elapsed_times{};
+	float seconds_nb = 0.0f;
+
+	bool pause_simulation = false;
+	bool show_logs = true;
+	bool show_gui = true;
+	bool shader_reload_failed = false;
+	bool copy_elapsed_times = true;
+	bool first_frame = true;
+	bool previous_splat = false;
+	glm::vec2 previous_mouse_position = glm::vec2(0.0f);
+
+	while (!glfwWindowShouldClose(window)) {
+		auto const nowTime = std::chrono::high_resolution_clock::now();
+		auto const deltaTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(nowTime - lastTime);
+		lastTime = nowTime;
+		float const frame_seconds = std::chrono::duration<float>(deltaTimeUs).count();
+		seconds_nb += frame_seconds;
+
+		auto& io = ImGui::GetIO();
+		inputHandler.SetUICapture(io.WantCaptureMouse, io.WantCaptureKeyboard);
+
+		glfwPollEvents();
+		inputHandler.Advance();
+
+		if (inputHandler.GetKeycodeState(GLFW_KEY_R) & JUST_PRESSED) {
+			shader_reload_failed = !program_manager.ReloadAllPrograms();
+			if (shader_reload_failed)
+				tinyfd_notifyPopup("Shader Program Reload Error",
+				                   "An error occurred while reloading shader programs; see the logs for details.\n"
+				                   "Rendering is suspended until the issue is solved. Once fixed, just reload the shaders again.",
+				                   "error");
+		}
+		if (program_manager.PollHotReload())
+			shader_reload_failed = false;
+		if (inputHandler.GetKeycodeState(GLFW_KEY_F3) & JUST_RELEASED)
+			show_logs = !show_logs;
+		if (inputHandler.GetKeycodeState(GLFW_KEY_F2) & JUST_RELEASED)
+			show_gui = !show_gui;
+		if (inputHandler.GetKeycodeState(GLFW_KEY_F11) & JUST_RELEASED)
+			mWindowManager.ToggleFullscreenStatusForWindow(window);
+
+		int framebuffer_width, framebuffer_height;
+		glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+		int window_width, window_height;
+		glfwGetWindowSize(window, &window_width, &window_height);
+
+		mWindowManager.NewImGuiFrame();
+
+		if (!first_frame && show_gui && copy_elapsed_times) {
+			// Copy all timings back from the GPU to the CPU.
+			for (GLuint i = 0; i < pass_elapsed_times.size(); ++i) {
+				glGetQueryObjectui64v(elapsed_time_queries[i], GL_QUERY_RESULT, pass_elapsed_times.data() + i);
+			}
+		}
+
+		if (allocated_grid_size != gridSize || allocated_coarsest_size != coarsestLevelSize) {
+			deleteFluidTextures(textures);
+			deleteMultigridLevels(levels);
+			textures = createFluidTextures(gridSize);
+			levels = createMultigridLevels(gridSize, coarsestLevelSize);
+			allocated_grid_size = gridSize;
+			allocated_coarsest_size = coarsestLevelSize;
+			velocity_read = 0;
+			dye_read = 0;
+		}
+
+		//
+		// Mouse interaction: dragging with the left button pushes the
+		// fluid along and injects dye, both as a Gaussian splat.
+		//
+		auto const mouse_position = inputHandler.GetMousePosition();
+		glm::vec2 const grid_mouse_position = glm::vec2(mouse_position.x / std::max(window_width, 1),
+		                                                1.0f - mouse_position.y / std::max(window_height, 1))
+		                                    * glm::vec2(gridSize);
+		bool const splat_active = (inputHandler.GetMouseState(GLFW_MOUSE_BUTTON_LEFT) & PRESSED) && !io.WantCaptureMouse;
+		float const delta_time = std::min(frame_seconds, 1.0f / 30.0f) * timeScale;
+		glm::vec2 splat_force = glm::vec2(0.0f);
+		if (splat_active && previous_splat && delta_time > 0.0f)
+			splat_force = splatForceScale * (grid_mouse_position - previous_mouse_position) / std::max(frame_seconds, 1e-3f) / delta_time;
+		previous_splat = splat_active;
+		previous_mouse_position = grid_mouse_position;
+		glm::vec3 const splat_colour = 0.5f + 0.5f * glm::cos(seconds_nb * glm::vec3(1.0f, 1.3f, 1.7f) + glm::vec3(0.0f, 2.0f, 4.0f));
+
+		glm::ivec2 const faces_size = gridSize + glm::ivec2(1);
+
+		if (!shader_reload_failed && !pause_simulation && delta_time > 0.0f) {
+			std::size_t const velocity_write = 1 - velocity_read;
+
+			//
+			// Pass 1: advect the velocity
+			//
+			utils::opengl::debug::beginDebugGroup("Advect velocity");
+			glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::VelocityAdvection)]);
+			glUseProgram(advect_velocity_shader);
+			set_grid_uniforms(advect_velocity_shader, gridSize, delta_time);
+			glUniform1f(glGetUniformLocation(advect_velocity_shader, "dissipation"), velocityDissipation);
+			bindSampledTexture(0, textures.velocity_u[velocity_read], linear_sampler);
+			bindSampledTexture(1, textures.velocity_v[velocity_read], linear_sampler);
+			glBindImageTexture(0, textures.velocity_u[velocity_write], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			glBindImageTexture(1, textures.velocity_v[velocity_write], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			dispatchGrid(faces_size);
+			imageBarrier();
+			velocity_read = velocity_write;
+			glEndQuery(GL_TIME_ELAPSED);
+			utils::opengl::debug::endDebugGroup();
+
+			GLuint const velocity_u = textures.velocity_u[velocity_read];
+			GLuint const velocity_v = textures.velocity_v[velocity_read];
+
+			//
+			// Pass 2: external forces
+			//
+			utils::opengl::debug::beginDebugGroup("Add forces");
+			glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::Forces)]);
+			glUseProgram(add_forces_shader);
+			set_grid_uniforms(add_forces_shader, gridSize, delta_time);
+			glUniform1i(glGetUniformLocation(add_forces_shader, "splatActive"), splat_active ? 1 : 0);
+			glUniform2fv(glGetUniformLocation(add_forces_shader, "splatPosition"), 1, glm::value_ptr(grid_mouse_position));
+			glUniform2fv(glGetUniformLocation(add_forces_shader, "splatForce"), 1, glm::value_ptr(splat_force));
+			glUniform1f(glGetUniformLocation(add_forces_shader, "splatRadius"), splatRadius);
+			glUniform1f(glGetUniformLocation(add_forces_shader, "buoyancy"), buoyancy);
+			glBindImageTexture(0, velocity_u, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+			glBindImageTexture(1, velocity_v, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+			glBindImageTexture(2, textures.dye[dye_read], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+			dispatchGrid(faces_size);
+			imageBarrier();
+			glEndQuery(GL_TIME_ELAPSED);
+			utils::opengl::debug::endDebugGroup();
+
+			//
+			// Pass 3: vorticity confinement
+			//
+			utils::opengl::debug::beginDebugGroup("Vorticity confinement");
+			glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::Vorticity)]);
+			glUseProgram(vorticity_shader);
+			set_grid_uniforms(vorticity_shader, gridSize, delta_time);
+			glBindImageTexture(0, velocity_u, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(1, velocity_v, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(2, textures.curl, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			dispatchGrid(gridSize);
+			imageBarrier();
+
+			if (vorticityConfinement > 0.0f) {
+				glUseProgram(vorticity_confinement_shader);
+				set_grid_uniforms(vorticity_confinement_shader, gridSize, delta_time);
+				glUniform1f(glGetUniformLocation(vorticity_confinement_shader, "confinement"), vorticityConfinement);
+				glBindImageTexture(0, velocity_u, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+				glBindImageTexture(1, velocity_v, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+				glBindImageTexture(2, textures.curl, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+				dispatchGrid(faces_size);
+				imageBarrier();
+			}
+			glEndQuery(GL_TIME_ELAPSED);
+			utils::opengl::debug::endDebugGroup();
+
+			//
+			// Pass 4: pressure projection, with the previous pressure as
+			// initial guess and multigrid V-cycles for the Poisson solve
+			//
+			utils::opengl::debug::beginDebugGroup("Pressure projection");
+			glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::PressureSolve)]);
+			glUseProgram(divergence_shader);
+			set_grid_uniforms(divergence_shader, gridSize, delta_time);
+			glBindImageTexture(0, velocity_u, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(1, velocity_v, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(2, levels.front().rhs, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			dispatchGrid(gridSize);
+			imageBarrier();
+
+			for (int cycle = 0; cycle < vCycles; ++cycle) {
+				for (std::size_t l = 0; l + 1 < levels.size(); ++l) {
+					smooth(levels[l], preSmoothIterations);
+					restrict_residual(levels[l], levels[l + 1]);
+				}
+				smooth(levels.back(), coarsestIterations);
+				for (std::size_t l = levels.size() - 1; l-- > 0;) {
+					prolongate(levels[l + 1], levels[l]);
+					smooth(levels[l], postSmoothIterations);
+				}
+			}
+
+			glUseProgram(subtract_gradient_shader);
+			set_grid_uniforms(subtract_gradient_shader, gridSize, delta_time);
+			glBindImageTexture(0, velocity_u, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+			glBindImageTexture(1, velocity_v, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+			glBindImageTexture(2, levels.front().pressure, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			dispatchGrid(faces_size);
+			imageBarrier();
+			glEndQuery(GL_TIME_ELAPSED);
+			utils::opengl::debug::endDebugGroup();
+
+			//
+			// Pass 5: advect the dye through the projected velocity
+			//
+			utils::opengl::debug::beginDebugGroup("Advect dye");
+			glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::DyeAdvection)]);
+			std::size_t const dye_write = 1 - dye_read;
+			glUseProgram(advect_dye_shader);
+			set_grid_uniforms(advect_dye_shader, gridSize, delta_time);
+			glUniform1f(glGetUniformLocation(advect_dye_shader, "dissipation"), dyeDissipation);
+			glUniform1i(glGetUniformLocation(advect_dye_shader, "splatActive"), splat_active ? 1 : 0);
+			glUniform2fv(glGetUniformLocation(advect_dye_shader, "splatPosition"), 1, glm::value_ptr(grid_mouse_position));
+			glUniform1f(glGetUniformLocation(advect_dye_shader, "splatRadius"), splatRadius);
+			glUniform3fv(glGetUniformLocation(advect_dye_shader, "splatColour"), 1, glm::value_ptr(splat_colour));
+			bindSampledTexture(0, velocity_u, linear_sampler);
+			bindSampledTexture(1, velocity_v, linear_sampler);
+			bindSampledTexture(2, textures.dye[dye_read], linear_sampler);
+			glBindImageTexture(0, textures.dye[dye_write], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+			dispatchGrid(gridSize);
+			imageBarrier();
+			dye_read = dye_write;
+			glEndQuery(GL_TIME_ELAPSED);
+			utils::opengl::debug::endDebugGroup();
+		}
+
+		//
+		// Pass 6: convert the selected field to colours and show it
+		// through the fullscreen texture display
+		//
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		if (!shader_reload_failed) {
+			utils::opengl::debug::beginDebugGroup("Visualise");
+			glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::Visualisation)]);
+			glUseProgram(visualise_shader);
+			glUniform2iv(glGetUniformLocation(visualise_shader, "gridSize"), 1, glm::value_ptr(gridSize));
+			glUniform1i(glGetUniformLocation(visualise_shader, "displayMode"), displayMode);
+			glUniform1f(glGetUniformLocation(visualise_shader, "displayScale"), displayScale);
+			glBindImageTexture(0, textures.dye[dye_read], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+			glBindImageTexture(1, textures.velocity_u[velocity_read], 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(2, textures.velocity_v[velocity_read], 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(3, levels.front().pressure, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(4, textures.curl, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(5, textures.display, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+			dispatchGrid(gridSize);
+			imageBarrier();
+			glUseProgram(0u);
+
+			bonobo::displayTexture({-1.0f, -1.0f}, {1.0f, 1.0f}, textures.display, linear_sampler, {0, 1, 2, -1}, glm::uvec2(framebuffer_width, framebuffer_height));
+			glEndQuery(GL_TIME_ELAPSED);
+			utils::opengl::debug::endDebugGroup();
+		}
+
+		//
+		// Reset viewport back to normal
+		//
+		glViewport(0, 0, framebuffer_width, framebuffer_height);
+
+		bool opened = ImGui::Begin("Stable fluids", nullptr, ImGuiWindowFlags_None);
+		if (opened) {
+			ImGui::Text("Grid: %d x %d cells, %zu multigrid levels", gridSize.x, gridSize.y, levels.size());
+			ImGui::Checkbox("Pause simulation", &pause_simulation);
+			if (ImGui::Button("Reset")) {
+				clearFluidTextures(textures);
+				for (auto const& level : levels)
+					glClearTexImage(level.pressure, 0, GL_RED, GL_FLOAT, nullptr);
+			}
+			ImGui::SliderFloat("Time scale", &timeScale, 0.0f, 4.0f);
+			ImGui::SliderFloat("Velocity dissipation", &velocityDissipation, 0.9f, 1.0f, "%.4f");
+			ImGui::SliderFloat("Dye dissipation", &dyeDissipation, 0.9f, 1.0f, "%.4f");
+			ImGui::SliderFloat("Vorticity confinement", &vorticityConfinement, 0.0f, 2.0f);
+			ImGui::SliderFloat("Buoyancy", &buoyancy, -50.0f, 50.0f);
+			ImGui::SliderFloat("Splat radius", &splatRadius, 1.0f, 64.0f);
+			ImGui::SliderFloat("Splat force scale", &splatForceScale, 0.0f, 4.0f);
+			ImGui::Separator();
+			ImGui::SliderInt("V-cycles", &vCycles, 0, 8);
+			ImGui::SliderInt("Pre-smoothing", &preSmoothIterations, 1, 8);
+			ImGui::SliderInt("Post-smoothing", &postSmoothIterations, 1, 8);
+			ImGui::SliderInt("Coarsest iterations", &coarsestIterations, 1, 64);
+			ImGui::SliderInt("Coarsest level size", &coarsestLevelSize, 2, 64);
+			ImGui::Separator();
+			ImGui::Combo("Display", &displayMode, "Dye\0Velocity\0Pressure\0Vorticity\0");
+			ImGui::SliderFloat("Display scale", &displayScale, 0.0001f, 1.0f, "%.4f", ImGuiSliderFlags_Logarithmic);
+		}
+		ImGui::End();
+
+		opened = ImGui::Begin("Render Time", nullptr, ImGuiWindowFlags_None);
+		if (opened) {
+			ImGui::Text("Frame CPU time: %.3f ms", std::chrono::duration<float, std::milli>(deltaTimeUs).count());
+
+			ImGui::Checkbox("Copy elapsed times back to CPU", &copy_elapsed_times);
+
+			if (ImGui::BeginTable("Pass durations", 2, ImGuiTableFlags_SizingFixedFit))
+			{
+				ImGui::TableSetupColumn("Pass");
+				ImGui::TableSetupColumn("GPU time [ms]");
+				ImGui::TableHeadersRow();
+
+				char const* const pass_names[] = { "Velocity advection", "Forces", "Vorticity", "Pressure solve", "Dye advection", "Visualisation" };
+				for (std::size_t i = 0; i < pass_elapsed_times.size(); ++i) {
+					ImGui::TableNextColumn();
+					ImGui::Text("%s", pass_names[i]);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", pass_elapsed_times[i] / 1000000.0f);
+				}
+
+				ImGui::EndTable();
+			}
+		}
+		ImGui::End();
+
+		if (show_logs)
+			Log::View::Render();
+		mWindowManager.RenderImGuiFrame(show_gui);
+
+		glfwSwapBuffers(window);
+
+		first_frame = false;
+	}
+
+	glDeleteSamplers(1, &linear_sampler);
+	glDeleteQueries(static_cast<GLsizei>(elapsed_time_queries.size()), elapsed_time_queries.data());
+	deleteMultigridLevels(levels);
+	deleteFluidTextures(textures);
+}
+
+int main()
+{
+	std::setlocale(LC_ALL, "");
+
+	Bonobo framework;
+
+	try {
+		edaf80::StableFluids stable_fluids(framework.GetWindowManager());
+		stable_fluids.run();
+	} catch (std::runtime_error const& e) {
+		LogError(e.what());
+	}
+}
+
+namespace
+{
+GLuint createFieldTexture(glm::ivec2 const& size, GLenum internal_format, GLenum format, std::string const& name)
+{
+	GLuint texture = 0u;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, internal_format, size.x, size.y);
+	glClearTexImage(texture, 0, format, GL_FLOAT, nullptr);
+	utils::opengl::debug::nameObject(GL_TEXTURE, texture, name);
+	glBindTexture(GL_TEXTURE_2D, 0u);
+	return texture;
+}
+
+FluidTextures createFluidTextures(glm::ivec2 const& grid_size)
+{
+	FluidTextures textures;
+	for (std::size_t i = 0; i < 2; ++i) {
+		auto const suffix = " " + std::to_string(i);
+		textures.velocity_u[i] = createFieldTexture(grid_size + glm::ivec2(1, 0), GL_R32F, GL_RED, "Velocity u" + suffix);
+		textures.velocity_v[i] = createFieldTexture(grid_size + glm::ivec2(0, 1), GL_R32F, GL_RED, "Velocity v" + suffix);
+		textures.dye[i] = createFieldTexture(grid_size, GL_RGBA16F, GL_RGBA, "Dye" + suffix);
+	}
+	textures.curl = createFieldTexture(grid_size, GL_R32F, GL_RED, "Curl");
+	textures.display = createFieldTexture(grid_size, GL_RGBA8, GL_RGBA, "Fluid display");
+	return textures;
+}
+
+void deleteFluidTextures(FluidTextures& textures)
+{
+	glDeleteTextures(2, textures.velocity_u.data());
+	glDeleteTextures(2, textures.velocity_v.data());
+	glDeleteTextures(2, textures.dye.data());
+	glDeleteTextures(1, &textures.curl);
+	glDeleteTextures(1, &textures.display);
+}
+
+void clearFluidTextures(FluidTextures const& textures)
+{
+	for (std::size_t i = 0; i < 2; ++i) {
+		glClearTexImage(textures.velocity_u[i], 0, GL_RED, GL_FLOAT, nullptr);
+		glClearTexImage(textures.velocity_v[i], 0, GL_RED, GL_FLOAT, nullptr);
+		glClearTexImage(textures.dye[i], 0, GL_RGBA, GL_FLOAT, nullptr);
+	}
+	glClearTexImage(textures.curl, 0, GL_RED, GL_FLOAT, nullptr);
+}
+
+std::vector<MultigridLevel> createMultigridLevels(glm::ivec2 const& grid_size, int coarsest_size)
+{
+	// Keep halving the grid as long as both axes stay even and the coarse
+	// level does not drop below `coarsest_size` cells.
+	std::vector<MultigridLevel> levels;
+	glm::ivec2 size = grid_size;
+	float cell_size = 1.0f;
+	while (true) {
+		auto const level = std::to_string(levels.size());
+		levels.push_back({ size, cell_size,
+		                   createFieldTexture(size, GL_R32F, GL_RED, "Pressure level " + level),
+		                   createFieldTexture(size, GL_R32F, GL_RED, "Divergence level " + level) });
+		if (size.x % 2 != 0 || size.y % 2 != 0 || std::min(size.x, size.y) / 2 < coarsest_size)
+			break;
+		size /= 2;
+		cell_size *= 2.0f;
+	}
+	return levels;
+}
+
+void deleteMultigridLevels(std::vector<MultigridLevel>& levels)
+{
+	for (auto& level : levels) {
+		glDeleteTextures(1, &level.pressure);
+		glDeleteTextures(1, &level.rhs);
+	}
+	levels.clear();
+}
+
+ElapsedTimeQueries createElapsedTimeQueries()
+{
+	ElapsedTimeQueries queries;
+	glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+
+	if (utils::opengl::debug::isSupported())
+	{
+		// Queries (like any other OpenGL object) need to have been used at least
+		// once to ensure their resources have been allocated so we can call
+		// `glObjectLabel()` on them.
+		auto const register_query = [](GLuint const query, std::string const& name) {
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			glEndQuery(GL_TIME_ELAPSED);
+			utils::opengl::debug::nameObject(GL_QUERY, query, name);
+		};
+
+		register_query(queries[toU(ElapsedTimeQuery::VelocityAdvection)], "Velocity advection");
+		register_query(queries[toU(ElapsedTimeQuery::Forces)], "Forces");
+		register_query(queries[toU(ElapsedTimeQuery::Vorticity)], "Vorticity confinement");
+		register_query(queries[toU(ElapsedTimeQuery::PressureSolve)], "Pressure solve");
+		register_query(queries[toU(ElapsedTimeQuery::DyeAdvection)], "Dye advection");
+		register_query(queries[toU(ElapsedTimeQuery::Visualisation)], "Visualisation");
+	}
+
+	return queries;
+}
+
+GLuint createLinearSampler()
+{
+	GLuint sampler = 0u;
+	glGenSamplers(1, &sampler);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	utils::opengl::debug::nameObject(GL_SAMPLER, sampler, "Linear clamped");
+	return sampler;
+}
+} // namespace
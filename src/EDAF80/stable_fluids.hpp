@@ -0,0 +1,71 @@
+#pragma once
+
+#include "core/InputHandler.h"
+#include "core/FPSCamera.h"
+#include "core/WindowManager.hpp"
+
+class Window;
+
+
+namespace edaf80
+{
+	//! \brief Eulerian counterpart of `project`: a stable-fluids solver on
+	//!        a 2D MAC grid, running entirely in compute shaders.
+	//!
+	//! Each step advects the velocity (semi-Lagrangian), applies the mouse
+	//! and buoyancy forces as well as vorticity confinement, and projects
+	//! the velocity onto its divergence-free part with a geometric
+	//! multigrid V-cycle. The dye is then advected through the projected
+	//! velocity, and dye, velocity, pressure or vorticity get displayed
+	//! fullscreen.
+	class StableFluids {
+	public:
+		//! \brief Default constructor.
+		//!
+		//! It will initialise various modules of bonobo and retrieve a
+		//! window to draw to.
+		StableFluids(WindowManager& windowManager);
+
+		//! \brief Default destructor.
+		//!
+		//! It will release the bonobo modules initialised by the
+		//! constructor, as well as the window.
+		~StableFluids();
+
+		//! \brief Contains the logic of the solver, along with the
+		//! render loop.
+		void run();
+
+	private:
+		FPSCameraf     mCamera;
+		InputHandler   inputHandler;
+		WindowManager& mWindowManager;
+		GLFWwindow*    window;
+
+		//grid resolution, in cells; both axes should be divisible by a
+		//few powers of two to get a deep multigrid hierarchy
+		glm::ivec2 gridSize = glm::ivec2(512, 256);
+
+		//solver parameters
+		float timeScale = 1.0f;
+		float velocityDissipation = 0.999f;
+		float dyeDissipation = 0.995f;
+		float vorticityConfinement = 0.35f;
+		float buoyancy = 0.0f;
+
+		//multigrid pressure solve
+		int vCycles = 2;
+		int preSmoothIterations = 2;
+		int postSmoothIterations = 2;
+		int coarsestIterations = 16;
+		int coarsestLevelSize = 8;
+
+		//mouse interaction (radius in cells)
+		float splatRadius = 8.0f;
+		float splatForceScale = 1.0f;
+
+		//visualisation: 0 = dye, 1 = velocity, 2 = pressure, 3 = vorticity
+		int displayMode = 0;
+		float displayScale = 0.02f;
+	};
+}
@@ -7,10 +7,12 @@
 #include "config.hpp"
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
+#include "core/FrameArena.hpp"
 #include "core/helpers.hpp"
 #include "core/node.hpp"
 #include "core/opengl.hpp"
 #include "core/ShaderProgramManager.hpp"
+#include "core/StreamBuffer.hpp"
 
 #include <imgui.h>
 #include <glm/glm.hpp>
@@ -94,8 +96,6 @@ namespace
 		LightViewProjTransforms,
 		Count
 	};
-	using UBOs = std::array<GLuint, toU(UBO::Count)>;
-	UBOs createUniformBufferObjects();
 
 	struct ViewProjTransforms
 	{
@@ -241,7 +241,14 @@ edan35::Assignment2::run()
 	FBOs const fbos = createFramebufferObjects(textures);
 	Samplers const samplers = createSamplers();
 	ElapsedTimeQueries const elapsed_time_queries = createElapsedTimeQueries();
-	UBOs const ubos = createUniformBufferObjects();
+	// Camera and light transforms are written every frame to a new slot of
+	// this buffer, and bound from there to the binding points of |UBO|.
+	auto const ubo_alignment = StreamBuffer::uniform_alignment();
+	auto const ubo_stride = [ubo_alignment](GLsizeiptr size) {
+		return (size + ubo_alignment - 1) / ubo_alignment * ubo_alignment;
+	};
+	StreamBuffer ubos_stream(ubo_stride(sizeof(ViewProjTransforms)) + ubo_stride(constant::lights_nb * sizeof(ViewProjTransforms)));
+	utils::opengl::debug::nameObject(GL_BUFFER, ubos_stream.get_buffer(), "View-projection transforms");
 
 	//
 	// Load all the shader programs used
@@ -320,10 +327,10 @@ edan35::Assignment2::run()
 
 	const GLuint debug_texture_id = bonobo::getDebugTextureID();
 
-	auto const bind_texture_with_sampler = [](GLenum target, unsigned int slot, GLuint program, std::string const& name, GLuint texture, GLuint sampler){
+	auto const bind_texture_with_sampler = [](GLenum target, unsigned int slot, GLuint program, char const* name, GLuint texture, GLuint sampler){
 		glActiveTexture(GL_TEXTURE0 + slot);
 		glBindTexture(target, texture);
-		glUniform1i(glGetUniformLocation(program, name.c_str()), static_cast<GLint>(slot));
+		glUniform1i(glGetUniformLocation(program, name), static_cast<GLint>(slot));
 		glBindSampler(slot, sampler);
 	};
 
@@ -399,6 +406,9 @@ edan35::Assignment2::run()
 
 		auto const view_projection = camera_view_proj_transforms.view_projection;
 
+		// Programs failing to rebuild keep their previous version, while
+		// the others are replaced, along with their uniform locations.
+		bool were_programs_replaced = false;
 		if (inputHandler.GetKeycodeState(GLFW_KEY_R) & JUST_PRESSED) {
 			shader_reload_failed = !program_manager.ReloadAllPrograms();
 			if (shader_reload_failed)
@@ -408,12 +418,16 @@ edan35::Assignment2::run()
 				                   "Rendering is suspended until the issue is solved. Once fixed, just reload the shaders again.",
 				                   "error");
 			}
-			else
-			{
-				fillGBufferShaderLocations(fill_gbuffer_shader, fill_gbuffer_shader_locations);
-				fillShadowmapShaderLocations(fill_shadowmap_shader, fill_shadowmap_shader_locations);
-				fillAccumulateLightsShaderLocations(accumulate_lights_shader, accumulate_light_shader_locations);
-			}
+			were_programs_replaced = true;
+		}
+		if (program_manager.PollHotReload()) {
+			shader_reload_failed = false;
+			were_programs_replaced = true;
+		}
+		if (were_programs_replaced) {
+			fillGBufferShaderLocations(fill_gbuffer_shader, fill_gbuffer_shader_locations);
+			fillShadowmapShaderLocations(fill_shadowmap_shader, fill_shadowmap_shader_locations);
+			fillAccumulateLightsShaderLocations(accumulate_lights_shader, accumulate_light_shader_locations);
 		}
 		if (inputHandler.GetKeycodeState(GLFW_KEY_F3) & JUST_RELEASED)
 			show_logs = !show_logs;
@@ -446,11 +460,11 @@ edan35::Assignment2::run()
 		//
 		// Update per-frame changing UBOs.
 		//
-		glBindBuffer(GL_UNIFORM_BUFFER, ubos[toU(UBO::CameraViewProjTransforms)]);
-		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(camera_view_proj_transforms), &camera_view_proj_transforms);
-		glBindBuffer(GL_UNIFORM_BUFFER, ubos[toU(UBO::LightViewProjTransforms)]);
-		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(light_view_proj_transforms), light_view_proj_transforms.data());
-		glBindBuffer(GL_UNIFORM_BUFFER, 0u);
+		ubos_stream.begin_frame();
+		auto const camera_transforms_offset = ubos_stream.write(&camera_view_proj_transforms, sizeof(camera_view_proj_transforms), ubo_alignment);
+		auto const light_transforms_offset = ubos_stream.write(light_view_proj_transforms.data(), sizeof(light_view_proj_transforms), ubo_alignment);
+		glBindBufferRange(GL_UNIFORM_BUFFER, toU(UBO::CameraViewProjTransforms), ubos_stream.get_buffer(), camera_transforms_offset, sizeof(camera_view_proj_transforms));
+		glBindBufferRange(GL_UNIFORM_BUFFER, toU(UBO::LightViewProjTransforms), ubos_stream.get_buffer(), light_transforms_offset, sizeof(light_view_proj_transforms));
 
 
 		if (!shader_reload_failed) {
@@ -541,7 +555,7 @@ edan35::Assignment2::run()
 				//
 				// Pass 2.1: Generate shadow map for light i
 				//
-				utils::opengl::debug::beginDebugGroup("Create shadow map " + std::to_string(i));
+				utils::opengl::debug::beginDebugGroup(FrameArena::frame().format("Create shadow map %u", static_cast<unsigned int>(i)));
 				glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::ShadowMap0Generation) + i]);
 
 				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::ShadowMap)]);
@@ -592,7 +606,7 @@ edan35::Assignment2::run()
 				glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
 				//
 				// Pass 2.2: Accumulate light i contribution
-				utils::opengl::debug::beginDebugGroup("Accumulate light " + std::to_string(i));
+				utils::opengl::debug::beginDebugGroup(FrameArena::frame().format("Accumulate light %u", static_cast<unsigned int>(i)));
 				glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::Light0Accumulation) + i]);
 
 				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::LightAccumulation)]);
@@ -834,7 +848,6 @@ edan35::Assignment2::run()
 		first_frame = false;
 	}
 
-	glDeleteBuffers(static_cast<GLsizei>(ubos.size()), ubos.data());
 	glDeleteQueries(static_cast<GLsizei>(elapsed_time_queries.size()), elapsed_time_queries.data());
 	glDeleteSamplers(static_cast<GLsizei>(samplers.size()), samplers.data());
 	glDeleteFramebuffers(static_cast<GLsizei>(fbos.size()), fbos.data());
@@ -1039,25 +1052,6 @@ ElapsedTimeQueries createElapsedTimeQueries()
 	return queries;
 }
 
-UBOs createUniformBufferObjects()
-{
-	UBOs ubos;
-	glGenBuffers(static_cast<GLsizei>(ubos.size()), ubos.data());
-
-	glBindBuffer(GL_UNIFORM_BUFFER, ubos[toU(UBO::CameraViewProjTransforms)]);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(ViewProjTransforms), nullptr, GL_STREAM_DRAW);
-	glBindBufferBase(GL_UNIFORM_BUFFER, toU(UBO::CameraViewProjTransforms), ubos[toU(UBO::CameraViewProjTransforms)]);
-	utils::opengl::debug::nameObject(GL_BUFFER, ubos[toU(UBO::CameraViewProjTransforms)], "Camera view-projection transforms");
-
-	glBindBuffer(GL_UNIFORM_BUFFER, ubos[toU(UBO::LightViewProjTransforms)]);
-	glBufferData(GL_UNIFORM_BUFFER, constant::lights_nb * sizeof(ViewProjTransforms), nullptr, GL_STREAM_DRAW);
-	glBindBufferBase(GL_UNIFORM_BUFFER, toU(UBO::LightViewProjTransforms), ubos[toU(UBO::LightViewProjTransforms)]);
-	utils::opengl::debug::nameObject(GL_BUFFER, ubos[toU(UBO::LightViewProjTransforms)], "Light view-projection transforms");
-
-	glBindBuffer(GL_UNIFORM_BUFFER, 0u);
-	return ubos;
-}
-
 void fillGBufferShaderLocations(GLuint gbuffer_shader, GBufferShaderLocations& locations)
 {
 	locations.ubo_CameraViewProjTransforms = glGetUniformBlockIndex(gbuffer_shader, "CameraViewProjTransforms");
@@ -0,0 +1,84 @@
+#include "AsyncReadback.hpp"
+
+#include "Log.h"
+
+AsyncReadback::AsyncReadback(GLsizeiptr slot_size) : _slot_size(slot_size)
+{
+	glGenBuffers(1, &_buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, _slot_size * static_cast<GLsizeiptr>(slot_count), nullptr, GL_STREAM_READ);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+}
+
+AsyncReadback::~AsyncReadback()
+{
+	discard();
+	glDeleteBuffers(1, &_buffer);
+	_buffer = 0u;
+}
+
+bool
+AsyncReadback::request(GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	if (size > _slot_size) {
+		LogError("Reading %d bytes back through %d-byte slots.",
+		         static_cast<int>(size), static_cast<int>(_slot_size));
+		return false;
+	}
+	if (_in_flight == slot_count)
+		return false;
+
+	auto const index = (_oldest + _in_flight) % slot_count;
+	auto& slot = _slots[index];
+
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset,
+	                    static_cast<GLintptr>(index) * _slot_size, size);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0u);
+	slot.size = size;
+	++_in_flight;
+	return true;
+}
+
+bool
+AsyncReadback::poll(void* data)
+{
+	if (_in_flight == 0u)
+		return false;
+
+	auto& slot = _slots[_oldest];
+	auto const status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0u);
+	if (status == GL_TIMEOUT_EXPIRED)
+		return false;
+
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+	auto const index = _oldest;
+	_oldest = (_oldest + 1u) % slot_count;
+	--_in_flight;
+	if (status == GL_WAIT_FAILED) {
+		LogError("Waiting on an asynchronous readback failed.");
+		return false;
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, _buffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, static_cast<GLintptr>(index) * _slot_size, slot.size, data);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+	return true;
+}
+
+void
+AsyncReadback::discard()
+{
+	for (auto& slot : _slots) {
+		if (slot.fence != nullptr)
+			glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+	}
+	_oldest = 0u;
+	_in_flight = 0u;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+
+//! \brief Copies of small ranges of GPU buffers, read by the CPU once the
+//!        GPU is done with them rather than right away.
+//!
+//! |request()| copies a range of a buffer to one of |slot_count| slots of
+//! a readback buffer and inserts a fence after the copy. |poll()| hands
+//! out the data of the oldest request whose fence has been signalled, and
+//! never waits: the data is typically a frame or two old. Requests made
+//! while every slot is still in flight are dropped.
+//!
+//! Reading a buffer directly with |glGetBufferSubData()| instead waits for
+//! every command writing to it to finish, stalling the CPU on the GPU.
+class AsyncReadback
+{
+public:
+	static GLuint const slot_count = 3u;
+
+	//! \brief Create the readback buffer, made of |slot_count| slots of
+	//!        |slot_size| bytes.
+	explicit AsyncReadback(GLsizeiptr slot_size);
+	~AsyncReadback();
+	AsyncReadback(AsyncReadback const&) = delete;
+	AsyncReadback& operator=(AsyncReadback const&) = delete;
+
+	//! \brief Copy |size| bytes at |offset| of |buffer| to the next free
+	//!        slot, once the shader writes issued so far are done.
+	//!
+	//! @return false if every slot is in flight, or |size| exceeds the
+	//!         size of a slot
+	bool request(GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+	//! \brief Copy the data of the oldest finished request to |data|,
+	//!        which has to hold the size given to |request()|.
+	//!
+	//! @return false if no request has finished yet
+	bool poll(void* data);
+
+	//! \brief Drop every request in flight, e.g. when what they read has
+	//!        been reset.
+	void discard();
+
+private:
+	struct Slot {
+		GLsync fence = nullptr;
+		GLsizeiptr size = 0;
+	};
+
+	GLuint _buffer = 0u;
+	GLsizeiptr _slot_size = 0;
+	std::array<Slot, slot_count> _slots{};
+	GLuint _oldest = 0u;
+	GLuint _in_flight = 0u;
+};
@@ -0,0 +1,338 @@
+#include "BufferInspector.hpp"
+
+#include "Log.h"
+#include "ShaderProgramManager.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+namespace
+{
+	// Must match REDUCE_WORK_GROUP_SIZE and REDUCE_MAX_BINS in
+	// common/buffer_reduce.comp.
+	std::uint32_t const work_group_size = 256u;
+	std::uint32_t const max_bin_count = 64u;
+
+	// Pass 0 uses at most that many work groups, each of them looping over
+	// its share of the elements.
+	std::uint32_t const max_partial_count = 1024u;
+
+	// min, max, sum and count, followed by the histogram.
+	std::size_t const result_header_size = 4u * sizeof(GLuint);
+
+	char const* const component_names[] = { "x", "y", "z", "w" };
+
+	struct SavedBinding {
+		GLint buffer = 0;
+		GLint64 start = 0;
+		GLint64 size = 0;
+	};
+
+	SavedBinding save_binding(GLuint index)
+	{
+		SavedBinding binding;
+		glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, index, &binding.buffer);
+		glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_START, index, &binding.start);
+		glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_SIZE, index, &binding.size);
+		return binding;
+	}
+
+	void restore_binding(GLuint index, SavedBinding const& binding)
+	{
+		if (binding.buffer != 0 && binding.size > 0)
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, static_cast<GLuint>(binding.buffer),
+			                  static_cast<GLintptr>(binding.start), static_cast<GLsizeiptr>(binding.size));
+		else
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, static_cast<GLuint>(binding.buffer));
+	}
+
+	std::size_t result_slot_size()
+	{
+		GLint alignment = 1;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		auto const unaligned = result_header_size + max_bin_count * sizeof(GLuint);
+		auto const align = static_cast<std::size_t>(std::max(alignment, 1));
+		return (unaligned + align - 1u) / align * align;
+	}
+}
+
+BufferInspector::BufferInspector(ShaderProgramManager& program_manager)
+{
+	program_manager.CreateAndRegisterComputeProgram("Buffer inspector reductions", "common/buffer_reduce.comp", _program);
+
+	glGenBuffers(1, &_partial_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, _partial_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, max_partial_count * 3u * sizeof(GLfloat), nullptr, GL_DYNAMIC_COPY);
+	glGenBuffers(1, &_result_buffer);
+	glGenBuffers(1, &_readback_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u);
+}
+
+BufferInspector::~BufferInspector()
+{
+	if (_fence != nullptr)
+		glDeleteSync(_fence);
+	glDeleteBuffers(1, &_readback_buffer);
+	glDeleteBuffers(1, &_result_buffer);
+	glDeleteBuffers(1, &_partial_buffer);
+}
+
+void
+BufferInspector::register_buffer(std::string const& name, GLuint buffer, std::uint32_t stride,
+                                 std::uint32_t element_count, std::vector<Field> const& fields)
+{
+	auto& entry = _buffers[name];
+	entry.buffer = buffer;
+	entry.stride = stride;
+	entry.element_count = element_count;
+
+	std::vector<Field> valid_fields;
+	for (auto const& field : fields) {
+		if (stride % 4u != 0u || field.offset % 4u != 0u || field.components == 0u || field.components > 4u
+		    || field.offset + field.components * sizeof(GLfloat) > stride) {
+			LogError("Field '%s' of buffer '%s' does not fit its %u-byte stride, or is not made of 1 to 4 aligned floats.",
+			         field.name.c_str(), name.c_str(), stride);
+			continue;
+		}
+		valid_fields.push_back(field);
+	}
+
+	// Keep the selection of the fields when only the handle or the count
+	// changed.
+	bool const same_fields = entry.fields.size() == valid_fields.size()
+	                         && std::equal(entry.fields.begin(), entry.fields.end(), valid_fields.begin(),
+	                                       [](Field const& a, Field const& b){
+	                                           return a.name == b.name && a.offset == b.offset && a.components == b.components;
+	                                       });
+	if (!same_fields) {
+		entry.fields = std::move(valid_fields);
+		entry.probes.assign(entry.fields.size(), Probe{});
+	}
+}
+
+void
+BufferInspector::update()
+{
+	++_frame;
+
+	if (_fence != nullptr) {
+		auto const status = glClientWaitSync(_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0u);
+		if (status == GL_TIMEOUT_EXPIRED)
+			return;
+		glDeleteSync(_fence);
+		_fence = nullptr;
+		if (status == GL_WAIT_FAILED)
+			LogError("Waiting on the buffer inspector readback failed.");
+		else
+			collect();
+	}
+
+	auto const attached = _buffers.find(_attached);
+	if (attached == _buffers.end() || _program == 0u || attached->second.buffer == 0u)
+		return;
+	issue(attached->second);
+	_pending.buffer = attached->first;
+}
+
+void
+BufferInspector::issue(RegisteredBuffer const& buffer)
+{
+	_pending = Readback{};
+	_pending.stride = buffer.stride;
+	_pending.bin_count = static_cast<std::uint32_t>(_bin_count);
+	_pending.frame = _frame;
+	for (std::size_t i = 0u; i < buffer.probes.size(); ++i)
+		if (buffer.probes[i].enabled)
+			_pending.probes.push_back(i);
+	if (buffer.element_count > 0u)
+		for (auto const index : _sample_indices)
+			if (index >= 0 && static_cast<std::uint32_t>(index) < buffer.element_count)
+				_pending.samples.push_back(static_cast<std::uint32_t>(index));
+
+	auto const slot_size = result_slot_size();
+	auto const results_size = _pending.probes.size() * slot_size;
+	_pending.size = results_size + _pending.samples.size() * buffer.stride;
+	if (_pending.size == 0u)
+		return;
+
+	if (results_size > _result_capacity) {
+		_result_capacity = results_size;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _result_buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(_result_capacity), nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u);
+	}
+	if (_pending.size > _readback_capacity) {
+		_readback_capacity = _pending.size;
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _readback_buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(_readback_capacity), nullptr, GL_STREAM_READ);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+	}
+
+	GLint previous_program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previous_program);
+	SavedBinding const previous_bindings[] = { save_binding(0u), save_binding(1u), save_binding(2u) };
+
+	// Whatever wrote to the inspected buffer must be visible to the
+	// reductions and to the copies of the samples.
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	if (!_pending.probes.empty()) {
+		glUseProgram(_program);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0u, buffer.buffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1u, _partial_buffer);
+
+		auto const group_count = std::max(1u, std::min((buffer.element_count + work_group_size - 1u) / work_group_size, max_partial_count));
+		glUniform1ui(glGetUniformLocation(_program, "elementCount"), buffer.element_count);
+		glUniform1ui(glGetUniformLocation(_program, "strideWords"), buffer.stride / 4u);
+		glUniform1ui(glGetUniformLocation(_program, "partialCount"), group_count);
+		glUniform1ui(glGetUniformLocation(_program, "binCount"), _pending.bin_count);
+
+		for (std::size_t slot = 0u; slot < _pending.probes.size(); ++slot) {
+			auto const& field = buffer.fields[_pending.probes[slot]];
+			auto const& probe = buffer.probes[_pending.probes[slot]];
+			auto const component = probe.component < static_cast<int>(field.components) ? probe.component : -1;
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 2u, _result_buffer, static_cast<GLintptr>(slot * slot_size), static_cast<GLsizeiptr>(slot_size));
+			glUniform1ui(glGetUniformLocation(_program, "offsetWords"), field.offset / 4u);
+			glUniform1ui(glGetUniformLocation(_program, "componentCount"), field.components);
+			glUniform1i(glGetUniformLocation(_program, "component"), component);
+
+			glUniform1ui(glGetUniformLocation(_program, "reducePass"), 0u);
+			glDispatchCompute(group_count, 1u, 1u);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+			glUniform1ui(glGetUniformLocation(_program, "reducePass"), 1u);
+			glDispatchCompute(1u, 1u, 1u);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+			glUniform1ui(glGetUniformLocation(_program, "reducePass"), 2u);
+			glDispatchCompute(group_count, 1u, 1u);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+		}
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _readback_buffer);
+	if (results_size > 0u) {
+		glBindBuffer(GL_COPY_READ_BUFFER, _result_buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(results_size));
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer.buffer);
+	for (std::size_t i = 0u; i < _pending.samples.size(); ++i)
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+		                    static_cast<GLintptr>(_pending.samples[i]) * buffer.stride,
+		                    static_cast<GLintptr>(results_size + i * buffer.stride),
+		                    static_cast<GLsizeiptr>(buffer.stride));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+	_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0u);
+
+	for (GLuint i = 0u; i < 3u; ++i)
+		restore_binding(i, previous_bindings[i]);
+	glUseProgram(static_cast<GLuint>(previous_program));
+}
+
+void
+BufferInspector::collect()
+{
+	auto const entry = _buffers.find(_pending.buffer);
+	if (entry == _buffers.end() || _pending.size == 0u)
+		return;
+
+	std::vector<std::uint8_t> data(_pending.size);
+	glBindBuffer(GL_COPY_READ_BUFFER, _readback_buffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>(data.size()), data.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+
+	auto const slot_size = result_slot_size();
+	for (std::size_t slot = 0u; slot < _pending.probes.size(); ++slot) {
+		if (_pending.probes[slot] >= entry->second.probes.size())
+			break;
+		auto& probe = entry->second.probes[_pending.probes[slot]];
+		auto const* const result = data.data() + slot * slot_size;
+		float sum = 0.0f;
+		GLuint count = 0u;
+		std::memcpy(&probe.min, result, sizeof(float));
+		std::memcpy(&probe.max, result + 4u, sizeof(float));
+		std::memcpy(&sum, result + 8u, sizeof(float));
+		std::memcpy(&count, result + 12u, sizeof(GLuint));
+		probe.mean = count > 0u ? sum / static_cast<float>(count) : 0.0f;
+		probe.histogram.resize(_pending.bin_count);
+		for (std::size_t bin = 0u; bin < probe.histogram.size(); ++bin) {
+			GLuint value = 0u;
+			std::memcpy(&value, result + result_header_size + bin * sizeof(GLuint), sizeof(GLuint));
+			probe.histogram[bin] = static_cast<float>(value);
+		}
+		probe.has_results = true;
+	}
+
+	auto const results_size = _pending.probes.size() * slot_size;
+	_sampled_indices = _pending.samples;
+	_sampled_bytes.assign(data.begin() + static_cast<std::ptrdiff_t>(results_size), data.end());
+	_sampled_stride = _pending.stride;
+	_result_frame = _pending.frame;
+}
+
+void
+BufferInspector::render_ui()
+{
+	if (ImGui::BeginCombo("Buffer", _attached.empty() ? "None" : _attached.c_str())) {
+		if (ImGui::Selectable("None", _attached.empty()))
+			_attached.clear();
+		for (auto const& buffer : _buffers)
+			if (ImGui::Selectable(buffer.first.c_str(), buffer.first == _attached))
+				_attached = buffer.first;
+		ImGui::EndCombo();
+	}
+
+	auto const attached = _buffers.find(_attached);
+	if (attached == _buffers.end())
+		return;
+	auto& buffer = attached->second;
+
+	ImGui::Text("%u elements of %u bytes", buffer.element_count, buffer.stride);
+	ImGui::SliderInt("Histogram bins", &_bin_count, 4, static_cast<int>(max_bin_count));
+	if (_result_frame > 0u)
+		ImGui::Text("Results from %llu frame(s) ago", static_cast<unsigned long long>(_frame - _result_frame));
+
+	for (std::size_t i = 0u; i < buffer.fields.size(); ++i) {
+		auto const& field = buffer.fields[i];
+		auto& probe = buffer.probes[i];
+		ImGui::PushID(static_cast<int>(i));
+		ImGui::Checkbox(field.name.c_str(), &probe.enabled);
+		if (field.components > 1u) {
+			char const* labels[5];
+			for (std::uint32_t c = 0u; c < field.components; ++c)
+				labels[c] = component_names[c];
+			labels[field.components] = "length";
+			ImGui::SameLine();
+			ImGui::SetNextItemWidth(80.0f);
+			ImGui::Combo("##component", &probe.component, labels, static_cast<int>(field.components) + 1);
+		}
+		if (probe.enabled && probe.has_results) {
+			ImGui::Text("min %g, max %g, mean %g", probe.min, probe.max, probe.mean);
+			ImGui::PlotHistogram("##histogram", probe.histogram.data(), static_cast<int>(probe.histogram.size()),
+			                     0, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+		}
+		ImGui::PopID();
+	}
+
+	ImGui::Separator();
+	ImGui::InputInt4("Sampled elements", _sample_indices);
+	if (_sampled_stride != attached->second.stride)
+		return;
+	for (std::size_t s = 0u; s < _sampled_indices.size(); ++s) {
+		if ((s + 1u) * _sampled_stride > _sampled_bytes.size())
+			break;
+		ImGui::Text("[%u]", _sampled_indices[s]);
+		for (auto const& field : buffer.fields) {
+			float values[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			std::memcpy(values, _sampled_bytes.data() + s * _sampled_stride + field.offset, field.components * sizeof(float));
+			switch (field.components) {
+			case 1u: ImGui::BulletText("%s: %g", field.name.c_str(), values[0]); break;
+			case 2u: ImGui::BulletText("%s: (%g, %g)", field.name.c_str(), values[0], values[1]); break;
+			case 3u: ImGui::BulletText("%s: (%g, %g, %g)", field.name.c_str(), values[0], values[1], values[2]); break;
+			default: ImGui::BulletText("%s: (%g, %g, %g, %g)", field.name.c_str(), values[0], values[1], values[2], values[3]); break;
+			}
+		}
+	}
+}
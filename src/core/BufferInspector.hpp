@@ -0,0 +1,109 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class ShaderProgramManager;
+
+//! \brief ImGui inspector of the shader storage buffers used by the
+//!        simulations, which never stalls the frame.
+//!
+//! Buffers are registered under a name with the float fields of the
+//! structures they store. When one of them is attached in the UI, the
+//! min, max, mean and histogram of each selected field are computed on the
+//! GPU by `common/buffer_reduce.comp`, and only those results, along with
+//! a few sampled elements, are copied to a small readback buffer guarded
+//! by a fence. The CPU picks them up in a later frame, once the fence is
+//! signalled, so the statistics shown lag a few frames behind.
+class BufferInspector
+{
+public:
+	//! \brief Float field of the structures stored in a buffer.
+	struct Field {
+		std::string name;
+		std::uint32_t offset;     //!< in bytes, from the start of the structure
+		std::uint32_t components; //!< number of consecutive floats
+	};
+
+	explicit BufferInspector(ShaderProgramManager& program_manager);
+	~BufferInspector();
+
+	BufferInspector(BufferInspector const&) = delete;
+	BufferInspector& operator=(BufferInspector const&) = delete;
+
+	//! \brief Make |buffer| available for inspection, or update it if
+	//!        |name| is already registered (e.g. after a reallocation).
+	//!
+	//! Fields which are not 4-byte aligned or do not fit in |stride| are
+	//! rejected.
+	void register_buffer(std::string const& name, GLuint buffer, std::uint32_t stride,
+	                     std::uint32_t element_count, std::vector<Field> const& fields);
+
+	//! \brief Collect the results of a finished readback, and issue the
+	//!        reductions of the attached buffer if none is in flight.
+	//!
+	//! Call once per frame, after the passes writing to the inspected
+	//! buffers. The current program and the shader storage bindings 0 to 2
+	//! are restored on return.
+	void update();
+
+	//! \brief Select the buffer and fields to inspect, and show the last
+	//!        results received.
+	void render_ui();
+
+private:
+	struct Probe {
+		bool enabled = false;
+		int component = 0; //!< index of the float, or the component count for the length
+		bool has_results = false;
+		float min = 0.0f;
+		float max = 0.0f;
+		float mean = 0.0f;
+		std::vector<float> histogram;
+	};
+
+	struct RegisteredBuffer {
+		GLuint buffer = 0u;
+		std::uint32_t stride = 0u;
+		std::uint32_t element_count = 0u;
+		std::vector<Field> fields;
+		std::vector<Probe> probes; //!< one per field
+	};
+
+	struct Readback {
+		std::string buffer;
+		std::vector<std::size_t> probes;     //!< fields reduced, in slot order
+		std::vector<std::uint32_t> samples;  //!< elements copied after the slots
+		std::uint32_t stride = 0u;
+		std::uint32_t bin_count = 0u;
+		std::size_t size = 0u;
+		std::uint64_t frame = 0u;
+	};
+
+	void issue(RegisteredBuffer const& buffer);
+	void collect();
+
+	GLuint _program = 0u;
+	GLuint _partial_buffer = 0u;
+	GLuint _result_buffer = 0u;
+	GLuint _readback_buffer = 0u;
+	std::size_t _result_capacity = 0u;
+	std::size_t _readback_capacity = 0u;
+	GLsync _fence = nullptr;
+	Readback _pending;
+
+	std::map<std::string, RegisteredBuffer> _buffers;
+	std::string _attached;
+	int _bin_count = 32;
+	int _sample_indices[4] = { 0, 1, 2, 3 };
+
+	std::uint64_t _frame = 0u;
+	std::uint64_t _result_frame = 0u;
+	std::vector<std::uint32_t> _sampled_indices;
+	std::vector<std::uint8_t> _sampled_bytes;
+	std::uint32_t _sampled_stride = 0u;
+};
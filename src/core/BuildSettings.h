@@ -31,3 +31,9 @@
 *	Turn off for maximum performance.
 */
 #define ENABLE_GL_STATE_INSPECTION		1
+
+/*
+*	Enables (1) or disables (0) counting heap allocations, by replacing the global operator new (found in FrameArena.cpp)
+*	Turn off for maximum performance.
+*/
+#define ENABLE_ALLOCATION_COUNTING		1
@@ -7,6 +7,7 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/io.hpp>
 
+#include <array>
 #include <chrono>
 #include <iostream>
 
@@ -35,6 +36,13 @@ public:
 	glm::tvec3<T, P> GetClipToWorld(glm::tvec3<T, P> xyw);
 	glm::tvec3<T, P> GetClipToView(glm::tvec3<T, P> xyw);
 
+	//! \brief Extract the six world-space planes bounding the view frustum.
+	//!
+	//! The planes are ordered left, right, bottom, top, near and far; each
+	//! one is stored as (n, d) with a unit normal n pointing inside the
+	//! frustum, so that a point p is inside when dot(n, p) + d >= 0.
+	std::array<glm::tvec4<T, P>, 6> GetFrustumPlanes();
+
 public:
 	TRSTransform<T, P> mWorld;
 	glm::tvec3<T, P> mMovementSpeed;
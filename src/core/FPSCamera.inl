@@ -127,3 +127,25 @@ glm::tvec3<T, P> FPSCamera<T, P>::GetClipToView(glm::tvec3<T, P> xyw)
 {
 	return xyw * glm::tvec3<T, P>(mProjectionInverse[0][0], mProjectionInverse[1][1], static_cast<T>(-1));
 }
+
+template<typename T, glm::precision P>
+std::array<glm::tvec4<T, P>, 6> FPSCamera<T, P>::GetFrustumPlanes()
+{
+	glm::tmat4x4<T, P> const m = GetWorldToClipMatrix();
+	auto const row = [&m](int i) {
+		return glm::tvec4<T, P>(m[0][i], m[1][i], m[2][i], m[3][i]);
+	};
+
+	std::array<glm::tvec4<T, P>, 6> planes = {
+		row(3) + row(0),
+		row(3) - row(0),
+		row(3) + row(1),
+		row(3) - row(1),
+		row(3) + row(2),
+		row(3) - row(2)
+	};
+	for (auto& plane : planes)
+		plane /= glm::length(glm::tvec3<T, P>(plane));
+
+	return planes;
+}
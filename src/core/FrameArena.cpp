@@ -0,0 +1,205 @@
+#include "FrameArena.hpp"
+
+#include "BuildSettings.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace
+{
+	std::atomic<std::uint64_t> heap_allocation_count{ 0u };
+
+	FrameArena::Counters frame_counters;
+	std::uint64_t frame_start_heap_allocations = 0u;
+	bool overlay_visible = false;
+
+	std::size_t next_power_of_two(std::size_t value)
+	{
+		std::size_t power = 1u;
+		while (power < value)
+			power <<= 1u;
+		return power;
+	}
+
+	void* align(unsigned char* base, std::size_t offset, std::size_t alignment)
+	{
+		auto const address = reinterpret_cast<std::uintptr_t>(base) + offset;
+		return reinterpret_cast<void*>((address + alignment - 1u) & ~static_cast<std::uintptr_t>(alignment - 1u));
+	}
+}
+
+#if ENABLE_ALLOCATION_COUNTING
+// Replacements of the global allocation functions, counting every call;
+// the array and nothrow forms forward to these by default.
+void* operator new(std::size_t size)
+{
+	heap_allocation_count.fetch_add(1u, std::memory_order_relaxed);
+	if (size == 0u)
+		size = 1u;
+	for (;;) {
+		if (void* const memory = std::malloc(size))
+			return memory;
+		auto const handler = std::get_new_handler();
+		if (handler == nullptr)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+#endif
+
+FrameArena::FrameArena(std::size_t capacity) :
+	_block(new unsigned char[std::max<std::size_t>(capacity, 1u)]),
+	_capacity(std::max<std::size_t>(capacity, 1u))
+{
+}
+
+void*
+FrameArena::allocate(std::size_t size, std::size_t alignment)
+{
+	++_allocations;
+
+	auto* const memory = align(_block.get(), _head, alignment);
+	auto const offset = static_cast<std::size_t>(static_cast<unsigned char*>(memory) - _block.get());
+	if (offset + size <= _capacity) {
+		_head = offset + size;
+		return memory;
+	}
+
+	// Served by the heap until the next reset, which makes room for it.
+	auto const overflow_size = size + alignment;
+	_overflow.emplace_back(new unsigned char[overflow_size]);
+	_overflow_bytes += overflow_size;
+	return align(_overflow.back().get(), 0u, alignment);
+}
+
+void
+FrameArena::reset()
+{
+	if (!_overflow.empty()) {
+		_capacity = next_power_of_two(_head + _overflow_bytes);
+		_block.reset(new unsigned char[_capacity]);
+		_overflow.clear();
+	}
+	_head = 0u;
+	_overflow_bytes = 0u;
+	_allocations = 0u;
+}
+
+char const*
+FrameArena::format(char const* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	va_list measure_args;
+	va_copy(measure_args, args);
+	auto const length = std::vsnprintf(nullptr, 0, format, measure_args);
+	va_end(measure_args);
+	if (length < 0) {
+		va_end(args);
+		return "";
+	}
+
+	auto* const text = static_cast<char*>(allocate(static_cast<std::size_t>(length) + 1u, 1u));
+	std::vsnprintf(text, static_cast<std::size_t>(length) + 1u, format, args);
+	va_end(args);
+	return text;
+}
+
+char const*
+FrameArena::concat(char const* lhs, char const* rhs)
+{
+	auto const lhs_length = std::strlen(lhs);
+	auto const rhs_length = std::strlen(rhs);
+	auto* const text = static_cast<char*>(allocate(lhs_length + rhs_length + 1u, 1u));
+	std::memcpy(text, lhs, lhs_length);
+	std::memcpy(text + lhs_length, rhs, rhs_length + 1u);
+	return text;
+}
+
+FrameArena::Counters
+FrameArena::get_counters() const
+{
+	Counters counters;
+	counters.allocations = _allocations;
+	counters.bytes = _head + _overflow_bytes;
+	counters.overflow_bytes = _overflow_bytes;
+	counters.capacity = _capacity;
+	return counters;
+}
+
+FrameArena&
+FrameArena::frame()
+{
+	static FrameArena arena;
+	return arena;
+}
+
+void
+FrameArena::begin_frame()
+{
+	auto& arena = frame();
+	auto const heap_allocations = get_heap_allocation_count();
+	frame_counters = arena.get_counters();
+	frame_counters.heap_allocations = heap_allocations - frame_start_heap_allocations;
+	arena.reset();
+	frame_start_heap_allocations = heap_allocations;
+}
+
+FrameArena::Counters const&
+FrameArena::get_frame_counters()
+{
+	return frame_counters;
+}
+
+std::uint64_t
+FrameArena::get_heap_allocation_count()
+{
+	return heap_allocation_count.load(std::memory_order_relaxed);
+}
+
+void
+FrameArena::toggle_overlay()
+{
+	overlay_visible = !overlay_visible;
+}
+
+void
+FrameArena::render_overlay()
+{
+	if (!overlay_visible)
+		return;
+
+	bool const opened = ImGui::Begin("Frame memory", &overlay_visible, ImGuiWindowFlags_AlwaysAutoResize);
+	if (opened) {
+#if ENABLE_ALLOCATION_COUNTING
+		ImGui::Text("Heap allocations: %llu", static_cast<unsigned long long>(frame_counters.heap_allocations));
+#else
+		ImGui::TextUnformatted("Heap allocations: not counted");
+#endif
+		ImGui::Separator();
+		ImGui::Text("Arena allocations: %u", static_cast<unsigned int>(frame_counters.allocations));
+		ImGui::Text("Arena usage: %.1f / %.1f KiB",
+		            static_cast<float>(frame_counters.bytes) / 1024.0f,
+		            static_cast<float>(frame_counters.capacity) / 1024.0f);
+		if (frame_counters.overflow_bytes > 0u)
+			ImGui::Text("Overflowed to the heap: %.1f KiB", static_cast<float>(frame_counters.overflow_bytes) / 1024.0f);
+	}
+	ImGui::End();
+}
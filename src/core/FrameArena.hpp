@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__has_include)
+#	if __has_include(<memory_resource>) && ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
+#		include <memory_resource>
+#		define FRAME_ARENA_HAS_PMR 1
+#	endif
+#endif
+
+//! \brief Linear allocator for data that only lives until the end of the
+//!        frame.
+//!
+//! Allocating bumps an offset within a single block, and freeing does
+//! nothing: all allocations are released at once by |reset()|. Requests
+//! not fitting in the block are served by the heap until the next reset,
+//! which then grows the block to hold everything the frame allocated, so
+//! that steady frames never touch the heap.
+//!
+//! The arena returned by |frame()| is reset by |begin_frame()|, called by
+//! the window manager at the start of every frame; it belongs to the main
+//! thread, and nothing allocated from it may be kept across frames.
+class FrameArena
+{
+public:
+	struct Counters {
+		std::uint64_t heap_allocations = 0u; //!< calls to the global operator new
+		std::size_t allocations = 0u;        //!< allocations served by the arena
+		std::size_t bytes = 0u;              //!< bytes allocated from the arena
+		std::size_t overflow_bytes = 0u;     //!< part of them served by the heap
+		std::size_t capacity = 0u;           //!< size of the block of the arena
+	};
+
+	explicit FrameArena(std::size_t capacity = 1u << 20);
+	FrameArena(FrameArena const&) = delete;
+	FrameArena& operator=(FrameArena const&) = delete;
+
+	//! \brief Uninitialised storage for |size| bytes, aligned to
+	//!        |alignment|, which has to be a power of two.
+	void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+	//! \brief Release every allocation made since the last reset.
+	void reset();
+
+	//! \brief printf-like formatting into the arena.
+	//!
+	//! @return a null-terminated string, valid until the next reset
+	char const* format(char const* format, ...);
+
+	//! \brief Null-terminated copy of |lhs| followed by |rhs|, valid until
+	//!        the next reset.
+	char const* concat(char const* lhs, char const* rhs);
+
+	//! \brief Counters of the allocations made since the last reset; the
+	//!        heap allocation count is left to zero.
+	Counters get_counters() const;
+
+	//! \brief Arena of the main thread, reset every frame.
+	static FrameArena& frame();
+
+	//! \brief Reset |frame()|, making the counters of the frame that just
+	//!        ended available through |get_frame_counters()|.
+	static void begin_frame();
+
+	//! \brief Counters of the last complete frame.
+	static Counters const& get_frame_counters();
+
+	//! \brief Number of calls to the global operator new since the start
+	//!        of the program; always zero if ENABLE_ALLOCATION_COUNTING is
+	//!        disabled in BuildSettings.h.
+	static std::uint64_t get_heap_allocation_count();
+
+	//! \brief Show or hide the overlay drawn by |render_overlay()|.
+	static void toggle_overlay();
+
+	//! \brief Draw the counters of the last complete frame in a Dear ImGui
+	//!        window, if the overlay is visible.
+	static void render_overlay();
+
+private:
+	std::unique_ptr<unsigned char[]> _block;
+	std::size_t _capacity = 0u;
+	std::size_t _head = 0u;
+	std::vector<std::unique_ptr<unsigned char[]>> _overflow;
+	std::size_t _overflow_bytes = 0u;
+	std::size_t _allocations = 0u;
+};
+
+//! \brief Standard allocator drawing from a FrameArena, |FrameArena::frame()|
+//!        unless specified otherwise.
+template<typename T>
+class FrameAllocator
+{
+public:
+	using value_type = T;
+
+	FrameAllocator() noexcept : _arena(&FrameArena::frame()) {}
+	explicit FrameAllocator(FrameArena& arena) noexcept : _arena(&arena) {}
+	template<typename U>
+	FrameAllocator(FrameAllocator<U> const& other) noexcept : _arena(other.get_arena()) {}
+
+	T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T*, std::size_t) noexcept {}
+
+	FrameArena* get_arena() const noexcept { return _arena; }
+
+private:
+	FrameArena* _arena;
+};
+
+template<typename T, typename U>
+bool operator==(FrameAllocator<T> const& lhs, FrameAllocator<U> const& rhs) noexcept
+{
+	return lhs.get_arena() == rhs.get_arena();
+}
+
+template<typename T, typename U>
+bool operator!=(FrameAllocator<T> const& lhs, FrameAllocator<U> const& rhs) noexcept
+{
+	return !(lhs == rhs);
+}
+
+using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+#if defined(FRAME_ARENA_HAS_PMR)
+//! \brief Adapter for the containers of `std::pmr`.
+class FrameMemoryResource : public std::pmr::memory_resource
+{
+public:
+	explicit FrameMemoryResource(FrameArena& arena = FrameArena::frame()) noexcept : _arena(arena) {}
+
+private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override
+	{
+		return _arena.allocate(bytes, alignment);
+	}
+	void do_deallocate(void*, std::size_t, std::size_t) override {}
+	bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+	{
+		auto const frame_resource = dynamic_cast<FrameMemoryResource const*>(&other);
+		return frame_resource != nullptr && &frame_resource->_arena == &_arena;
+	}
+
+	FrameArena& _arena;
+};
+#endif
@@ -0,0 +1,51 @@
+#include "FrameUniforms.hpp"
+
+#include "ShaderProgramManager.hpp"
+
+namespace
+{
+	// Mirrors the std140 layout of the `FrameUniforms` block, where vec3
+	// members are aligned to 16 bytes.
+	struct FrameBlock {
+		glm::mat4 vertex_world_to_clip;
+		glm::vec3 camera_position;
+		float padding0;
+		glm::vec3 light_position;
+		float padding1;
+	};
+	static_assert(sizeof(FrameBlock) == 96u, "FrameBlock must match the std140 layout of the FrameUniforms block.");
+
+	// Updates fitting in one region of the stream buffer.
+	GLsizeiptr const updates_per_region = 16;
+
+	GLsizeiptr aligned_block_size()
+	{
+		auto const alignment = StreamBuffer::uniform_alignment();
+		return (static_cast<GLsizeiptr>(sizeof(FrameBlock)) + alignment - 1) / alignment * alignment;
+	}
+}
+
+FrameUniforms::FrameUniforms() :
+	_block_stride(aligned_block_size()),
+	_stream(updates_per_region * _block_stride)
+{
+	ShaderProgramManager::RegisterUniformBlockBinding("FrameUniforms", frame_binding);
+	ShaderProgramManager::RegisterUniformBlockBinding("MaterialConstants", material_binding);
+}
+
+void
+FrameUniforms::update(glm::mat4 const& world_to_clip, glm::vec3 const& camera_position,
+                      glm::vec3 const& light_position)
+{
+	FrameBlock const block = { world_to_clip, camera_position, 0.0f, light_position, 0.0f };
+
+	auto const offset = _stream.write(&block, sizeof(FrameBlock), _block_stride);
+	if (offset >= 0)
+		glBindBufferRange(GL_UNIFORM_BUFFER, frame_binding, _stream.get_buffer(), offset, sizeof(FrameBlock));
+}
+
+GLuint
+FrameUniforms::get_buffer() const
+{
+	return _stream.get_buffer();
+}
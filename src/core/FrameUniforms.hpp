@@ -0,0 +1,48 @@
+#pragma once
+
+#include "StreamBuffer.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+//! \brief Camera and light shared by every draw of a frame.
+//!
+//! The values live in a uniform buffer bound to the std140 block
+//!
+//!     layout (std140) uniform FrameUniforms {
+//!         mat4 vertex_world_to_clip;
+//!         vec3 camera_position;
+//!         vec3 light_position;
+//!     };
+//!
+//! of the EDAF80 shaders, which is written once per frame by |update()|
+//! rather than before each draw. Its members are accessed without an
+//! instance name, so shader code reads them as plain uniforms.
+//!
+//! Each update goes to a new slot of a |StreamBuffer|, so it never
+//! overwrites values that draws of previous frames may still read.
+//!
+//! Creating an instance registers the binding points of that block and
+//! of the `MaterialConstants` block written by |Node|, so it has to be
+//! done before creating the programs using them.
+class FrameUniforms
+{
+public:
+	static GLuint const frame_binding = 1u;
+	static GLuint const material_binding = 2u;
+
+	FrameUniforms();
+	FrameUniforms(FrameUniforms const&) = delete;
+	FrameUniforms& operator=(FrameUniforms const&) = delete;
+
+	//! \brief Upload the values for the coming frame, and bind them to
+	//!        |frame_binding|.
+	void update(glm::mat4 const& world_to_clip, glm::vec3 const& camera_position,
+	            glm::vec3 const& light_position);
+
+	GLuint get_buffer() const;
+
+private:
+	GLsizeiptr _block_stride;
+	StreamBuffer _stream;
+};
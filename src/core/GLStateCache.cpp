@@ -0,0 +1,528 @@
+#include "GLStateCache.hpp"
+
+#include <imgui.h>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	template<typename T>
+	struct Cached {
+		T value{};
+		bool known = false;
+	};
+
+	struct IndexedBinding {
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size; // -1 for the whole buffer
+	};
+
+	struct State {
+		Cached<GLuint> program;
+		Cached<GLuint> vertex_array;
+		std::unordered_map<GLenum, Cached<GLuint>> buffers;
+		std::unordered_map<std::uint64_t, Cached<IndexedBinding>> indexed_buffers;
+		Cached<GLenum> active_texture;
+		std::unordered_map<std::uint64_t, Cached<GLuint>> textures;
+		std::unordered_map<GLuint, Cached<GLuint>> samplers;
+		std::unordered_map<GLenum, Cached<bool>> capabilities;
+		Cached<std::pair<GLenum, GLenum>> blend_func;
+		Cached<GLenum> depth_func;
+		Cached<GLboolean> depth_mask;
+		Cached<GLenum> cull_face;
+		Cached<GLenum> polygon_mode;
+		Cached<GLuint> draw_framebuffer;
+		Cached<GLuint> read_framebuffer;
+	};
+
+	struct Entries {
+		PFNGLUSEPROGRAMPROC use_program = nullptr;
+		PFNGLDELETEPROGRAMPROC delete_program = nullptr;
+		PFNGLBINDVERTEXARRAYPROC bind_vertex_array = nullptr;
+		PFNGLDELETEVERTEXARRAYSPROC delete_vertex_arrays = nullptr;
+		PFNGLBINDBUFFERPROC bind_buffer = nullptr;
+		PFNGLBINDBUFFERBASEPROC bind_buffer_base = nullptr;
+		PFNGLBINDBUFFERRANGEPROC bind_buffer_range = nullptr;
+		PFNGLDELETEBUFFERSPROC delete_buffers = nullptr;
+		PFNGLACTIVETEXTUREPROC active_texture = nullptr;
+		PFNGLBINDTEXTUREPROC bind_texture = nullptr;
+		PFNGLDELETETEXTURESPROC delete_textures = nullptr;
+		PFNGLBINDSAMPLERPROC bind_sampler = nullptr;
+		PFNGLDELETESAMPLERSPROC delete_samplers = nullptr;
+		PFNGLENABLEPROC enable = nullptr;
+		PFNGLDISABLEPROC disable = nullptr;
+		PFNGLBLENDFUNCPROC blend_func = nullptr;
+		PFNGLBLENDFUNCSEPARATEPROC blend_func_separate = nullptr;
+		PFNGLDEPTHFUNCPROC depth_func = nullptr;
+		PFNGLDEPTHMASKPROC depth_mask = nullptr;
+		PFNGLCULLFACEPROC cull_face = nullptr;
+		PFNGLPOLYGONMODEPROC polygon_mode = nullptr;
+		PFNGLBINDFRAMEBUFFERPROC bind_framebuffer = nullptr;
+		PFNGLDELETEFRAMEBUFFERSPROC delete_framebuffers = nullptr;
+		PFNGLDRAWARRAYSPROC draw_arrays = nullptr;
+		PFNGLDRAWELEMENTSPROC draw_elements = nullptr;
+		PFNGLDRAWARRAYSINSTANCEDPROC draw_arrays_instanced = nullptr;
+		PFNGLDRAWELEMENTSINSTANCEDPROC draw_elements_instanced = nullptr;
+		PFNGLDRAWARRAYSINDIRECTPROC draw_arrays_indirect = nullptr;
+		PFNGLDRAWELEMENTSINDIRECTPROC draw_elements_indirect = nullptr;
+		PFNGLMULTIDRAWARRAYSINDIRECTPROC multi_draw_arrays_indirect = nullptr;
+		PFNGLMULTIDRAWELEMENTSINDIRECTPROC multi_draw_elements_indirect = nullptr;
+	};
+
+	// The entry points as loaded by GLAD, called by the cache when a call
+	// has to reach the driver.
+	Entries driver;
+	State state;
+	GLStateCache::Counters current_counters;
+	GLStateCache::Counters frame_counters;
+	bool installed = false;
+	bool overlay_visible = false;
+
+	// Record a call of |category| setting |cached| to |value|, and return
+	// whether it has to be forwarded.
+	template<typename T>
+	bool update(Cached<T>& cached, T const& value, GLStateCache::Category category)
+	{
+		auto const index = static_cast<std::size_t>(category);
+		if (cached.known && cached.value == value) {
+			++current_counters.skipped[index];
+			return false;
+		}
+		cached.value = value;
+		cached.known = true;
+		++current_counters.issued[index];
+		return true;
+	}
+
+	void count_forwarded(GLStateCache::Category category)
+	{
+		++current_counters.issued[static_cast<std::size_t>(category)];
+	}
+
+	bool operator==(IndexedBinding const& a, IndexedBinding const& b)
+	{
+		return a.buffer == b.buffer && a.offset == b.offset && a.size == b.size;
+	}
+
+	std::uint64_t make_key(GLuint high, GLenum low)
+	{
+		return (static_cast<std::uint64_t>(high) << 32) | static_cast<std::uint64_t>(low);
+	}
+
+	// Forget the cached bindings to any of the |n| deleted |names|: the
+	// driver reverted them to 0, and the names may be handed out again.
+	template<typename Map>
+	void forget_names(Map& bindings, GLsizei n, GLuint const* names)
+	{
+		for (auto& binding : bindings)
+			for (GLsizei i = 0; i < n; ++i)
+				if (binding.second.value == names[i])
+					binding.second.known = false;
+	}
+
+	void forget_name(Cached<GLuint>& binding, GLsizei n, GLuint const* names)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+			if (binding.value == names[i])
+				binding.known = false;
+	}
+
+	void APIENTRY cached_use_program(GLuint program)
+	{
+		if (update(state.program, program, GLStateCache::Category::program))
+			driver.use_program(program);
+	}
+
+	void APIENTRY cached_delete_program(GLuint program)
+	{
+		forget_name(state.program, 1, &program);
+		driver.delete_program(program);
+	}
+
+	void APIENTRY cached_bind_vertex_array(GLuint array)
+	{
+		if (update(state.vertex_array, array, GLStateCache::Category::vertex_array))
+			driver.bind_vertex_array(array);
+	}
+
+	void APIENTRY cached_delete_vertex_arrays(GLsizei n, GLuint const* arrays)
+	{
+		forget_name(state.vertex_array, n, arrays);
+		driver.delete_vertex_arrays(n, arrays);
+	}
+
+	void APIENTRY cached_bind_buffer(GLenum target, GLuint buffer)
+	{
+		if (target == GL_ELEMENT_ARRAY_BUFFER) {
+			count_forwarded(GLStateCache::Category::buffer);
+			driver.bind_buffer(target, buffer);
+			return;
+		}
+		if (update(state.buffers[target], buffer, GLStateCache::Category::buffer))
+			driver.bind_buffer(target, buffer);
+	}
+
+	// The generic binding of an indexed target can change on its own, so
+	// the indexed binding being known does not make it redundant.
+	void bind_generic_buffer(GLenum target, GLuint buffer)
+	{
+		auto& generic = state.buffers[target];
+		if (generic.known && generic.value == buffer)
+			return;
+		generic.value = buffer;
+		generic.known = true;
+		count_forwarded(GLStateCache::Category::buffer);
+		driver.bind_buffer(target, buffer);
+	}
+
+	void APIENTRY cached_bind_buffer_base(GLenum target, GLuint index, GLuint buffer)
+	{
+		// Binding an indexed target also binds its generic target.
+		IndexedBinding const binding = { buffer, 0, -1 };
+		if (update(state.indexed_buffers[make_key(index, target)], binding, GLStateCache::Category::buffer)) {
+			auto& generic = state.buffers[target];
+			generic.value = buffer;
+			generic.known = true;
+			driver.bind_buffer_base(target, index, buffer);
+		}
+		else {
+			bind_generic_buffer(target, buffer);
+		}
+	}
+
+	void APIENTRY cached_bind_buffer_range(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+	{
+		IndexedBinding const binding = { buffer, offset, size };
+		if (update(state.indexed_buffers[make_key(index, target)], binding, GLStateCache::Category::buffer)) {
+			auto& generic = state.buffers[target];
+			generic.value = buffer;
+			generic.known = true;
+			driver.bind_buffer_range(target, index, buffer, offset, size);
+		}
+		else {
+			bind_generic_buffer(target, buffer);
+		}
+	}
+
+	void APIENTRY cached_delete_buffers(GLsizei n, GLuint const* buffers)
+	{
+		forget_names(state.buffers, n, buffers);
+		for (auto& binding : state.indexed_buffers)
+			for (GLsizei i = 0; i < n; ++i)
+				if (binding.second.value.buffer == buffers[i])
+					binding.second.known = false;
+		driver.delete_buffers(n, buffers);
+	}
+
+	void APIENTRY cached_active_texture(GLenum texture)
+	{
+		if (update(state.active_texture, texture, GLStateCache::Category::texture))
+			driver.active_texture(texture);
+	}
+
+	void APIENTRY cached_bind_texture(GLenum target, GLuint texture)
+	{
+		// Without knowing the active unit, the binding cannot be keyed.
+		if (!state.active_texture.known) {
+			count_forwarded(GLStateCache::Category::texture);
+			driver.bind_texture(target, texture);
+			return;
+		}
+		if (update(state.textures[make_key(state.active_texture.value - GL_TEXTURE0, target)], texture, GLStateCache::Category::texture))
+			driver.bind_texture(target, texture);
+	}
+
+	void APIENTRY cached_delete_textures(GLsizei n, GLuint const* textures)
+	{
+		forget_names(state.textures, n, textures);
+		driver.delete_textures(n, textures);
+	}
+
+	void APIENTRY cached_bind_sampler(GLuint unit, GLuint sampler)
+	{
+		if (update(state.samplers[unit], sampler, GLStateCache::Category::sampler))
+			driver.bind_sampler(unit, sampler);
+	}
+
+	void APIENTRY cached_delete_samplers(GLsizei n, GLuint const* samplers)
+	{
+		forget_names(state.samplers, n, samplers);
+		driver.delete_samplers(n, samplers);
+	}
+
+	void APIENTRY cached_enable(GLenum cap)
+	{
+		if (update(state.capabilities[cap], true, GLStateCache::Category::fixed_function))
+			driver.enable(cap);
+	}
+
+	void APIENTRY cached_disable(GLenum cap)
+	{
+		if (update(state.capabilities[cap], false, GLStateCache::Category::fixed_function))
+			driver.disable(cap);
+	}
+
+	void APIENTRY cached_blend_func(GLenum sfactor, GLenum dfactor)
+	{
+		if (update(state.blend_func, std::make_pair(sfactor, dfactor), GLStateCache::Category::fixed_function))
+			driver.blend_func(sfactor, dfactor);
+	}
+
+	void APIENTRY cached_blend_func_separate(GLenum sfactor_rgb, GLenum dfactor_rgb, GLenum sfactor_alpha, GLenum dfactor_alpha)
+	{
+		state.blend_func.known = false;
+		count_forwarded(GLStateCache::Category::fixed_function);
+		driver.blend_func_separate(sfactor_rgb, dfactor_rgb, sfactor_alpha, dfactor_alpha);
+	}
+
+	void APIENTRY cached_depth_func(GLenum func)
+	{
+		if (update(state.depth_func, func, GLStateCache::Category::fixed_function))
+			driver.depth_func(func);
+	}
+
+	void APIENTRY cached_depth_mask(GLboolean flag)
+	{
+		if (update(state.depth_mask, flag, GLStateCache::Category::fixed_function))
+			driver.depth_mask(flag);
+	}
+
+	void APIENTRY cached_cull_face(GLenum mode)
+	{
+		if (update(state.cull_face, mode, GLStateCache::Category::fixed_function))
+			driver.cull_face(mode);
+	}
+
+	void APIENTRY cached_polygon_mode(GLenum face, GLenum mode)
+	{
+		// Core profiles only accept GL_FRONT_AND_BACK; anything else is
+		// left for the driver to report.
+		if (face != GL_FRONT_AND_BACK) {
+			state.polygon_mode.known = false;
+			count_forwarded(GLStateCache::Category::fixed_function);
+			driver.polygon_mode(face, mode);
+			return;
+		}
+		if (update(state.polygon_mode, mode, GLStateCache::Category::fixed_function))
+			driver.polygon_mode(face, mode);
+	}
+
+	void APIENTRY cached_bind_framebuffer(GLenum target, GLuint framebuffer)
+	{
+		auto const category = GLStateCache::Category::framebuffer;
+		if (target == GL_FRAMEBUFFER) {
+			bool const unchanged = state.draw_framebuffer.known && state.draw_framebuffer.value == framebuffer
+			                    && state.read_framebuffer.known && state.read_framebuffer.value == framebuffer;
+			if (unchanged) {
+				++current_counters.skipped[static_cast<std::size_t>(category)];
+				return;
+			}
+			state.draw_framebuffer = { framebuffer, true };
+			state.read_framebuffer = { framebuffer, true };
+			count_forwarded(category);
+			driver.bind_framebuffer(target, framebuffer);
+			return;
+		}
+		auto& binding = target == GL_READ_FRAMEBUFFER ? state.read_framebuffer : state.draw_framebuffer;
+		if (update(binding, framebuffer, category))
+			driver.bind_framebuffer(target, framebuffer);
+	}
+
+	void APIENTRY cached_delete_framebuffers(GLsizei n, GLuint const* framebuffers)
+	{
+		forget_name(state.draw_framebuffer, n, framebuffers);
+		forget_name(state.read_framebuffer, n, framebuffers);
+		driver.delete_framebuffers(n, framebuffers);
+	}
+
+	void APIENTRY counted_draw_arrays(GLenum mode, GLint first, GLsizei count)
+	{
+		++current_counters.draws;
+		driver.draw_arrays(mode, first, count);
+	}
+
+	void APIENTRY counted_draw_elements(GLenum mode, GLsizei count, GLenum type, void const* indices)
+	{
+		++current_counters.draws;
+		driver.draw_elements(mode, count, type, indices);
+	}
+
+	void APIENTRY counted_draw_arrays_instanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+	{
+		++current_counters.draws;
+		driver.draw_arrays_instanced(mode, first, count, instancecount);
+	}
+
+	void APIENTRY counted_draw_elements_instanced(GLenum mode, GLsizei count, GLenum type, void const* indices, GLsizei instancecount)
+	{
+		++current_counters.draws;
+		driver.draw_elements_instanced(mode, count, type, indices, instancecount);
+	}
+
+	void APIENTRY counted_draw_arrays_indirect(GLenum mode, void const* indirect)
+	{
+		++current_counters.draws;
+		driver.draw_arrays_indirect(mode, indirect);
+	}
+
+	void APIENTRY counted_draw_elements_indirect(GLenum mode, GLenum type, void const* indirect)
+	{
+		++current_counters.draws;
+		driver.draw_elements_indirect(mode, type, indirect);
+	}
+
+	void APIENTRY counted_multi_draw_arrays_indirect(GLenum mode, void const* indirect, GLsizei drawcount, GLsizei stride)
+	{
+		++current_counters.draws;
+		driver.multi_draw_arrays_indirect(mode, indirect, drawcount, stride);
+	}
+
+	void APIENTRY counted_multi_draw_elements_indirect(GLenum mode, GLenum type, void const* indirect, GLsizei drawcount, GLsizei stride)
+	{
+		++current_counters.draws;
+		driver.multi_draw_elements_indirect(mode, type, indirect, drawcount, stride);
+	}
+
+	// Keep the entry point loaded by GLAD in |saved| and replace it by
+	// |wrapper|; entry points the context does not expose are left null.
+	template<typename Entry>
+	void hook(Entry& entry, Entry& saved, Entry wrapper)
+	{
+		if (entry == nullptr)
+			return;
+		saved = entry;
+		entry = wrapper;
+	}
+}
+
+void
+GLStateCache::install()
+{
+	if (installed)
+		return;
+	installed = true;
+
+	hook(glad_glUseProgram, driver.use_program, &cached_use_program);
+	hook(glad_glDeleteProgram, driver.delete_program, &cached_delete_program);
+	hook(glad_glBindVertexArray, driver.bind_vertex_array, &cached_bind_vertex_array);
+	hook(glad_glDeleteVertexArrays, driver.delete_vertex_arrays, &cached_delete_vertex_arrays);
+	hook(glad_glBindBuffer, driver.bind_buffer, &cached_bind_buffer);
+	hook(glad_glBindBufferBase, driver.bind_buffer_base, &cached_bind_buffer_base);
+	hook(glad_glBindBufferRange, driver.bind_buffer_range, &cached_bind_buffer_range);
+	hook(glad_glDeleteBuffers, driver.delete_buffers, &cached_delete_buffers);
+	hook(glad_glActiveTexture, driver.active_texture, &cached_active_texture);
+	hook(glad_glBindTexture, driver.bind_texture, &cached_bind_texture);
+	hook(glad_glDeleteTextures, driver.delete_textures, &cached_delete_textures);
+	hook(glad_glBindSampler, driver.bind_sampler, &cached_bind_sampler);
+	hook(glad_glDeleteSamplers, driver.delete_samplers, &cached_delete_samplers);
+	hook(glad_glEnable, driver.enable, &cached_enable);
+	hook(glad_glDisable, driver.disable, &cached_disable);
+	hook(glad_glBlendFunc, driver.blend_func, &cached_blend_func);
+	hook(glad_glBlendFuncSeparate, driver.blend_func_separate, &cached_blend_func_separate);
+	hook(glad_glDepthFunc, driver.depth_func, &cached_depth_func);
+	hook(glad_glDepthMask, driver.depth_mask, &cached_depth_mask);
+	hook(glad_glCullFace, driver.cull_face, &cached_cull_face);
+	hook(glad_glPolygonMode, driver.polygon_mode, &cached_polygon_mode);
+	hook(glad_glBindFramebuffer, driver.bind_framebuffer, &cached_bind_framebuffer);
+	hook(glad_glDeleteFramebuffers, driver.delete_framebuffers, &cached_delete_framebuffers);
+	hook(glad_glDrawArrays, driver.draw_arrays, &counted_draw_arrays);
+	hook(glad_glDrawElements, driver.draw_elements, &counted_draw_elements);
+	hook(glad_glDrawArraysInstanced, driver.draw_arrays_instanced, &counted_draw_arrays_instanced);
+	hook(glad_glDrawElementsInstanced, driver.draw_elements_instanced, &counted_draw_elements_instanced);
+	hook(glad_glDrawArraysIndirect, driver.draw_arrays_indirect, &counted_draw_arrays_indirect);
+	hook(glad_glDrawElementsIndirect, driver.draw_elements_indirect, &counted_draw_elements_indirect);
+	hook(glad_glMultiDrawArraysIndirect, driver.multi_draw_arrays_indirect, &counted_multi_draw_arrays_indirect);
+	hook(glad_glMultiDrawElementsIndirect, driver.multi_draw_elements_indirect, &counted_multi_draw_elements_indirect);
+}
+
+void
+GLStateCache::invalidate()
+{
+	state = State();
+}
+
+void
+GLStateCache::begin_frame()
+{
+	frame_counters = current_counters;
+	current_counters = Counters();
+	invalidate();
+}
+
+GLStateCache::Counters const&
+GLStateCache::get_frame_counters()
+{
+	return frame_counters;
+}
+
+char const*
+GLStateCache::get_category_name(Category category)
+{
+	switch (category) {
+	case Category::program:        return "Programs";
+	case Category::vertex_array:   return "Vertex arrays";
+	case Category::buffer:         return "Buffers";
+	case Category::texture:        return "Textures";
+	case Category::sampler:        return "Samplers";
+	case Category::fixed_function: return "Fixed-function";
+	case Category::framebuffer:    return "Framebuffers";
+	case Category::count:          break;
+	}
+	return "Unknown";
+}
+
+void
+GLStateCache::toggle_overlay()
+{
+	overlay_visible = !overlay_visible;
+}
+
+void
+GLStateCache::render_overlay()
+{
+	if (!overlay_visible)
+		return;
+
+	bool const opened = ImGui::Begin("OpenGL state", &overlay_visible, ImGuiWindowFlags_AlwaysAutoResize);
+	if (opened) {
+		if (!installed)
+			ImGui::TextUnformatted("The state cache is not installed.");
+
+		std::uint32_t issued = 0u;
+		std::uint32_t skipped = 0u;
+		ImGui::Columns(3, "gl_state_counters");
+		ImGui::TextUnformatted("State calls");
+		ImGui::NextColumn();
+		ImGui::TextUnformatted("Issued");
+		ImGui::NextColumn();
+		ImGui::TextUnformatted("Skipped");
+		ImGui::NextColumn();
+		ImGui::Separator();
+		for (std::size_t i = 0u; i < category_count; ++i) {
+			ImGui::TextUnformatted(get_category_name(static_cast<Category>(i)));
+			ImGui::NextColumn();
+			ImGui::Text("%u", frame_counters.issued[i]);
+			ImGui::NextColumn();
+			ImGui::Text("%u", frame_counters.skipped[i]);
+			ImGui::NextColumn();
+			issued += frame_counters.issued[i];
+			skipped += frame_counters.skipped[i];
+		}
+		ImGui::Separator();
+		ImGui::TextUnformatted("Total");
+		ImGui::NextColumn();
+		ImGui::Text("%u", issued);
+		ImGui::NextColumn();
+		ImGui::Text("%u", skipped);
+		ImGui::NextColumn();
+		ImGui::Columns(1);
+		ImGui::Separator();
+		ImGui::Text("Draw calls: %u", frame_counters.draws);
+		ImGui::Text("State changes per draw: %.1f",
+		            frame_counters.draws > 0u ? static_cast<float>(issued) / static_cast<float>(frame_counters.draws) : 0.0f);
+	}
+	ImGui::End();
+}
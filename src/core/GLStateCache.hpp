@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+
+//! \brief Shadow copy of the OpenGL state, skipping calls that would not
+//!        change it.
+//!
+//! Once installed, the GLAD entry points of the calls below go through
+//! the cache first, so every caller benefits without being rewritten:
+//!  * program and vertex array bindings;
+//!  * generic and indexed buffer bindings (except GL_ELEMENT_ARRAY_BUFFER,
+//!    which belongs to the vertex array), see |glBindBuffer()|,
+//!    |glBindBufferBase()| and |glBindBufferRange()|;
+//!  * the active texture unit, and the textures and samplers of each unit;
+//!  * the enabled capabilities, blend and depth functions, depth mask,
+//!    culled faces and polygon mode;
+//!  * draw and read framebuffers.
+//! A call setting the value already in place is dropped; any other one is
+//! forwarded to the driver, and remembered. Deleting objects forgets the
+//! bindings referring to them, since their names may be reused.
+//!
+//! The cache only sees calls made through GLAD: code using another
+//! loader, like the Dear ImGui back-end, has to call |invalidate()| once
+//! done. The cache is also emptied at the start of every frame.
+//!
+//! Draws and state calls are counted per frame, and can be displayed with
+//! |render_overlay()|.
+class GLStateCache
+{
+public:
+	enum class Category : unsigned int {
+		program = 0u,
+		vertex_array,
+		buffer,
+		texture,
+		sampler,
+		fixed_function,
+		framebuffer,
+		count
+	};
+	static std::size_t const category_count = static_cast<std::size_t>(Category::count);
+
+	struct Counters {
+		std::array<std::uint32_t, category_count> issued{};
+		std::array<std::uint32_t, category_count> skipped{};
+		std::uint32_t draws = 0u;
+	};
+
+	//! \brief Route the GLAD entry points of the current context through
+	//!        the cache; to be called once, right after loading them.
+	static void install();
+
+	//! \brief Forget all cached values, so that the next call of each
+	//!        kind reaches the driver.
+	static void invalidate();
+
+	//! \brief Make the counters of the frame that just ended available
+	//!        through |get_frame_counters()|, and start counting anew.
+	static void begin_frame();
+
+	//! \brief Counters of the last complete frame.
+	static Counters const& get_frame_counters();
+
+	static char const* get_category_name(Category category);
+
+	//! \brief Show or hide the overlay drawn by |render_overlay()|.
+	static void toggle_overlay();
+
+	//! \brief Draw the counters of the last complete frame in a Dear ImGui
+	//!        window, if the overlay is visible.
+	static void render_overlay();
+};
@@ -0,0 +1,242 @@
+#include "GpuPrimitives.hpp"
+
+#include "Log.h"
+#include "ShaderProgramManager.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	// Must match the sizes defined in common/primitives/*.comp.
+	std::uint32_t const work_group_size = 256u;
+	std::uint32_t const block_size = 1024u; // scan and radix sort
+	std::uint32_t const radix_bits = 8u;
+	std::uint32_t const radix = 1u << radix_bits;
+
+	// Operations looping over their elements are dispatched on at most
+	// that many work groups.
+	std::uint32_t const max_loop_work_groups = 4096u;
+
+	std::uint32_t const max_work_groups = 65535u;
+
+	std::uint32_t block_count(std::uint32_t count)
+	{
+		return (count + block_size - 1u) / block_size;
+	}
+
+	std::uint32_t loop_work_group_count(std::uint32_t count)
+	{
+		return std::max(1u, std::min((count + work_group_size - 1u) / work_group_size, max_loop_work_groups));
+	}
+
+	bool check_block_count(char const* operation, std::uint32_t count)
+	{
+		if (block_count(count) <= max_work_groups)
+			return true;
+		LogError("%s: %u elements exceed the %u a single dispatch can cover.", operation, count, max_work_groups * block_size);
+		return false;
+	}
+}
+
+GpuPrimitives::GpuPrimitives(ShaderProgramManager& program_manager)
+{
+	program_manager.CreateAndRegisterComputeProgram("Primitives: scan", "common/primitives/scan.comp", _scan_program);
+	program_manager.CreateAndRegisterComputeProgram("Primitives: radix sort", "common/primitives/radix_sort.comp", _radix_sort_program);
+	program_manager.CreateAndRegisterComputeProgram("Primitives: compaction", "common/primitives/compact.comp", _compact_program);
+	program_manager.CreateAndRegisterComputeProgram("Primitives: segmented reduction", "common/primitives/segmented_reduce.comp", _segmented_reduce_program);
+	program_manager.CreateAndRegisterComputeProgram("Primitives: histogram", "common/primitives/histogram.comp", _histogram_program);
+}
+
+GpuPrimitives::~GpuPrimitives()
+{
+	for (auto& scratch : _scan_block_sums)
+		glDeleteBuffers(1, &scratch.buffer);
+	glDeleteBuffers(1, &_sort_keys.buffer);
+	glDeleteBuffers(1, &_sort_values.buffer);
+	glDeleteBuffers(1, &_sort_digit_offsets.buffer);
+	glDeleteBuffers(1, &_compact_positions.buffer);
+}
+
+bool
+GpuPrimitives::is_valid() const
+{
+	return _scan_program != 0u && _radix_sort_program != 0u && _compact_program != 0u
+	    && _segmented_reduce_program != 0u && _histogram_program != 0u;
+}
+
+GLuint
+GpuPrimitives::reserve(ScratchBuffer& scratch, std::size_t size)
+{
+	if (scratch.buffer == 0u)
+		glGenBuffers(1, &scratch.buffer);
+	if (size > scratch.capacity) {
+		// Grow geometrically, as the sizes used tend to creep up.
+		scratch.capacity = std::max(size, scratch.capacity + scratch.capacity / 2u);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, scratch.buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(scratch.capacity), nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u);
+	}
+	return scratch.buffer;
+}
+
+void
+GpuPrimitives::scan_level(GLuint input, GLuint output, std::uint32_t count, std::size_t level, bool count_non_zero)
+{
+	auto const blocks = block_count(count);
+	if (_scan_block_sums.size() <= level)
+		_scan_block_sums.resize(level + 1u);
+	auto const block_sums = reserve(_scan_block_sums[level], blocks * sizeof(GLuint));
+
+	glUseProgram(_scan_program);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0u, input);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1u, output);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2u, block_sums);
+	glUniform1ui(glGetUniformLocation(_scan_program, "scanPass"), 0u);
+	glUniform1ui(glGetUniformLocation(_scan_program, "elementCount"), count);
+	glUniform1i(glGetUniformLocation(_scan_program, "countNonZero"), count_non_zero ? 1 : 0);
+	glDispatchCompute(blocks, 1u, 1u);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	if (blocks == 1u)
+		return;
+
+	scan_level(block_sums, block_sums, blocks, level + 1u, false);
+
+	glUseProgram(_scan_program);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1u, output);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2u, block_sums);
+	glUniform1ui(glGetUniformLocation(_scan_program, "scanPass"), 1u);
+	glUniform1ui(glGetUniformLocation(_scan_program, "elementCount"), count);
+	glDispatchCompute(blocks, 1u, 1u);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void
+GpuPrimitives::exclusive_scan(GLuint input, GLuint output, std::uint32_t count)
+{
+	if (_scan_program == 0u || count == 0u || !check_block_count("Scan", count))
+		return;
+	scan_level(input, output, count, 0u, false);
+}
+
+void
+GpuPrimitives::radix_sort(GLuint keys, GLuint values, std::uint32_t count, std::uint32_t key_bits)
+{
+	if (_radix_sort_program == 0u || _scan_program == 0u || count <= 1u || !check_block_count("Radix sort", count))
+		return;
+
+	auto const blocks = block_count(count);
+	auto const digit_offsets = reserve(_sort_digit_offsets, std::size_t(radix) * blocks * sizeof(GLuint));
+	GLuint buffers[2][2] = {
+		{ keys, values },
+		{ reserve(_sort_keys, count * sizeof(GLuint)), reserve(_sort_values, count * sizeof(GLuint)) }
+	};
+
+	auto const passes = (std::min(key_bits, 32u) + radix_bits - 1u) / radix_bits;
+	for (std::uint32_t pass = 0u; pass < passes; ++pass) {
+		auto const source = pass % 2u;
+		glUseProgram(_radix_sort_program);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0u, buffers[source][0]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1u, buffers[source][1]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2u, buffers[1u - source][0]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3u, buffers[1u - source][1]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4u, digit_offsets);
+		glUniform1ui(glGetUniformLocation(_radix_sort_program, "sortPass"), 0u);
+		glUniform1ui(glGetUniformLocation(_radix_sort_program, "elementCount"), count);
+		glUniform1ui(glGetUniformLocation(_radix_sort_program, "blockCount"), blocks);
+		glUniform1ui(glGetUniformLocation(_radix_sort_program, "shift"), pass * radix_bits);
+		glDispatchCompute(blocks, 1u, 1u);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		scan_level(digit_offsets, digit_offsets, radix * blocks, 0u, false);
+
+		glUseProgram(_radix_sort_program);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0u, buffers[source][0]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1u, buffers[source][1]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2u, buffers[1u - source][0]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3u, buffers[1u - source][1]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4u, digit_offsets);
+		glUniform1ui(glGetUniformLocation(_radix_sort_program, "sortPass"), 1u);
+		glDispatchCompute(blocks, 1u, 1u);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+
+	// An odd number of passes leaves the result in the scratch buffers.
+	if (passes % 2u == 1u) {
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		for (std::size_t i = 0u; i < 2u; ++i) {
+			glBindBuffer(GL_COPY_READ_BUFFER, buffers[1][i]);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[0][i]);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(count * sizeof(GLuint)));
+		}
+		glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+	}
+}
+
+void
+GpuPrimitives::compact(GLuint input, GLuint flags, GLuint output, GLuint kept_count, std::uint32_t count)
+{
+	if (_compact_program == 0u || _scan_program == 0u || !check_block_count("Compaction", count))
+		return;
+	if (count == 0u) {
+		GLuint const zero = 0u;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, kept_count);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u);
+		return;
+	}
+
+	auto const positions = reserve(_compact_positions, count * sizeof(GLuint));
+	scan_level(flags, positions, count, 0u, true);
+
+	glUseProgram(_compact_program);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0u, input);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1u, flags);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2u, positions);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3u, output);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4u, kept_count);
+	glUniform1ui(glGetUniformLocation(_compact_program, "elementCount"), count);
+	glDispatchCompute(loop_work_group_count(count), 1u, 1u);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void
+GpuPrimitives::segmented_reduce(GLuint values, GLuint segment_offsets, GLuint results,
+                                std::uint32_t segment_count, Reduction reduction)
+{
+	if (_segmented_reduce_program == 0u || segment_count == 0u)
+		return;
+
+	glUseProgram(_segmented_reduce_program);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0u, values);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1u, segment_offsets);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2u, results);
+	glUniform1ui(glGetUniformLocation(_segmented_reduce_program, "segmentCount"), segment_count);
+	glUniform1ui(glGetUniformLocation(_segmented_reduce_program, "operation"), static_cast<GLuint>(reduction));
+	glDispatchCompute(std::min(segment_count, max_work_groups), 1u, 1u);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void
+GpuPrimitives::histogram(GLuint keys, GLuint bins, std::uint32_t count, std::uint32_t bin_count, std::uint32_t key_shift)
+{
+	if (_histogram_program == 0u || bin_count == 0u)
+		return;
+
+	GLuint const zero = 0u;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, bins);
+	glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, static_cast<GLsizeiptr>(bin_count * sizeof(GLuint)),
+	                     GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u);
+	if (count == 0u)
+		return;
+
+	glUseProgram(_histogram_program);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0u, keys);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1u, bins);
+	glUniform1ui(glGetUniformLocation(_histogram_program, "elementCount"), count);
+	glUniform1ui(glGetUniformLocation(_histogram_program, "binCount"), bin_count);
+	glUniform1ui(glGetUniformLocation(_histogram_program, "keyShift"), key_shift);
+	glDispatchCompute(loop_work_group_count(count), 1u, 1u);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ShaderProgramManager;
+
+//! \brief Data-parallel building blocks over shader storage buffers: scan,
+//!        radix sort, stream compaction, segmented reduction and
+//!        histogram.
+//!
+//! Every operation is a sequence of compute dispatches from
+//! `common/primitives/`, recorded without any synchronisation with the
+//! CPU; the results are made visible to later shader storage reads by a
+//! memory barrier, other kinds of accesses needing their own barrier. The
+//! shader storage bindings 0 to 4 and the current program are clobbered.
+//! Buffers hold tightly packed 32-bit elements; element counts are limited
+//! to 65535 * 1024, the number of blocks a single dispatch can cover.
+class GpuPrimitives
+{
+public:
+	enum class Reduction : std::uint32_t {
+		sum = 0u,
+		min = 1u,
+		max = 2u
+	};
+
+	//! \brief The programs are registered with |program_manager|, which
+	//!        must outlive this object.
+	explicit GpuPrimitives(ShaderProgramManager& program_manager);
+	~GpuPrimitives();
+
+	GpuPrimitives(GpuPrimitives const&) = delete;
+	GpuPrimitives& operator=(GpuPrimitives const&) = delete;
+
+	//! \brief Whether every program built.
+	bool is_valid() const;
+
+	//! \brief Exclusive prefix sum of |count| uints; |output| may be
+	//!        |input|.
+	void exclusive_scan(GLuint input, GLuint output, std::uint32_t count);
+
+	//! \brief Stable sort of |count| pairs by increasing key, in place,
+	//!        looking at the |key_bits| lowest bits of the keys only.
+	void radix_sort(GLuint keys, GLuint values, std::uint32_t count, std::uint32_t key_bits = 32u);
+
+	//! \brief Copy, in order, the uints of |input| whose flag is non-zero
+	//!        to |output|, and store their number as a uint at the start
+	//!        of |kept_count|.
+	void compact(GLuint input, GLuint flags, GLuint output, GLuint kept_count, std::uint32_t count);
+
+	//! \brief Reduce the floats of each of the |segment_count| segments of
+	//!        |values|, segment s spanning
+	//!        [segment_offsets[s], segment_offsets[s + 1]), into
+	//!        |results[s]|.
+	void segmented_reduce(GLuint values, GLuint segment_offsets, GLuint results,
+	                      std::uint32_t segment_count, Reduction reduction = Reduction::sum);
+
+	//! \brief Count the uint |keys| falling into each of the |bin_count|
+	//!        bins of |bins|, the bin of a key being key >> |key_shift|;
+	//!        keys past the last bin are ignored. |bins| is cleared first.
+	void histogram(GLuint keys, GLuint bins, std::uint32_t count, std::uint32_t bin_count, std::uint32_t key_shift = 0u);
+
+private:
+	struct ScratchBuffer {
+		GLuint buffer = 0u;
+		std::size_t capacity = 0u;
+	};
+
+	void scan_level(GLuint input, GLuint output, std::uint32_t count, std::size_t level, bool count_non_zero);
+	GLuint reserve(ScratchBuffer& scratch, std::size_t size);
+
+	GLuint _scan_program = 0u;
+	GLuint _radix_sort_program = 0u;
+	GLuint _compact_program = 0u;
+	GLuint _segmented_reduce_program = 0u;
+	GLuint _histogram_program = 0u;
+
+	std::vector<ScratchBuffer> _scan_block_sums; //!< one per level of the scan
+	ScratchBuffer _sort_keys;
+	ScratchBuffer _sort_values;
+	ScratchBuffer _sort_digit_offsets;
+	ScratchBuffer _compact_positions;
+};
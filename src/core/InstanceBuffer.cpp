@@ -0,0 +1,150 @@
+#include "InstanceBuffer.hpp"
+
+#include "helpers.hpp"
+#include "Log.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Floats per column, and columns, of each attribute type.
+	GLint component_count(InstanceBuffer::AttributeType type)
+	{
+		switch (type) {
+		case InstanceBuffer::AttributeType::float1: return 1;
+		case InstanceBuffer::AttributeType::vec2:   return 2;
+		case InstanceBuffer::AttributeType::vec3:   return 3;
+		case InstanceBuffer::AttributeType::vec4:   return 4;
+		case InstanceBuffer::AttributeType::mat4:   return 4;
+		}
+		return 0;
+	}
+
+	GLuint column_count(InstanceBuffer::AttributeType type)
+	{
+		return type == InstanceBuffer::AttributeType::mat4 ? 4u : 1u;
+	}
+
+	GLsizeiptr const stream_alignment = 16;
+}
+
+InstanceBuffer::InstanceBuffer(std::vector<Attribute> const& layout, GLsizei capacity) :
+	_capacity(std::max(capacity, 1))
+{
+	_streams.reserve(layout.size());
+	for (auto const& attribute : layout) {
+		Stream stream;
+		stream.attribute = attribute;
+		stream.stride = static_cast<GLsizeiptr>(component_count(attribute.type) * column_count(attribute.type) * sizeof(GLfloat));
+		stream.offset = 0;
+		stream.count = 0;
+		_streams.push_back(stream);
+	}
+	create_ring();
+}
+
+void
+InstanceBuffer::attach(GLuint vao) const
+{
+	if (vao == 0u)
+		return;
+
+	if (std::find(_vaos.begin(), _vaos.end(), vao) == _vaos.end())
+		_vaos.push_back(vao);
+	for (auto const& stream : _streams)
+		point_stream(stream, vao);
+	glBindVertexArray(0u);
+	glBindBuffer(GL_ARRAY_BUFFER, 0u);
+}
+
+void
+InstanceBuffer::attach(bonobo::mesh_data const& shape) const
+{
+	attach(shape.vao);
+}
+
+void
+InstanceBuffer::update(std::size_t stream, void const* data, GLsizei count)
+{
+	if (stream >= _streams.size()) {
+		LogError("Invalid instance stream %u: only %u streams are declared.",
+		         static_cast<unsigned int>(stream), static_cast<unsigned int>(_streams.size()));
+		return;
+	}
+
+	auto& target = _streams[stream];
+	target.count = std::max(count, 0);
+	if (target.count == 0)
+		return;
+
+	if (target.count > _capacity) {
+		_capacity = std::max(target.count, 2 * _capacity);
+		create_ring();
+		for (auto& other : _streams) {
+			if (&other != &target)
+				other.count = 0;
+		}
+	}
+
+	auto const offset = _ring->write(data, target.count * target.stride, stream_alignment);
+	if (offset < 0) {
+		target.count = 0;
+		return;
+	}
+	target.offset = offset;
+	for (auto const vao : _vaos)
+		point_stream(target, vao);
+	glBindVertexArray(0u);
+	glBindBuffer(GL_ARRAY_BUFFER, 0u);
+}
+
+GLsizei
+InstanceBuffer::get_count() const
+{
+	if (_streams.empty())
+		return 0;
+
+	GLsizei count = _streams.front().count;
+	for (auto const& stream : _streams)
+		count = std::min(count, stream.count);
+	return count;
+}
+
+GLuint
+InstanceBuffer::get_buffer() const
+{
+	return _ring->get_buffer();
+}
+
+void
+InstanceBuffer::create_ring()
+{
+	// Room for every stream at full capacity, plus its alignment.
+	GLsizeiptr region_size = 0;
+	for (auto const& stream : _streams)
+		region_size += _capacity * stream.stride + stream_alignment;
+	_ring = std::make_unique<StreamBuffer>(std::max(region_size, stream_alignment));
+}
+
+void
+InstanceBuffer::point_stream(Stream const& stream, GLuint vao) const
+{
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, _ring->get_buffer());
+	auto const components = component_count(stream.attribute.type);
+	for (GLuint column = 0u; column < column_count(stream.attribute.type); ++column) {
+		auto const location = stream.attribute.location + column;
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(stream.stride),
+		                      reinterpret_cast<GLvoid const*>(stream.offset + column * components * sizeof(GLfloat)));
+		glVertexAttribDivisor(location, 1u);
+	}
+}
+
+void
+InstanceBuffer::report_stride_mismatch(std::size_t stream, std::size_t stride) const
+{
+	LogError("Values of %u bytes do not match the %u-byte attribute of instance stream %u.",
+	         static_cast<unsigned int>(stride), static_cast<unsigned int>(_streams[stream].stride),
+	         static_cast<unsigned int>(stream));
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "StreamBuffer.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace bonobo
+{
+	struct mesh_data;
+}
+
+//! \brief Per-instance vertex data, fed to instanced draws.
+//!
+//! The data is split in streams, one per attribute of the layout given at
+//! construction, each of which can be updated on its own. Attaching the
+//! buffer to a vertex array points the attributes of the layout at those
+//! streams with a divisor of 1; a `mat4` attribute takes four consecutive
+//! locations, one per column.
+//!
+//! Every update is appended to a |StreamBuffer|, so it never waits for
+//! draws reading the previous content; the attributes of the attached
+//! vertex arrays are pointed at the new content as part of the update, so
+//! vertex arrays only have to be attached once. The capacity grows as
+//! needed, which drops the content of the other streams: those have to be
+//! updated again before drawing.
+//!
+//! Instances are drawn with |Node::render_instanced()|.
+class InstanceBuffer
+{
+public:
+	enum class AttributeType : unsigned int {
+		float1 = 0u,
+		vec2,
+		vec3,
+		vec4,
+		mat4
+	};
+
+	struct Attribute {
+		GLuint location;
+		AttributeType type;
+	};
+
+	//! \brief Create one stream per attribute of |layout|, with room for
+	//!        |capacity| instances per frame.
+	explicit InstanceBuffer(std::vector<Attribute> const& layout, GLsizei capacity = 64);
+	InstanceBuffer(InstanceBuffer const&) = delete;
+	InstanceBuffer& operator=(InstanceBuffer const&) = delete;
+
+	//! \brief Point the attributes of the layout at the streams of this
+	//!        buffer, in |vao|, and keep doing so after each update.
+	//!
+	//! Any attribute previously set at those locations is replaced. The
+	//! vertex array should outlive this buffer.
+	void attach(GLuint vao) const;
+	void attach(bonobo::mesh_data const& shape) const;
+
+	//! \brief Replace the content of |stream| by |count| values read from
+	//!        |data|, laid out as the attribute of that stream.
+	void update(std::size_t stream, void const* data, GLsizei count);
+
+	template<typename T>
+	void update(std::size_t stream, std::vector<T> const& values)
+	{
+		if (stream < _streams.size() && static_cast<GLsizeiptr>(sizeof(T)) != _streams[stream].stride) {
+			report_stride_mismatch(stream, sizeof(T));
+			return;
+		}
+		update(stream, values.data(), static_cast<GLsizei>(values.size()));
+	}
+
+	//! \brief Number of instances that can be drawn, i.e. the smallest
+	//!        count among the streams.
+	GLsizei get_count() const;
+
+	GLuint get_buffer() const;
+
+private:
+	struct Stream {
+		Attribute attribute;
+		GLsizeiptr stride;
+		GLintptr offset;
+		GLsizei count;
+	};
+
+	void create_ring();
+	void point_stream(Stream const& stream, GLuint vao) const;
+	void report_stride_mismatch(std::size_t stream, std::size_t stride) const;
+
+	std::vector<Stream> _streams;
+	GLsizei _capacity;
+	std::unique_ptr<StreamBuffer> _ring;
+	mutable std::vector<GLuint> _vaos;
+};
@@ -1,8 +1,9 @@
 #include "config.hpp"
 #include "Log.h"
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <cstdio>
-#include <sstream>
 #include <string>
 #include <iostream>
 #include <thread>
@@ -21,12 +22,16 @@ void (* textout_func)(Type, const char *) = nullptr;
 std::unordered_map<size_t, size_t> once_map;
 size_t output_targets = LOG_OUT_STD | LOG_OUT_CUSTOM | LOG_OUT_FILE;
 std::mutex fileMutex;
-char log_result_string[RESULT_MAX_STRING_LENGTH];
+// Formatted message, then the same with its location and prefix; written
+// in place rather than through a stream, so that reporting does not
+// allocate, and per thread, since any thread may report.
+thread_local char log_result_string[RESULT_MAX_STRING_LENGTH];
+thread_local char log_output_string[RESULT_MAX_STRING_LENGTH + 1024];
 bool logIncludeThreadID = false;
 
 struct LogSettings {
 	Type type;
-	std::string prefix;
+	const char *prefix;
 	Verbosity verbosity;
 	Severity severity;
 };
@@ -45,6 +50,35 @@ LogSettings logSettings[] = {
 
 /*----------------------------------------------------------------------------*/
 
+static void Append(size_t &length, const char *str, ...)
+{
+	if (length >= sizeof(log_output_string) - 1)
+		return;
+	va_list args;
+	va_start(args, str);
+	int written = vsnprintf(&log_output_string[length], sizeof(log_output_string) - length, str, args);
+	va_end(args);
+	if (written > 0)
+		length = std::min(length + size_t(written), sizeof(log_output_string) - 1);
+}
+
+static uint64_t Hash(uint64_t hash, const char *str)
+{
+	// FNV-1a
+	for (; *str != '\0'; ++str)
+		hash = (hash ^ uint64_t(static_cast<unsigned char>(*str))) * 1099511628211ull;
+	return hash;
+}
+
+static uint64_t Hash(uint64_t hash, int value)
+{
+	char digits[16];
+	snprintf(digits, sizeof(digits), "%d", value);
+	return Hash(hash, digits);
+}
+
+/*----------------------------------------------------------------------------*/
+
 void Init()
 {
 	SetOutputTargets(output_targets);
@@ -141,13 +175,12 @@ void Report(
 		strcat(&log_result_string[RESULT_MAX_STRING_LENGTH - 5], "...");
 
 	if (flags != 0) {
-		std::ostringstream os;
+		uint64_t key = 14695981039346656037ull;
 		if ((flags & LOG_MESSAGE_ONCE_FLAG) != 0)
-			os << file << function << std::to_string(line) << log_result_string;
+			key = Hash(Hash(Hash(Hash(key, file), function), line), log_result_string);
 		if ((type & LOG_LOCATION_ONCE_FLAG) != 0)
-			os << "_Loc" << file << function << std::to_string(line);
-		std::hash<std::string> hash_func;
-		size_t hash = hash_func(os.str());
+			key = Hash(Hash(Hash(Hash(key, "_Loc"), file), function), line);
+		size_t hash = size_t(key);
 		auto elem = once_map.find(hash);
 		if (elem != once_map.end()) {
 			elem->second++; // Count the number of hits
@@ -156,35 +189,36 @@ void Report(
 		once_map[hash] = 1;
 	}
 
-	std::ostringstream os;
+	size_t length = 0;
+	log_output_string[0] = '\0';
 	if (logIncludeThreadID) {
 		std::thread::id tid = std::this_thread::get_id();
-		os << "{" << tid << "} ";
+		Append(length, "{%zu} ", std::hash<std::thread::id>()(tid));
 	}
 	if (logSettings[t].verbosity == LOUD) {
 		if (line == -1)
-			os << "[Unknown location]" << std::endl;
+			Append(length, "[Unknown location]\n");
 		else
-			os << "[" << file << ", " << function << " (" << std::to_string(line) << ")]" << std::endl;
+			Append(length, "[%s, %s (%d)]\n", file, function, line);
 	}
-	os << logSettings[t].prefix << log_result_string << std::endl;
+	Append(length, "%s%s\n", logSettings[t].prefix, log_result_string);
 
 	if (output_targets & LOG_OUT_STD) {
 #if defined(_WIN32)
-		auto const widened_string = utils::widen(os.str());
+		auto const widened_string = utils::widen(log_output_string);
 		fwprintf(logSettings[t].severity != Severity::OK ? stderr : stdout, L"%s", widened_string.c_str());
 #else
-		fprintf(logSettings[t].severity != Severity::OK ? stderr : stdout, "%s", os.str().c_str());
+		fprintf(logSettings[t].severity != Severity::OK ? stderr : stdout, "%s", log_output_string);
 #endif
 	}
 	if (output_targets & LOG_OUT_FILE) {
 		fileMutex.lock();
-		fprintf(logfile, "%s", os.str().c_str());
+		fprintf(logfile, "%s", log_output_string);
 		fflush(logfile);
 		fileMutex.unlock();
 	}
 	if (output_targets & LOG_OUT_CUSTOM && textout_func != nullptr)
-		textout_func(type, os.str().c_str());
+		textout_func(type, log_output_string);
 #ifdef _WIN32
 	if (logSettings[t].severity != Severity::OK && IsDebuggerPresent())
   		__debugbreak();
@@ -0,0 +1,227 @@
+#include "RenderQueue.hpp"
+
+#include "node.hpp"
+#include "SceneTransforms.hpp"
+#include "ShaderProgramManager.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <array>
+#include <utility>
+
+namespace
+{
+	// FNV-1a over raw bytes; only used to bring equal materials next to
+	// each other, so collisions merely cost a few extra state changes.
+	std::uint32_t hash_bytes(void const* data, std::size_t size, std::uint32_t hash)
+	{
+		auto const bytes = static_cast<unsigned char const*>(data);
+		for (std::size_t i = 0u; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+}
+
+void
+RenderQueue::submit(Node const& node, glm::mat4 const& parent_transform)
+{
+	record(node, parent_transform);
+}
+
+void
+RenderQueue::submit_hierarchy(Node const& node, glm::mat4 const& parent_transform)
+{
+	auto const world = record(node, parent_transform);
+	for (auto const child : node._children)
+		submit_hierarchy(*child, world);
+}
+
+void
+RenderQueue::submit(SceneTransforms const& scene)
+{
+	for (auto const& entry : scene.get_entries())
+		record(*entry.node, entry.world, entry.normal);
+}
+
+glm::mat4 const&
+RenderQueue::record(Node const& node, glm::mat4 const& parent_transform)
+{
+	// Both go through the caches of the node, so unchanged nodes do not
+	// compute them again.
+	auto const& world = node.world_transform(parent_transform);
+	record(node, world, node.normal_transform(world));
+	return _world_transforms.back();
+}
+
+void
+RenderQueue::record(Node const& node, glm::mat4 const& world, glm::mat4 const& normal)
+{
+	_world_transforms.push_back(world);
+	_normal_transforms.push_back(normal);
+
+	GLuint const program = node._program != nullptr ? *node._program : 0u;
+	if (node._vao != 0u && program != 0u) {
+		std::uint32_t material_hash = 2166136261u;
+		for (auto const& texture : node._textures) {
+			auto const texture_id = std::get<1>(texture);
+			material_hash = hash_bytes(&texture_id, sizeof(texture_id), material_hash);
+		}
+		auto const& constants = node._constants;
+		material_hash = hash_bytes(glm::value_ptr(constants.diffuse), sizeof(constants.diffuse), material_hash);
+		material_hash = hash_bytes(glm::value_ptr(constants.specular), sizeof(constants.specular), material_hash);
+		material_hash = hash_bytes(glm::value_ptr(constants.ambient), sizeof(constants.ambient), material_hash);
+		material_hash = hash_bytes(glm::value_ptr(constants.emissive), sizeof(constants.emissive), material_hash);
+		material_hash = hash_bytes(&constants.shininess, sizeof(constants.shininess), material_hash);
+		material_hash = hash_bytes(&constants.indexOfRefraction, sizeof(constants.indexOfRefraction), material_hash);
+		material_hash = hash_bytes(&constants.opacity, sizeof(constants.opacity), material_hash);
+
+		// program | material | vertex array, 16 bits each, and 16 zero
+		// bits: the sort is stable, so equal keys keep their submission
+		// order.
+		DrawPacket packet;
+		packet.key = (static_cast<std::uint64_t>(program & 0xFFFFu) << 48)
+		           | (static_cast<std::uint64_t>((material_hash ^ (material_hash >> 16)) & 0xFFFFu) << 32)
+		           | (static_cast<std::uint64_t>(node._vao & 0xFFFFu) << 16);
+		packet.node = &node;
+		packet.transform_index = static_cast<std::uint32_t>(_world_transforms.size() - 1u);
+		_packets.push_back(packet);
+	}
+}
+
+void
+RenderQueue::flush(glm::mat4 const& view_projection)
+{
+	_stats = Stats();
+	sort_packets();
+
+	auto const& names = Node::builtin_uniforms();
+	GLuint current_program = 0u;
+	GLuint current_vao = 0u;
+	ShaderProgramManager::UniformLocations locations;
+	Node const* material_node = nullptr;
+	GLenum active_unit = GL_TEXTURE0;
+	bool active_unit_known = false;
+	std::vector<std::pair<GLenum, GLuint>> bound_textures;
+
+	// The `has_` flags of a material are cleared before switching to
+	// another one or to another program, so that a program never sees the
+	// flags of a previous draw, as with Node::render().
+	auto const clear_texture_flags = [&locations, &material_node]() {
+		if (material_node == nullptr)
+			return;
+		for (auto const& texture_uniforms : material_node->_texture_uniforms)
+			glUniform1i(locations.Location(texture_uniforms.second), 0);
+	};
+
+	for (auto const& packet : _packets) {
+		auto const& node = *packet.node;
+
+		GLuint const program = *node._program;
+		if (program != current_program) {
+			clear_texture_flags();
+			glUseProgram(program);
+			current_program = program;
+			locations = ShaderProgramManager::GetUniformLocations(program);
+			material_node = nullptr;
+			auto const world_to_clip_location = locations.Location(names.vertex_world_to_clip);
+			if (world_to_clip_location >= 0)
+				glUniformMatrix4fv(world_to_clip_location, 1, GL_FALSE, glm::value_ptr(view_projection));
+			++_stats.program_binds;
+		}
+
+		node._set_uniforms(program);
+
+		bool const same_material = material_node != nullptr
+		                        && material_node->_textures == node._textures
+		                        && material_node->_texture_uniforms == node._texture_uniforms
+		                        && material_node->_constants == node._constants;
+		if (!same_material) {
+			clear_texture_flags();
+			if (bound_textures.size() < node._textures.size())
+				bound_textures.resize(node._textures.size(), std::make_pair(GLenum(0), 0u));
+			for (std::size_t i = 0u; i < node._textures.size(); ++i) {
+				auto const& texture = node._textures[i];
+				auto const binding = std::make_pair(std::get<2>(texture), std::get<1>(texture));
+				if (bound_textures[i] != binding) {
+					auto const unit = GL_TEXTURE0 + static_cast<GLenum>(i);
+					if (!active_unit_known || active_unit != unit) {
+						glActiveTexture(unit);
+						active_unit = unit;
+						active_unit_known = true;
+					}
+					glBindTexture(binding.first, binding.second);
+					bound_textures[i] = binding;
+					++_stats.texture_binds;
+				}
+				glUniform1i(locations.Location(node._texture_uniforms[i].first), static_cast<GLint>(i));
+				glUniform1i(locations.Location(node._texture_uniforms[i].second), 1);
+			}
+
+			node.set_material_uniforms(locations);
+			material_node = &node;
+			++_stats.material_changes;
+		}
+
+		auto const& world = _world_transforms[packet.transform_index];
+		auto const& normal_model_to_world = _normal_transforms[packet.transform_index];
+		glUniformMatrix4fv(locations.Location(names.vertex_model_to_world), 1, GL_FALSE, glm::value_ptr(world));
+		glUniformMatrix4fv(locations.Location(names.normal_model_to_world), 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
+
+		if (node._vao != current_vao) {
+			glBindVertexArray(node._vao);
+			current_vao = node._vao;
+			++_stats.vertex_array_binds;
+		}
+		if (node._has_indices)
+			glDrawElements(node._drawing_mode, node._indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
+		else
+			glDrawArrays(node._drawing_mode, 0, node._vertices_nb);
+		++_stats.draws;
+	}
+
+	clear_texture_flags();
+	if (current_vao != 0u)
+		glBindVertexArray(0u);
+	if (current_program != 0u)
+		glUseProgram(0u);
+
+	_packets.clear();
+	_world_transforms.clear();
+	_normal_transforms.clear();
+}
+
+RenderQueue::Stats const&
+RenderQueue::get_stats() const
+{
+	return _stats;
+}
+
+void
+RenderQueue::sort_packets()
+{
+	// LSD radix sort over the 8 bytes of the keys, skipping the bytes
+	// shared by all packets; each pass is stable.
+	std::array<std::array<std::size_t, 256>, 8> counts{};
+	for (auto const& packet : _packets)
+		for (std::size_t byte = 0u; byte < 8u; ++byte)
+			++counts[byte][(packet.key >> (8u * byte)) & 0xFFu];
+
+	_sort_scratch.resize(_packets.size());
+	for (std::size_t byte = 0u; byte < 8u; ++byte) {
+		auto& byte_counts = counts[byte];
+		if (_packets.empty() || byte_counts[(_packets.front().key >> (8u * byte)) & 0xFFu] == _packets.size())
+			continue;
+
+		std::size_t offset = 0u;
+		for (auto& count : byte_counts) {
+			auto const digit_count = count;
+			count = offset;
+			offset += digit_count;
+		}
+		for (auto const& packet : _packets)
+			_sort_scratch[byte_counts[(packet.key >> (8u * byte)) & 0xFFu]++] = packet;
+		_packets.swap(_sort_scratch);
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class Node;
+class SceneTransforms;
+
+//! \brief Deferred submission of nodes, sorted to minimise state changes.
+//!
+//! Traversing the scene graph only records a compact draw packet per node
+//! (its world matrix goes to a separate array). On |flush()|, the packets
+//! are radix-sorted by a 64-bit key made of the program, the material and
+//! the vertex array of the node, then drawn in that order: programs,
+//! vertex arrays, textures and material uniforms (or material buffers,
+//! see |Node::render()|) are only set when they differ from the previous
+//! packet's, and nothing is unbound in between.
+//! The |set_uniforms| callback of each node still runs before its draw,
+//! but should leave the material uniforms set by the node alone, as those
+//! are only sent again when the material changes.
+//!
+//! Packets are drawn with the state of the context at the time of the
+//! flush, so draws needing a specific state (e.g. a skybox without depth
+//! testing) should go through their own queue or |Node::render()|.
+class RenderQueue
+{
+public:
+	//! \brief GL work done by the last |flush()|.
+	struct Stats {
+		std::uint32_t draws = 0u;
+		std::uint32_t program_binds = 0u;
+		std::uint32_t vertex_array_binds = 0u;
+		std::uint32_t texture_binds = 0u;
+		std::uint32_t material_changes = 0u;
+	};
+
+	//! \brief Record |node|, placed in world space by |parent_transform|
+	//!        followed by its own transform, as in |Node::render()|.
+	void submit(Node const& node, glm::mat4 const& parent_transform = glm::mat4(1.0f));
+
+	//! \brief Record |node| and all of its descendants, each child being
+	//!        placed relative to its parent.
+	void submit_hierarchy(Node const& node, glm::mat4 const& parent_transform = glm::mat4(1.0f));
+
+	//! \brief Record every node of |scene|, with the matrices computed by
+	//!        its last |SceneTransforms::update()|.
+	void submit(SceneTransforms const& scene);
+
+	//! \brief Draw all recorded packets, then empty the queue.
+	//!
+	//! The current program and vertex array are reset to 0 on return; the
+	//! textures bound by the packets are left bound.
+	void flush(glm::mat4 const& view_projection);
+
+	Stats const& get_stats() const;
+
+private:
+	struct DrawPacket {
+		std::uint64_t key;
+		Node const* node;
+		std::uint32_t transform_index;
+	};
+
+	glm::mat4 const& record(Node const& node, glm::mat4 const& parent_transform);
+	void record(Node const& node, glm::mat4 const& world, glm::mat4 const& normal);
+	void sort_packets();
+
+	std::vector<DrawPacket> _packets;
+	std::vector<DrawPacket> _sort_scratch;
+	std::vector<glm::mat4> _world_transforms;
+	std::vector<glm::mat4> _normal_transforms;
+	Stats _stats;
+};
@@ -0,0 +1,225 @@
+#include "ResourceManager.hpp"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <unordered_map>
+
+namespace
+{
+	struct Registry {
+		std::unordered_map<std::string, std::weak_ptr<void const>> entries;
+		std::array<ResourceManager::Stats, ResourceManager::kind_count> stats;
+	};
+
+	Registry& registry()
+	{
+		static Registry resource_registry;
+		return resource_registry;
+	}
+
+	ResourceManager::Stats& stats_of(ResourceManager::Kind kind)
+	{
+		return registry().stats[static_cast<std::size_t>(kind)];
+	}
+
+	bool is_valid(bonobo::mesh_data const& mesh)          { return mesh.vao != 0u; }
+	bool is_valid(std::vector<bonobo::mesh_data> const& m) { return !m.empty(); }
+	bool is_valid(GLuint name)                            { return name != 0u; }
+
+	std::size_t buffer_size(GLuint buffer)
+	{
+		if (buffer == 0u)
+			return 0u;
+
+		GLint size = 0;
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+		return static_cast<std::size_t>(std::max(size, 0));
+	}
+
+	std::size_t mesh_bytes(bonobo::mesh_data const& mesh)
+	{
+		return buffer_size(mesh.bo) + buffer_size(mesh.ibo);
+	}
+
+	// Textures are loaded as RGBA8; a full mipmap chain adds a third.
+	std::size_t texture_bytes(GLuint texture, bool has_mipmap)
+	{
+		GLint width = 0, height = 0;
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		glBindTexture(GL_TEXTURE_2D, 0u);
+		auto const level0 = static_cast<std::size_t>(std::max(width, 0)) * static_cast<std::size_t>(std::max(height, 0)) * 4u;
+		return has_mipmap ? level0 * 4u / 3u : level0;
+	}
+
+	std::size_t program_bytes(GLuint program)
+	{
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		return static_cast<std::size_t>(std::max(length, 0));
+	}
+
+	void delete_mesh(bonobo::mesh_data const& mesh)
+	{
+		glDeleteVertexArrays(1, &mesh.vao);
+		GLuint const buffers[] = { mesh.bo, mesh.ibo };
+		glDeleteBuffers(2, buffers);
+	}
+
+	// Several meshes of a file may use the same textures, see
+	// |bonobo::loadObjects()|: delete each one only once.
+	void delete_objects(std::vector<bonobo::mesh_data> const& objects)
+	{
+		std::set<GLuint> textures;
+		for (auto const& mesh : objects) {
+			delete_mesh(mesh);
+			for (auto const& binding : mesh.bindings)
+				textures.insert(binding.second);
+		}
+		for (auto const texture : textures)
+			glDeleteTextures(1, &texture);
+	}
+
+	// Return the live resource stored under |key|, or create one with
+	// |create| and cache it; |measure| estimates its size, |release|
+	// deletes its OpenGL objects once the last handle is gone.
+	template<typename T, typename Create, typename Measure, typename Release>
+	std::shared_ptr<T const> acquire(ResourceManager::Kind kind, std::string const& key,
+	                                 Create const& create, Measure const& measure, Release const& release)
+	{
+		auto& entries = registry().entries;
+		auto& stats = stats_of(kind);
+
+		auto const it = entries.find(key);
+		if (it != entries.end()) {
+			if (auto resource = it->second.lock()) {
+				++stats.shared;
+				return std::static_pointer_cast<T const>(resource);
+			}
+		}
+
+		auto resource = std::unique_ptr<T>(new T(create()));
+		if (!is_valid(*resource))
+			return nullptr;
+
+		auto const bytes = measure(*resource);
+		++stats.live;
+		++stats.created;
+		stats.bytes += bytes;
+
+		std::shared_ptr<T const> const handle(resource.release(), [kind, key, bytes, release](T const* value){
+			release(*value);
+			delete value;
+
+			auto& stats = stats_of(kind);
+			--stats.live;
+			stats.bytes -= bytes;
+
+			// Only forget the entry if it still refers to this resource.
+			auto& entries = registry().entries;
+			auto const it = entries.find(key);
+			if (it != entries.end() && it->second.expired())
+				entries.erase(it);
+		});
+		entries[key] = handle;
+		return handle;
+	}
+}
+
+ResourceManager::MeshHandle
+ResourceManager::get_mesh(std::string const& key, std::function<bonobo::mesh_data()> const& create)
+{
+	return acquire<bonobo::mesh_data>(Kind::mesh, "mesh:" + key, create, mesh_bytes, delete_mesh);
+}
+
+ResourceManager::ObjectsHandle
+ResourceManager::get_objects(std::string const& filename)
+{
+	auto const path = canonical_path(filename);
+	return acquire<std::vector<bonobo::mesh_data>>(Kind::mesh, "objects:" + path,
+	                                               [&path](){ return bonobo::loadObjects(path); },
+	                                               [](std::vector<bonobo::mesh_data> const& objects){
+	                                                   std::size_t bytes = 0u;
+	                                                   for (auto const& mesh : objects)
+	                                                       bytes += mesh_bytes(mesh);
+	                                                   return bytes;
+	                                               },
+	                                               delete_objects);
+}
+
+ResourceManager::TextureHandle
+ResourceManager::get_texture_2d(std::string const& filename, bool generate_mipmap)
+{
+	auto const path = canonical_path(filename);
+	return acquire<GLuint>(Kind::texture, (generate_mipmap ? "texture2d+mipmap:" : "texture2d:") + path,
+	                       [&path, generate_mipmap](){ return bonobo::loadTexture2D(path, generate_mipmap); },
+	                       [generate_mipmap](GLuint texture){ return texture_bytes(texture, generate_mipmap); },
+	                       [](GLuint texture){ glDeleteTextures(1, &texture); });
+}
+
+ResourceManager::ProgramHandle
+ResourceManager::get_program(std::string const& vert_shader_source_path,
+                             std::string const& frag_shader_source_path)
+{
+	return acquire<GLuint>(Kind::program, "program:" + vert_shader_source_path + "|" + frag_shader_source_path,
+	                       [&](){ return bonobo::createProgram(vert_shader_source_path, frag_shader_source_path); },
+	                       program_bytes,
+	                       [](GLuint program){ glDeleteProgram(program); });
+}
+
+ResourceManager::Stats const&
+ResourceManager::get_stats(Kind kind)
+{
+	return stats_of(kind);
+}
+
+char const*
+ResourceManager::get_kind_name(Kind kind)
+{
+	switch (kind) {
+	case Kind::mesh:    return "meshes";
+	case Kind::texture: return "textures";
+	case Kind::program: return "programs";
+	case Kind::count:   break;
+	}
+	return "unknown";
+}
+
+void
+ResourceManager::log_stats()
+{
+	for (std::size_t i = 0u; i < kind_count; ++i) {
+		auto const kind = static_cast<Kind>(i);
+		auto const& stats = get_stats(kind);
+		LogInfo("%s: %u live (%.2f MiB), %u created, %u requests shared",
+		        get_kind_name(kind), static_cast<unsigned int>(stats.live),
+		        static_cast<double>(stats.bytes) / (1024.0 * 1024.0),
+		        static_cast<unsigned int>(stats.created), static_cast<unsigned int>(stats.shared));
+	}
+}
+
+std::string
+ResourceManager::canonical_path(std::string const& path)
+{
+	std::string canonical;
+#if defined(_WIN32)
+	char resolved[_MAX_PATH];
+	if (_fullpath(resolved, path.c_str(), _MAX_PATH) != nullptr)
+		canonical = resolved;
+#else
+	if (char* const resolved = realpath(path.c_str(), nullptr)) {
+		canonical = resolved;
+		std::free(resolved);
+	}
+#endif
+	if (canonical.empty())
+		canonical = path;
+	std::replace(canonical.begin(), canonical.end(), '\\', '/');
+	return canonical;
+}
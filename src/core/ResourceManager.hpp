@@ -0,0 +1,100 @@
+#pragma once
+
+#include "helpers.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//! \brief Cache of GPU resources, handing out the same object to every
+//!        request with the same key.
+//!
+//! Resources are returned as reference-counted handles: copying a handle
+//! is cheap and shares the resource, and the OpenGL objects behind it are
+//! deleted when the last handle goes away. A later request with the same
+//! key then creates the resource anew. Keys are:
+//!  * for meshes, the generator and its parameters, see |make_key()|;
+//!  * for textures and loaded objects, the canonical path of the file;
+//!  * for programs, the paths of their shaders.
+//!
+//! Failing to create a resource returns an empty handle, and nothing is
+//! cached, so that the next request tries again.
+//!
+//! The cache never owns a resource by itself: resources that are still
+//! in use when the OpenGL context is destroyed have to be released by
+//! their owners beforehand.
+class ResourceManager
+{
+public:
+	using MeshHandle = std::shared_ptr<bonobo::mesh_data const>;
+	using ObjectsHandle = std::shared_ptr<std::vector<bonobo::mesh_data> const>;
+	using TextureHandle = std::shared_ptr<GLuint const>;
+	using ProgramHandle = std::shared_ptr<GLuint const>;
+
+	enum class Kind : unsigned int {
+		mesh = 0u,
+		texture,
+		program,
+		count
+	};
+	static std::size_t const kind_count = static_cast<std::size_t>(Kind::count);
+
+	struct Stats {
+		std::size_t live = 0u;    //!< resources currently alive
+		std::size_t bytes = 0u;   //!< GPU memory used by them, estimated
+		std::size_t created = 0u; //!< resources created so far
+		std::size_t shared = 0u;  //!< requests served from the cache
+	};
+
+	//! \brief Mesh built by |create|, or the one built for an earlier
+	//!        request with the same |key|; the vertex array and buffers
+	//!        of the mesh are deleted with its last handle.
+	static MeshHandle get_mesh(std::string const& key, std::function<bonobo::mesh_data()> const& create);
+
+	//! \brief Meshes of |filename|, as loaded by |bonobo::loadObjects()|;
+	//!        their textures are deleted with the last handle as well.
+	static ObjectsHandle get_objects(std::string const& filename);
+
+	//! \brief Texture loaded by |bonobo::loadTexture2D()|, dereferencing
+	//!        to its OpenGL name.
+	static TextureHandle get_texture_2d(std::string const& filename, bool generate_mipmap = true);
+
+	//! \brief Program created by |bonobo::createProgram()|, dereferencing
+	//!        to its OpenGL name.
+	static ProgramHandle get_program(std::string const& vert_shader_source_path,
+	                                 std::string const& frag_shader_source_path);
+
+	static Stats const& get_stats(Kind kind);
+	static char const* get_kind_name(Kind kind);
+
+	//! \brief Log the statistics of every kind of resource.
+	static void log_stats();
+
+	//! \brief Key made of |generator| followed by all |parameters|,
+	//!        written with enough digits to tell any two apart.
+	//!
+	//! e.g. `make_key("sphere", 0.5f, 5u, 5u)`
+	template<typename... Parameters>
+	static std::string make_key(std::string const& generator, Parameters const&... parameters)
+	{
+		std::ostringstream key;
+		key.precision(std::numeric_limits<double>::max_digits10);
+		key << generator;
+		// Expand the parameters in order, each preceded by a separator.
+		int const expansion[] = { 0, ((key << '|' << parameters), 0)... };
+		static_cast<void>(expansion);
+		return key.str();
+	}
+
+	//! \brief Absolute form of |path|, with symbolic links and `.`/`..`
+	//!        components resolved, and forward slashes only; |path| as is
+	//!        if it does not exist.
+	static std::string canonical_path(std::string const& path);
+};
@@ -0,0 +1,83 @@
+#include "SceneTransforms.hpp"
+
+#include "node.hpp"
+
+SceneTransforms::SceneTransforms(Node const& root, glm::mat4 const& parent_transform) :
+	_root(root), _parent_transform(parent_transform)
+{
+	rebuild();
+}
+
+void
+SceneTransforms::set_parent_transform(glm::mat4 const& parent_transform)
+{
+	if (parent_transform == _parent_transform)
+		return;
+
+	_parent_transform = parent_transform;
+	_parent_transform_changed = true;
+}
+
+std::size_t
+SceneTransforms::update()
+{
+	for (std::size_t i = 0u; i < _entries.size(); ++i) {
+		if (_entries[i].node->get_children_nb() != _children_nbs[i]) {
+			rebuild();
+			break;
+		}
+	}
+
+	std::size_t recomputed_nb = 0u;
+	for (std::size_t i = 0u; i < _entries.size(); ++i) {
+		auto& entry = _entries[i];
+		auto const& transform = entry.node->get_transform();
+		bool const parent_changed = entry.parent == no_parent ? _parent_transform_changed
+		                                                      : _recomputed[entry.parent];
+		_recomputed[i] = parent_changed || transform.GetVersion() != _versions[i];
+		if (!_recomputed[i])
+			continue;
+
+		auto const& parent_world = entry.parent == no_parent ? _parent_transform
+		                                                     : _entries[entry.parent].world;
+		entry.world = parent_world * transform.GetMatrix();
+		entry.normal = glm::transpose(glm::inverse(entry.world));
+		_versions[i] = transform.GetVersion();
+		++recomputed_nb;
+	}
+	_parent_transform_changed = false;
+
+	return recomputed_nb;
+}
+
+std::vector<SceneTransforms::Entry> const&
+SceneTransforms::get_entries() const
+{
+	return _entries;
+}
+
+void
+SceneTransforms::rebuild()
+{
+	_entries.clear();
+	_children_nbs.clear();
+
+	// Depth-first, so that every parent precedes its children.
+	std::vector<Entry> pending{ Entry{ &_root, no_parent, glm::mat4(1.0f), glm::mat4(1.0f) } };
+	while (!pending.empty()) {
+		auto const entry = pending.back();
+		pending.pop_back();
+
+		auto const index = static_cast<std::uint32_t>(_entries.size());
+		auto const children_nb = entry.node->get_children_nb();
+		_entries.push_back(entry);
+		_children_nbs.push_back(children_nb);
+		for (std::size_t i = children_nb; i > 0u; --i)
+			pending.push_back(Entry{ entry.node->get_child(i - 1u), index, glm::mat4(1.0f), glm::mat4(1.0f) });
+	}
+
+	// Versions are never 0, so every entry gets computed by the next
+	// update.
+	_versions.assign(_entries.size(), 0u);
+	_recomputed.assign(_entries.size(), false);
+}
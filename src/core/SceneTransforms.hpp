@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Node;
+
+//! \brief World and normal matrices of every node of a scene graph.
+//!
+//! The hierarchy below a root node is flattened into an array where
+//! parents come before their children. |update()| walks that array once
+//! and only recomputes the matrices of the nodes whose transform changed
+//! since the previous update, and of their descendants: nodes of
+//! unchanged subtrees cost a version comparison.
+//!
+//! The array is rebuilt when the number of children of a node changes;
+//! the nodes themselves must outlive this object.
+class SceneTransforms
+{
+public:
+	static std::uint32_t const no_parent = ~0u;
+
+	struct Entry {
+		Node const* node;
+		//! index of the parent entry, or |no_parent| for the root
+		std::uint32_t parent;
+		glm::mat4 world;
+		glm::mat4 normal;
+	};
+
+	//! @param [in] root Node at the top of the hierarchy
+	//! @param [in] parent_transform Matrix placing |root| in world-space
+	explicit SceneTransforms(Node const& root,
+	                         glm::mat4 const& parent_transform = glm::mat4(1.0f));
+
+	void set_parent_transform(glm::mat4 const& parent_transform);
+
+	//! \brief Bring the matrices up to date.
+	//!
+	//! @return how many entries were recomputed
+	std::size_t update();
+
+	//! \brief Entries in parent-before-child order, as of the last
+	//!        |update()|.
+	std::vector<Entry> const& get_entries() const;
+
+private:
+	void rebuild();
+
+	Node const& _root;
+	glm::mat4 _parent_transform;
+	bool _parent_transform_changed = true;
+	std::vector<Entry> _entries;
+	//! per entry, the transform version and children count the entry
+	//! was computed from
+	std::vector<std::uint64_t> _versions;
+	std::vector<std::size_t> _children_nbs;
+	//! per entry, whether it was recomputed by the current update
+	std::vector<bool> _recomputed;
+};
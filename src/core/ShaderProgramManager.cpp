@@ -8,12 +8,173 @@
 
 #include <imgui.h>
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <set>
 #include <type_traits>
+#include <unordered_map>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#if defined(__linux__)
+#	include <sys/inotify.h>
+#	include <unistd.h>
+#endif
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#	define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace
+{
+	struct ProgramInterface {
+		std::vector<GLint> locations;
+		std::vector<GLuint> block_indices;
+	};
+
+	struct UniformRegistry {
+		std::unordered_map<std::string, ShaderProgramManager::UniformName> name_ids;
+		std::vector<std::string> names;
+		std::unordered_map<GLuint, ProgramInterface> programs;
+		std::vector<std::pair<ShaderProgramManager::UniformName, GLuint>> block_bindings;
+	};
+
+	UniformRegistry& registry()
+	{
+		static UniformRegistry uniform_registry;
+		return uniform_registry;
+	}
+
+	template<typename T>
+	void store(std::vector<T>& table, ShaderProgramManager::UniformName const name, T const value, T const missing)
+	{
+		if (table.size() <= name)
+			table.resize(name + 1u, missing);
+		table[name] = value;
+	}
+
+	// Modification time and size of a file, to notice it changed when
+	// polling; both are -1 if the file cannot be accessed.
+	struct FileStamp {
+		std::int64_t modification_time = -1;
+		std::int64_t size = -1;
+
+		bool operator==(FileStamp const& other) const
+		{
+			return modification_time == other.modification_time && size == other.size;
+		}
+	};
+
+	FileStamp stamp_file(std::string const& path)
+	{
+		FileStamp stamp;
+#if defined(_WIN32)
+		struct _stat64 info;
+		if (_stat64(path.c_str(), &info) != 0)
+			return stamp;
+#else
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0)
+			return stamp;
+#endif
+		stamp.modification_time = static_cast<std::int64_t>(info.st_mtime);
+		stamp.size = static_cast<std::int64_t>(info.st_size);
+		return stamp;
+	}
+
+	std::string parent_directory(std::string const& path)
+	{
+		auto const separator = path.find_last_of("/\\");
+		return separator == std::string::npos ? std::string(".") : path.substr(0u, separator);
+	}
+
+	// GL_KHR_parallel_shader_compile and its ARB counterpart are not part
+	// of the GLAD loader, hence the entry point is fetched by hand.
+	typedef void (APIENTRYP PFNMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+	bool enable_parallel_shader_compile()
+	{
+		if (!glfwExtensionSupported("GL_KHR_parallel_shader_compile") && !glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+			return false;
+
+		auto max_shader_compiler_threads = reinterpret_cast<PFNMAXSHADERCOMPILERTHREADSPROC>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+		if (max_shader_compiler_threads == nullptr)
+			max_shader_compiler_threads = reinterpret_cast<PFNMAXSHADERCOMPILERTHREADSPROC>(glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+		// Let the driver pick how many threads to use.
+		if (max_shader_compiler_threads != nullptr)
+			max_shader_compiler_threads(0xFFFFFFFFu);
+		return true;
+	}
+
+	void log_info_log(GLuint object, bool is_program, std::string const& name)
+	{
+		GLint log_length = 0;
+		if (is_program)
+			glGetProgramiv(object, GL_INFO_LOG_LENGTH, &log_length);
+		else
+			glGetShaderiv(object, GL_INFO_LOG_LENGTH, &log_length);
+		if (log_length <= 0)
+			return;
+
+		std::vector<GLchar> log(static_cast<std::size_t>(log_length), '\0');
+		if (is_program)
+			glGetProgramInfoLog(object, log_length, nullptr, log.data());
+		else
+			glGetShaderInfoLog(object, log_length, nullptr, log.data());
+		LogError("%s log of '%s':\n%s", is_program ? "Linking" : "Compilation", name.c_str(), log.data());
+	}
+
+	auto const poll_interval = std::chrono::milliseconds(250);
+
+	// Arrays are reported as their first element, `name[0]`; they can
+	// be looked up by their bare name as well.
+	std::string array_base_name(std::string const& name)
+	{
+		auto const suffix_length = sizeof("[0]") - 1u;
+		if (name.size() > suffix_length && name.compare(name.size() - suffix_length, suffix_length, "[0]") == 0)
+			return name.substr(0u, name.size() - suffix_length);
+		return std::string();
+	}
+}
+
+struct ShaderProgramManager::HotReload {
+	struct WatchedFile {
+		std::vector<std::size_t> programs;
+		FileStamp stamp;
+	};
+	struct Rebuild {
+		std::size_t program_index;
+		GLuint program;
+		std::vector<std::pair<GLuint, std::string>> shaders;
+	};
+
+	std::unordered_map<std::string, WatchedFile> files;
+	std::vector<Rebuild> rebuilds;
+	bool is_parallel_compile_enabled = false;
+	std::chrono::steady_clock::time_point next_poll;
+#if defined(__linux__)
+	int inotify = -1;
+	std::unordered_map<int, std::string> directories;
+#endif
+};
+
+ShaderProgramManager::ShaderProgramManager() = default;
 
 ShaderProgramManager::~ShaderProgramManager()
 {
+	if (hot_reload) {
+		while (!hot_reload->rebuilds.empty())
+			DiscardRebuild(hot_reload->rebuilds.front().program_index);
+#if defined(__linux__)
+		if (hot_reload->inotify >= 0)
+			close(hot_reload->inotify);
+#endif
+	}
+
 	for (auto const& i : program_entries) {
 		if (i.first != 0u) {
+			ForgetProgram(i.first);
 			glDeleteProgram(i.first);
 			i.first = 0u;
 		}
@@ -21,6 +182,11 @@ ShaderProgramManager::~ShaderProgramManager()
 }
 
 void ShaderProgramManager::CreateAndRegisterProgram(char const* const program_name, ProgramData const& program_data, GLuint& program)
+{
+	CreateAndRegisterProgram(program_name, program_data, ShaderDefines{}, program);
+}
+
+void ShaderProgramManager::CreateAndRegisterProgram(char const* const program_name, ProgramData const& program_data, ShaderDefines const& defines, GLuint& program)
 {
 	if (!GLAD_GL_ARB_compute_shader) {
 		for (auto const& i : program_data) {
@@ -33,11 +199,18 @@ void ShaderProgramManager::CreateAndRegisterProgram(char const* const program_na
 
 	program_entries.emplace_back(program, program_data);
 	program_names.emplace_back(program_name);
+	program_defines.emplace_back(defines);
 
 	ProcessProgram(program_entries.size() - 1);
+	WatchProgram(program_entries.size() - 1);
 }
 
 void ShaderProgramManager::CreateAndRegisterComputeProgram(char const* const program_name, std::string const& filename, GLuint& program)
+{
+	CreateAndRegisterComputeProgram(program_name, filename, ShaderDefines{}, program);
+}
+
+void ShaderProgramManager::CreateAndRegisterComputeProgram(char const* const program_name, std::string const& filename, ShaderDefines const& defines, GLuint& program)
 {
 	if (!GLAD_GL_ARB_compute_shader) {
 		LogError("Compute shaders aren't exposed on your computer (needed for shader '%s'.", filename.c_str());
@@ -46,25 +219,78 @@ void ShaderProgramManager::CreateAndRegisterComputeProgram(char const* const pro
 
 	program_entries.emplace_back(program, ProgramData{ { ShaderType::compute, filename } });
 	program_names.emplace_back(program_name);
+	program_defines.emplace_back(defines);
 
 	ProcessProgram(program_entries.size() - 1);
+	WatchProgram(program_entries.size() - 1);
 }
 
 bool ShaderProgramManager::ReloadAllPrograms()
 {
 	bool encountered_failures = false;
 	for (std::size_t i = 0; i < program_entries.size(); ++i) {
-		auto& program = program_entries[i].first;
-		if (program != 0u)
-			glDeleteProgram(program);
-		program = 0u;
-		ProcessProgram(i);
-		encountered_failures |= program == 0u;
+		DiscardRebuild(i);
+		encountered_failures |= !ProcessProgram(i);
 	}
 
 	return !encountered_failures;
 }
 
+bool ShaderProgramManager::PollHotReload()
+{
+	if (!hot_reload)
+		return false;
+
+	// Rebuilds started by the previous calls are checked first, so that
+	// the driver gets at least a frame to complete the new ones.
+	bool const were_programs_replaced = FinishRebuilds();
+
+	std::set<std::size_t> modified_programs;
+	auto const mark_modified = [this, &modified_programs](std::string const& path){
+		auto const file = hot_reload->files.find(path);
+		if (file != hot_reload->files.end())
+			modified_programs.insert(file->second.programs.begin(), file->second.programs.end());
+	};
+
+#if defined(__linux__)
+	if (hot_reload->inotify >= 0) {
+		alignas(inotify_event) char buffer[4096];
+		for (;;) {
+			auto const length = read(hot_reload->inotify, buffer, sizeof(buffer));
+			if (length <= 0)
+				break;
+			for (char const* event_start = buffer; event_start < buffer + length;) {
+				auto const event = reinterpret_cast<inotify_event const*>(event_start);
+				auto const directory = hot_reload->directories.find(event->wd);
+				if (event->len > 0u && directory != hot_reload->directories.end())
+					mark_modified(directory->second + "/" + event->name);
+				event_start += sizeof(inotify_event) + event->len;
+			}
+		}
+	}
+	else
+#endif
+	{
+		auto const now = std::chrono::steady_clock::now();
+		if (now >= hot_reload->next_poll) {
+			hot_reload->next_poll = now + poll_interval;
+			for (auto& file : hot_reload->files) {
+				auto const stamp = stamp_file(file.first);
+				// Files being replaced may briefly be missing.
+				if (stamp.size < 0 || stamp == file.second.stamp)
+					continue;
+				file.second.stamp = stamp;
+				mark_modified(file.first);
+			}
+		}
+	}
+
+	for (auto const program_index : modified_programs)
+		StartRebuild(program_index);
+
+	return were_programs_replaced;
+}
+
 ShaderProgramManager::SelectedProgram ShaderProgramManager::SelectProgram(std::string const& label, std::int32_t& program_index)
 {
 	SelectedProgram selection_result;
@@ -79,36 +305,307 @@ ShaderProgramManager::SelectedProgram ShaderProgramManager::SelectProgram(std::s
 	return selection_result;
 }
 
-void ShaderProgramManager::ProcessProgram(std::size_t const program_index)
+bool ShaderProgramManager::ProcessProgram(std::size_t const program_index)
 {
-	auto& program_entry = program_entries[program_index];
-	auto& program = program_entry.first;
-	auto const& program_data = program_entry.second;
+	auto const& program_data = program_entries[program_index].second;
 
 	std::vector<GLuint> shaders;
 	shaders.reserve(program_data.size());
 
 	for (auto const& i : program_data) {
 		std::string const full_filename = config::shaders_path(i.second);
-		auto const shader_source = utils::slurp_file(full_filename);
-		if (shader_source.empty()) {
+		auto const file_source = utils::slurp_file(full_filename);
+		if (file_source.empty()) {
+			for (auto& shader : shaders)
+				glDeleteShader(shader);
 			LogError("Retrieval of shader '%s' failed; see previous message for details.", full_filename.c_str());
-			return;
+			return false;
 		}
+		auto const shader_source = utils::opengl::shader::insert_defines(file_source, program_defines[program_index]);
 
 		GLuint shader = utils::opengl::shader::generate_shader(static_cast<std::underlying_type<ShaderType>::type>(i.first), shader_source);
 		if (shader == 0u) {
 			for (auto& shader : shaders)
 				glDeleteShader(shader);
 			LogError("Compilation of shader '%s' failed; see previous message for details.", full_filename.c_str());
-			return;
+			return false;
 		}
 		shaders.push_back(shader);
 	}
 
-	program = utils::opengl::shader::generate_program(shaders);
-	utils::opengl::debug::nameObject(GL_PROGRAM, program, program_names[program_index]);
-
+	auto const program = utils::opengl::shader::generate_program(shaders);
 	for (auto& shader : shaders)
 		glDeleteShader(shader);
+	if (program == 0u)
+		return false;
+
+	ReplaceProgram(program_index, program);
+	return true;
+}
+
+void ShaderProgramManager::ReplaceProgram(std::size_t const program_index, GLuint const program)
+{
+	utils::opengl::debug::nameObject(GL_PROGRAM, program, program_names[program_index]);
+	BindUniformBlocks(program);
+	ReflectProgram(program);
+
+	auto& current_program = program_entries[program_index].first;
+	if (current_program != 0u) {
+		ForgetProgram(current_program);
+		glDeleteProgram(current_program);
+	}
+	current_program = program;
+}
+
+void ShaderProgramManager::WatchProgram(std::size_t const program_index)
+{
+	if (!hot_reload) {
+		hot_reload = std::make_unique<HotReload>();
+		hot_reload->is_parallel_compile_enabled = enable_parallel_shader_compile();
+		hot_reload->next_poll = std::chrono::steady_clock::now() + poll_interval;
+#if defined(__linux__)
+		hot_reload->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (hot_reload->inotify < 0)
+			LogWarning("Watching shader files with inotify failed: falling back to polling them.");
+#endif
+	}
+
+	for (auto const& i : program_entries[program_index].second) {
+		auto const full_filename = config::shaders_path(i.second);
+		auto& file = hot_reload->files[full_filename];
+		if (std::find(file.programs.begin(), file.programs.end(), program_index) != file.programs.end())
+			continue;
+		if (file.programs.empty())
+			file.stamp = stamp_file(full_filename);
+		file.programs.push_back(program_index);
+
+#if defined(__linux__)
+		if (hot_reload->inotify < 0)
+			continue;
+		// Editors often save by writing a new file and renaming it over
+		// the old one, which a watch on the file itself would miss.
+		auto const directory = parent_directory(full_filename);
+		auto const watch = inotify_add_watch(hot_reload->inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (watch >= 0)
+			hot_reload->directories[watch] = directory;
+		else
+			LogWarning("Watching shader directory '%s' failed.", directory.c_str());
+#endif
+	}
+}
+
+void ShaderProgramManager::StartRebuild(std::size_t const program_index)
+{
+	// A rebuild already under way uses outdated sources.
+	DiscardRebuild(program_index);
+
+	HotReload::Rebuild rebuild;
+	rebuild.program_index = program_index;
+	rebuild.program = 0u;
+	for (auto const& i : program_entries[program_index].second) {
+		std::string const full_filename = config::shaders_path(i.second);
+		auto const file_source = utils::slurp_file(full_filename);
+		if (file_source.empty()) {
+			for (auto const& shader : rebuild.shaders)
+				glDeleteShader(shader.first);
+			LogError("Retrieval of shader '%s' failed; keeping the current version of program '%s'.",
+			         full_filename.c_str(), program_names[program_index]);
+			return;
+		}
+		auto const shader_source = utils::opengl::shader::insert_defines(file_source, program_defines[program_index]);
+
+		// Statuses are only queried once the program completes, so that
+		// the driver is free to compile in the background meanwhile.
+		GLuint const shader = glCreateShader(static_cast<std::underlying_type<ShaderType>::type>(i.first));
+		GLchar const* source = shader_source.c_str();
+		glShaderSource(shader, 1, &source, nullptr);
+		glCompileShader(shader);
+		rebuild.shaders.emplace_back(shader, full_filename);
+	}
+
+	rebuild.program = glCreateProgram();
+	for (auto const& shader : rebuild.shaders)
+		glAttachShader(rebuild.program, shader.first);
+	glLinkProgram(rebuild.program);
+
+	LogInfo("Rebuilding program '%s'.", program_names[program_index]);
+	hot_reload->rebuilds.push_back(std::move(rebuild));
+}
+
+bool ShaderProgramManager::FinishRebuilds()
+{
+	bool were_programs_replaced = false;
+	auto& rebuilds = hot_reload->rebuilds;
+	for (auto rebuild = rebuilds.begin(); rebuild != rebuilds.end();) {
+		if (hot_reload->is_parallel_compile_enabled) {
+			GLint is_complete = GL_FALSE;
+			glGetProgramiv(rebuild->program, GL_COMPLETION_STATUS_KHR, &is_complete);
+			if (is_complete == GL_FALSE) {
+				++rebuild;
+				continue;
+			}
+		}
+
+		GLint is_linked = GL_FALSE;
+		glGetProgramiv(rebuild->program, GL_LINK_STATUS, &is_linked);
+		auto const program_name = program_names[rebuild->program_index];
+		for (auto const& shader : rebuild->shaders) {
+			GLint is_compiled = GL_FALSE;
+			glGetShaderiv(shader.first, GL_COMPILE_STATUS, &is_compiled);
+			if (is_compiled == GL_FALSE)
+				log_info_log(shader.first, false, shader.second);
+			glDeleteShader(shader.first);
+		}
+
+		if (is_linked != GL_FALSE) {
+			ReplaceProgram(rebuild->program_index, rebuild->program);
+			LogInfo("Program '%s' reloaded.", program_name);
+			were_programs_replaced = true;
+		}
+		else {
+			log_info_log(rebuild->program, true, program_name);
+			glDeleteProgram(rebuild->program);
+			LogError("Rebuilding program '%s' failed; keeping its current version.", program_name);
+		}
+		rebuild = rebuilds.erase(rebuild);
+	}
+
+	return were_programs_replaced;
+}
+
+void ShaderProgramManager::DiscardRebuild(std::size_t const program_index)
+{
+	if (!hot_reload)
+		return;
+
+	auto& rebuilds = hot_reload->rebuilds;
+	auto const rebuild = std::find_if(rebuilds.begin(), rebuilds.end(),
+	                                  [program_index](HotReload::Rebuild const& rebuild){
+	                                      return rebuild.program_index == program_index;
+	                                  });
+	if (rebuild == rebuilds.end())
+		return;
+
+	for (auto const& shader : rebuild->shaders)
+		glDeleteShader(shader.first);
+	glDeleteProgram(rebuild->program);
+	rebuilds.erase(rebuild);
+}
+
+ShaderProgramManager::UniformName ShaderProgramManager::InternUniformName(std::string const& name)
+{
+	auto& uniform_registry = registry();
+	auto const it = uniform_registry.name_ids.find(name);
+	if (it != uniform_registry.name_ids.end())
+		return it->second;
+
+	auto const id = static_cast<UniformName>(uniform_registry.names.size());
+	uniform_registry.names.push_back(name);
+	uniform_registry.name_ids.emplace(name, id);
+	return id;
+}
+
+std::string const& ShaderProgramManager::GetUniformName(UniformName const name)
+{
+	return registry().names.at(name);
+}
+
+ShaderProgramManager::UniformLocations ShaderProgramManager::GetUniformLocations(GLuint const program)
+{
+	UniformLocations uniform_locations;
+	uniform_locations.program = program;
+
+	auto& programs = registry().programs;
+	auto const it = programs.find(program);
+	if (it != programs.end()) {
+		uniform_locations.locations = &it->second.locations;
+		uniform_locations.block_indices = &it->second.block_indices;
+	}
+	return uniform_locations;
+}
+
+void ShaderProgramManager::RegisterUniformBlockBinding(std::string const& block_name, GLuint const binding)
+{
+	auto const name = InternUniformName(block_name);
+	auto& block_bindings = registry().block_bindings;
+	auto const it = std::find_if(block_bindings.begin(), block_bindings.end(),
+	                             [name](std::pair<UniformName, GLuint> const& block_binding){
+	                                 return block_binding.first == name;
+	                             });
+	if (it != block_bindings.end())
+		it->second = binding;
+	else
+		block_bindings.emplace_back(name, binding);
+}
+
+GLint ShaderProgramManager::UniformLocations::Location(UniformName const name) const
+{
+	if (locations == nullptr)
+		return glGetUniformLocation(program, GetUniformName(name).c_str());
+	return name < locations->size() ? (*locations)[name] : -1;
+}
+
+GLuint ShaderProgramManager::UniformLocations::BlockIndex(UniformName const name) const
+{
+	if (block_indices == nullptr)
+		return glGetUniformBlockIndex(program, GetUniformName(name).c_str());
+	return name < block_indices->size() ? (*block_indices)[name] : GL_INVALID_INDEX;
+}
+
+void ShaderProgramManager::BindUniformBlocks(GLuint const program)
+{
+	if (program == 0u)
+		return;
+
+	for (auto const& block_binding : registry().block_bindings) {
+		auto const block_index = glGetUniformBlockIndex(program, GetUniformName(block_binding.first).c_str());
+		if (block_index != GL_INVALID_INDEX)
+			glUniformBlockBinding(program, block_index, block_binding.second);
+	}
+}
+
+void ShaderProgramManager::ReflectProgram(GLuint const program)
+{
+	// Without program interface queries, lookups keep going through
+	// glGetUniformLocation().
+	if (program == 0u || !GLAD_GL_VERSION_4_3)
+		return;
+
+	ProgramInterface program_interface;
+	auto const for_each_resource = [program](GLenum const resource_type, std::function<void (GLuint, std::string const&)> const& visit) {
+		GLint resource_count = 0, max_name_length = 0;
+		glGetProgramInterfaceiv(program, resource_type, GL_ACTIVE_RESOURCES, &resource_count);
+		glGetProgramInterfaceiv(program, resource_type, GL_MAX_NAME_LENGTH, &max_name_length);
+		std::vector<GLchar> name(static_cast<std::size_t>(std::max(max_name_length, 1)), '\0');
+		for (GLint i = 0; i < resource_count; ++i) {
+			glGetProgramResourceName(program, resource_type, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), nullptr, name.data());
+			visit(static_cast<GLuint>(i), std::string(name.data()));
+		}
+	};
+
+	for_each_resource(GL_UNIFORM, [program, &program_interface](GLuint const index, std::string const& name) {
+		GLenum const property = GL_LOCATION;
+		GLint location = -1;
+		glGetProgramResourceiv(program, GL_UNIFORM, index, 1, &property, 1, nullptr, &location);
+		// Members of uniform blocks have no location.
+		if (location < 0)
+			return;
+		store(program_interface.locations, InternUniformName(name), location, -1);
+		auto const base_name = array_base_name(name);
+		if (!base_name.empty())
+			store(program_interface.locations, InternUniformName(base_name), location, -1);
+	});
+	for_each_resource(GL_UNIFORM_BLOCK, [&program_interface](GLuint const index, std::string const& name) {
+		store<GLuint>(program_interface.block_indices, InternUniformName(name), index, GL_INVALID_INDEX);
+		auto const base_name = array_base_name(name);
+		if (!base_name.empty())
+			store<GLuint>(program_interface.block_indices, InternUniformName(base_name), index, GL_INVALID_INDEX);
+	});
+
+	registry().programs[program] = std::move(program_interface);
+}
+
+void ShaderProgramManager::ForgetProgram(GLuint const program)
+{
+	registry().programs.erase(program);
 }
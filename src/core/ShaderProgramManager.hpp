@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 
 #include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -23,20 +24,96 @@ class ShaderProgramManager
 {
 public:
 	using ProgramData = std::map<ShaderType, std::string>;
+	//! \brief `#define` name/value pairs inserted after the `#version`
+	//!        line of every shader of a program, kept across reloads.
+	using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
 	struct SelectedProgram {
 		bool was_selection_changed = false;
 		GLuint const* program = nullptr;
 		char const* name = nullptr;
 	};
+	//! \brief Uniform or uniform block name interned by
+	//!        |InternUniformName()|, shared by all programs.
+	using UniformName = std::uint32_t;
+	//! \brief Locations of the uniforms of one program, indexed by
+	//!        interned name.
+	//!
+	//! Registered programs are reflected once per link, so looking up a
+	//! location is an array access; other programs fall back to
+	//! glGetUniformLocation(). Only valid until the program is reloaded.
+	class UniformLocations {
+	public:
+		//! \brief Location of the uniform |name|, -1 if it is not active.
+		GLint Location(UniformName name) const;
+		//! \brief Index of the uniform block |name|, GL_INVALID_INDEX if
+		//!        it is not active.
+		GLuint BlockIndex(UniformName name) const;
+
+	private:
+		friend class ShaderProgramManager;
+		GLuint program = 0u;
+		std::vector<GLint> const* locations = nullptr;
+		std::vector<GLuint> const* block_indices = nullptr;
+	};
+	ShaderProgramManager();
 	~ShaderProgramManager();
 	void CreateAndRegisterProgram(char const* const program_name, ProgramData const& program_data, GLuint& program);
+	void CreateAndRegisterProgram(char const* const program_name, ProgramData const& program_data, ShaderDefines const& defines, GLuint& program);
 	void CreateAndRegisterComputeProgram(char const* const program_name, std::string const& filename, GLuint& program);
+	void CreateAndRegisterComputeProgram(char const* const program_name, std::string const& filename, ShaderDefines const& defines, GLuint& program);
+	//! \brief Rebuild every registered program right away.
+	//!
+	//! Programs failing to build keep their previous version.
+	//!
+	//! @return whether all programs were rebuilt successfully
 	bool ReloadAllPrograms();
+	//! \brief Rebuild the programs using shader files modified since the
+	//!        previous call, without stalling the frame.
+	//!
+	//! Modifications are detected with inotify on Linux, and by polling
+	//! the modification times of the files elsewhere; only the programs
+	//! using a modified file are rebuilt. Their compilation is started by
+	//! one call and checked by the following ones: with the
+	//! GL_KHR_parallel_shader_compile extension, the driver compiles on
+	//! its own threads and checking never waits. A program is replaced
+	//! once its new version links successfully, and is kept otherwise.
+	//!
+	//! To be called once per frame.
+	//!
+	//! @return whether any program was replaced, in which case uniform
+	//!         locations looked up beforehand are outdated
+	bool PollHotReload();
 	SelectedProgram SelectProgram(std::string const& label, std::int32_t& program_index);
 
+	//! \brief Return the identifier of |name|, the same for every call
+	//!        with an equal string.
+	static UniformName InternUniformName(std::string const& name);
+	static std::string const& GetUniformName(UniformName name);
+	//! \brief Return the location table of |program|.
+	static UniformLocations GetUniformLocations(GLuint program);
+	//! \brief Bind the uniform block |block_name| to the binding point
+	//!        |binding| in every program linked from now on, including
+	//!        reloaded ones.
+	//!
+	//! GLSL 4.10 has no `binding` layout qualifier, hence blocks shared
+	//! across programs get their binding point from here; register them
+	//! before creating the programs using them.
+	static void RegisterUniformBlockBinding(std::string const& block_name, GLuint binding);
+
 private:
-	void ProcessProgram(std::size_t program_index);
+	struct HotReload;
+	bool ProcessProgram(std::size_t program_index);
+	void ReplaceProgram(std::size_t program_index, GLuint program);
+	void WatchProgram(std::size_t program_index);
+	void StartRebuild(std::size_t program_index);
+	bool FinishRebuilds();
+	void DiscardRebuild(std::size_t program_index);
+	static void BindUniformBlocks(GLuint program);
+	static void ReflectProgram(GLuint program);
+	static void ForgetProgram(GLuint program);
 	using ProgramEntry = std::pair<GLuint&, ProgramData>;
 	std::vector<ProgramEntry> program_entries;
 	std::vector<char const*> program_names;
+	std::vector<ShaderDefines> program_defines;
+	std::unique_ptr<HotReload> hot_reload;
 };
@@ -0,0 +1,144 @@
+#include "StreamBuffer.hpp"
+
+#include "Log.h"
+
+#include <cstring>
+
+namespace
+{
+	GLuint64 const fence_timeout_ns = 1000000000u;
+}
+
+StreamBuffer::StreamBuffer(GLsizeiptr region_size) : _region_size(region_size)
+{
+	auto const total_size = _region_size * static_cast<GLsizeiptr>(region_count);
+
+	glGenBuffers(1, &_buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+	if (GLAD_GL_VERSION_4_4) {
+		GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, total_size, nullptr, flags);
+		_mapping = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total_size, flags));
+		if (_mapping == nullptr)
+			LogError("Persistently mapping a %d-byte stream buffer failed.", static_cast<int>(total_size));
+	}
+	else {
+		glBufferData(GL_COPY_WRITE_BUFFER, total_size, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for (auto& fence : _fences) {
+		if (fence != nullptr)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+	if (_mapping != nullptr) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+		_mapping = nullptr;
+	}
+	glDeleteBuffers(1, &_buffer);
+	_buffer = 0u;
+}
+
+void
+StreamBuffer::begin_frame()
+{
+	if (_head == 0)
+		return;
+
+	if (_fences[_region] != nullptr)
+		glDeleteSync(_fences[_region]);
+	_fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0u);
+
+	_region = (_region + 1u) % region_count;
+	_head = 0;
+	wait(_region);
+}
+
+GLintptr
+StreamBuffer::write(void const* data, GLsizeiptr size, GLsizeiptr alignment)
+{
+	if (size > _region_size) {
+		LogError("Writing %d bytes to a stream buffer with %d-byte regions.",
+		         static_cast<int>(size), static_cast<int>(_region_size));
+		return -1;
+	}
+
+	auto offset = (_head + alignment - 1) / alignment * alignment;
+	if (offset + size > _region_size) {
+		begin_frame();
+		offset = 0;
+	}
+	_head = offset + size;
+
+	offset += static_cast<GLintptr>(_region) * _region_size;
+	if (_mapping != nullptr) {
+		std::memcpy(_mapping + offset, data, static_cast<std::size_t>(size));
+	}
+	else {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+		auto const destination = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size,
+		                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (destination != nullptr) {
+			std::memcpy(destination, data, static_cast<std::size_t>(size));
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+	}
+	return offset;
+}
+
+GLuint
+StreamBuffer::get_buffer() const
+{
+	return _buffer;
+}
+
+GLsizeiptr
+StreamBuffer::get_region_size() const
+{
+	return _region_size;
+}
+
+bool
+StreamBuffer::is_persistent() const
+{
+	return _mapping != nullptr;
+}
+
+GLsizeiptr
+StreamBuffer::uniform_alignment()
+{
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	return alignment > 0 ? static_cast<GLsizeiptr>(alignment) : 256;
+}
+
+void
+StreamBuffer::wait(GLuint region)
+{
+	auto& fence = _fences[region];
+	if (fence == nullptr)
+		return;
+
+	// The first wait flushes the commands, so that the fence is bound to
+	// be signalled; later ones only keep waiting.
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	for (;;) {
+		auto const status = glClientWaitSync(fence, flags, fence_timeout_ns);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+			break;
+		if (status == GL_WAIT_FAILED) {
+			LogError("Waiting on a stream buffer region failed.");
+			break;
+		}
+		flags = 0u;
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
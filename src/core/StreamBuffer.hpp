@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+
+//! \brief Ring buffer for data written by the CPU every frame.
+//!
+//! The storage is split in |region_count| regions of equal size. Writes
+//! are appended to the current region; once it is full, or when
+//! |begin_frame()| is called, a fence is inserted after the commands
+//! issued so far and writing moves on to the next region, waiting first
+//! for the fence inserted when that region was last left. As long as
+//! the GPU is less than |region_count| - 1 regions behind, writing never
+//! waits on it, nor does the driver have to copy or rename the storage.
+//!
+//! When buffer storage is available (OpenGL 4.4), the buffer is mapped
+//! once, persistently and coherently, and writes are plain copies to
+//! that mapping. Otherwise each write maps its range unsynchronised,
+//! which the fences make safe as well.
+//!
+//! The name of the buffer never changes, but the offset of each write
+//! does, so whatever reads the data has to be pointed at the offset
+//! returned by |write()| every time, e.g. with |glBindBufferRange()|.
+class StreamBuffer
+{
+public:
+	static GLuint const region_count = 3u;
+
+	//! \brief Create the buffer, made of |region_count| regions of
+	//!        |region_size| bytes.
+	explicit StreamBuffer(GLsizeiptr region_size);
+	~StreamBuffer();
+	StreamBuffer(StreamBuffer const&) = delete;
+	StreamBuffer& operator=(StreamBuffer const&) = delete;
+
+	//! \brief Move on to the next region, leaving the rest of the current
+	//!        one unused.
+	//!
+	//! Calling it once per frame, before the first write, keeps each
+	//! frame in its own region, so that writing only waits on the GPU
+	//! when it is more than |region_count| - 1 frames behind.
+	void begin_frame();
+
+	//! \brief Copy |size| bytes from |data| to the current region, at an
+	//!        offset multiple of |alignment|.
+	//!
+	//! @return the offset of the copy within the buffer, or -1 if |size|
+	//!         exceeds the size of a region
+	GLintptr write(void const* data, GLsizeiptr size, GLsizeiptr alignment = 16);
+
+	GLuint get_buffer() const;
+	GLsizeiptr get_region_size() const;
+	bool is_persistent() const;
+
+	//! \brief Alignment required for the offsets given to
+	//!        |glBindBufferRange(GL_UNIFORM_BUFFER, ...)|.
+	static GLsizeiptr uniform_alignment();
+
+private:
+	void wait(GLuint region);
+
+	GLuint _buffer = 0u;
+	GLsizeiptr _region_size = 0;
+	unsigned char* _mapping = nullptr;
+	std::array<GLsync, region_count> _fences{};
+	GLuint _region = 0u;
+	GLsizeiptr _head = 0;
+};
@@ -4,6 +4,7 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/io.hpp>
 
+#include <cstdint>
 #include <iostream>
 
 /**
@@ -87,8 +88,16 @@ public:
 	// Useful getters
 	///////////////////////////////////////////////////////////////////////////
 
-	glm::tmat4x4<T, P> GetMatrix() const;
-	glm::tmat4x4<T, P> GetMatrixInverse() const;
+	// The composed matrix and its inverse are cached, and only computed
+	// again after the transform changes.
+	glm::tmat4x4<T, P> const& GetMatrix() const;
+	glm::tmat4x4<T, P> const& GetMatrixInverse() const;
+
+	// Changes with every change to the transform, and is only shared by
+	// transforms holding the same values (e.g. copies): values derived
+	// from a transform can be cached alongside the version they were
+	// computed from.
+	std::uint64_t GetVersion() const;
 
 	glm::tmat3x3<T, P> GetRotation() const;
 	glm::tvec3<T, P> GetTranslation() const;
@@ -112,10 +121,20 @@ public:
 	glm::tvec3<T, P> GetBack() const;
 
 protected:
+	// Must be called after any change to mR, mT or mS.
+	void Invalidate();
+	static std::uint64_t NextVersion();
+
 	glm::tmat3x3<T, P>	mR;
 	glm::tvec3<T, P>	mT;
 	glm::tvec3<T, P>	mS;
 
+	mutable glm::tmat4x4<T, P>	mMatrix;
+	mutable glm::tmat4x4<T, P>	mMatrixInverse;
+	mutable bool			mMatrixDirty = true;
+	mutable bool			mInverseDirty = true;
+	std::uint64_t			mVersion = 0u;
+
 public:
 	friend std::ostream &operator<<(std::ostream &os, TRSTransform<T, P> &v)
 	{
@@ -129,6 +148,7 @@ public:
 		is >> v.mT;
 		is >> v.mR;
 		is >> v.mS;
+		v.Invalidate();
 		return is;
 	}
 };
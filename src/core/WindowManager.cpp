@@ -1,5 +1,7 @@
 #include "WindowManager.hpp"
 
+#include "FrameArena.hpp"
+#include "GLStateCache.hpp"
 #include "Log.h"
 #include "opengl.hpp"
 
@@ -40,6 +42,11 @@ namespace
 		if (should_close)
 			glfwSetWindowShouldClose(window, true);
 
+		if (key == GLFW_KEY_F4 && action == GLFW_RELEASE && mods == 0) {
+			GLStateCache::toggle_overlay();
+			FrameArena::toggle_overlay();
+		}
+
 		ImGui_ImplGlfw_KeyCallback(window, key, scancode, action, mods);
 	}
 
@@ -128,6 +135,7 @@ GLFWwindow* WindowManager::CreateGLFWWindow(std::string const& title, WindowDatu
 		LogError("[GLAD]: Failed to initialise OpenGL context.");
 		return nullptr;
 	}
+	GLStateCache::install();
 
 	// Setup Dear ImGui context
 	IMGUI_CHECKVERSION();
@@ -220,6 +228,8 @@ void WindowManager::DestroyWindow(GLFWwindow* const window)
 
 void WindowManager::NewImGuiFrame()
 {
+	GLStateCache::begin_frame();
+	FrameArena::begin_frame();
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
@@ -227,9 +237,14 @@ void WindowManager::NewImGuiFrame()
 
 void WindowManager::RenderImGuiFrame(bool show_gui)
 {
+	GLStateCache::render_overlay();
+	FrameArena::render_overlay();
 	ImGui::Render();
-	if (show_gui)
+	if (show_gui) {
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		// The back-end has its own loader, bypassing the cache.
+		GLStateCache::invalidate();
+	}
 }
 
 void WindowManager::ToggleFullscreenStatusForWindow(GLFWwindow* const window) noexcept
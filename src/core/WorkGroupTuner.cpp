@@ -0,0 +1,256 @@
+#include "WorkGroupTuner.hpp"
+
+#include "Log.h"
+#include "various.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	std::size_t const timed_repetitions = 5u;
+
+	std::string gl_string(GLenum name)
+	{
+		auto const value = reinterpret_cast<char const*>(glGetString(name));
+		return value != nullptr ? value : "unknown";
+	}
+
+	// Copies of the storage buffers bound to some binding points, bound
+	// in their place for as long as the object lives. Binding the copies
+	// also changes the generic GL_SHADER_STORAGE_BUFFER binding, which is
+	// therefore restored as well.
+	class ScratchStorageBuffers
+	{
+	public:
+		explicit ScratchStorageBuffers(std::vector<GLuint> const& bindings) :
+			_bindings(bindings), _originals(bindings.size(), 0u), _copies(bindings.size(), 0u), _sizes(bindings.size(), 0)
+		{
+			GLint generic_original = 0;
+			glGetIntegerv(GL_SHADER_STORAGE_BUFFER_BINDING, &generic_original);
+			_generic_original = static_cast<GLuint>(generic_original);
+
+			for (std::size_t i = 0u; i < _bindings.size(); ++i) {
+				GLint original = 0;
+				glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, _bindings[i], &original);
+				_originals[i] = static_cast<GLuint>(original);
+				if (_originals[i] == 0u)
+					continue;
+
+				glBindBuffer(GL_COPY_READ_BUFFER, _originals[i]);
+				glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &_sizes[i]);
+				glGenBuffers(1, &_copies[i]);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, _copies[i]);
+				glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(_sizes[i]), nullptr, GL_DYNAMIC_COPY);
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, _bindings[i], _copies[i]);
+			}
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+		}
+
+		~ScratchStorageBuffers()
+		{
+			for (std::size_t i = 0u; i < _bindings.size(); ++i) {
+				if (_copies[i] == 0u)
+					continue;
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, _bindings[i], _originals[i]);
+				glDeleteBuffers(1, &_copies[i]);
+			}
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, _generic_original);
+		}
+
+		ScratchStorageBuffers(ScratchStorageBuffers const&) = delete;
+		ScratchStorageBuffers& operator=(ScratchStorageBuffers const&) = delete;
+
+		//! \brief Overwrite the copies with the current content of the
+		//!        original buffers.
+		void refresh()
+		{
+			glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+			for (std::size_t i = 0u; i < _bindings.size(); ++i) {
+				if (_copies[i] == 0u || _sizes[i] == 0)
+					continue;
+				glBindBuffer(GL_COPY_READ_BUFFER, _originals[i]);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, _copies[i]);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(_sizes[i]));
+			}
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+		}
+
+	private:
+		std::vector<GLuint> _bindings;
+		std::vector<GLuint> _originals;
+		std::vector<GLuint> _copies;
+		std::vector<GLint64> _sizes;
+		GLuint _generic_original{ 0u };
+	};
+}
+
+WorkGroupTuner::WorkGroupTuner(std::string cache_path) : _cache_path(std::move(cache_path))
+{
+	load_cache();
+}
+
+WorkGroupTuner::~WorkGroupTuner()
+{
+	if (!_queries.empty())
+		glDeleteQueries(static_cast<GLsizei>(_queries.size()), _queries.data());
+}
+
+std::uint32_t
+WorkGroupTuner::select(std::string const& kernel, std::vector<std::uint32_t> const& candidates,
+                       BuildProgram const& build, DispatchWorkload const& dispatch,
+                       std::vector<GLuint> const& scratch_storage_bindings)
+{
+	if (_driver.empty())
+		_driver = gl_string(GL_VENDOR) + " | " + gl_string(GL_RENDERER) + " | " + gl_string(GL_VERSION);
+
+	auto& entry = _kernels[kernel];
+	if (entry.candidates.empty()) {
+		GLint max_size_x = 0, max_invocations = 0;
+		glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 0, &max_size_x);
+		glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &max_invocations);
+		auto const limit = static_cast<std::uint32_t>(std::min(max_size_x, max_invocations));
+		for (auto const candidate : candidates)
+			if (candidate > 0u && candidate <= limit)
+				entry.candidates.push_back(candidate);
+		if (entry.candidates.empty()) {
+			LogError("None of the work-group sizes of '%s' fits the limit of %u invocations", kernel.c_str(), limit);
+			entry.candidates.push_back(std::min(candidates.front(), limit));
+		}
+		entry.timings_ms.assign(entry.candidates.size(), -1.0);
+
+		auto const cached = _cache.find(std::make_pair(_driver, kernel));
+		if (cached != _cache.end()
+		    && std::find(entry.candidates.begin(), entry.candidates.end(), cached->second) != entry.candidates.end())
+			entry.tuned_size = cached->second;
+	}
+
+	if (entry.tuned_size == 0u || entry.retune_requested) {
+		tune(entry, build, dispatch, scratch_storage_bindings);
+		_cache[std::make_pair(_driver, kernel)] = entry.tuned_size;
+		save_cache();
+	}
+
+	if (entry.override_index > 0)
+		return entry.candidates[static_cast<std::size_t>(entry.override_index - 1)];
+	return entry.tuned_size;
+}
+
+void
+WorkGroupTuner::tune(KernelEntry& entry, BuildProgram const& build, DispatchWorkload const& dispatch,
+                     std::vector<GLuint> const& scratch_storage_bindings)
+{
+	ScratchStorageBuffers scratch_buffers(scratch_storage_bindings);
+
+	entry.retune_requested = false;
+	entry.tuned_size = entry.candidates.front();
+	double best_ms = -1.0;
+	for (std::size_t i = 0u; i < entry.candidates.size(); ++i) {
+		auto const size = entry.candidates[i];
+		auto const program = build(size);
+		if (program == 0u) {
+			entry.timings_ms[i] = -1.0;
+			continue;
+		}
+		// Every candidate starts from the same state.
+		scratch_buffers.refresh();
+		entry.timings_ms[i] = time_workload(program, size, dispatch);
+		if (best_ms < 0.0 || entry.timings_ms[i] < best_ms) {
+			best_ms = entry.timings_ms[i];
+			entry.tuned_size = size;
+		}
+	}
+}
+
+double
+WorkGroupTuner::time_workload(GLuint program, std::uint32_t work_group_size, DispatchWorkload const& dispatch)
+{
+	if (_queries.empty()) {
+		_queries.resize(timed_repetitions);
+		glGenQueries(static_cast<GLsizei>(_queries.size()), _queries.data());
+	}
+
+	// The first run pays for the lazy parts of the driver compilation.
+	dispatch(program, work_group_size);
+	glFinish();
+
+	std::vector<double> timings_ms;
+	for (auto const query : _queries) {
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		dispatch(program, work_group_size);
+		glEndQuery(GL_TIME_ELAPSED);
+	}
+	for (auto const query : _queries) {
+		GLuint64 elapsed_ns = 0u;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+		timings_ms.push_back(elapsed_ns / 1.0e6);
+	}
+	glUseProgram(0u);
+
+	std::nth_element(timings_ms.begin(), timings_ms.begin() + timings_ms.size() / 2, timings_ms.end());
+	return timings_ms[timings_ms.size() / 2];
+}
+
+void
+WorkGroupTuner::render_ui()
+{
+	for (auto& kernel : _kernels) {
+		auto& entry = kernel.second;
+		ImGui::PushID(kernel.first.c_str());
+		if (ImGui::TreeNode(kernel.first.c_str())) {
+			for (std::size_t i = 0u; i < entry.candidates.size(); ++i) {
+				if (entry.timings_ms[i] >= 0.0)
+					ImGui::Text("%4u: %.3f ms%s", entry.candidates[i], entry.timings_ms[i], entry.candidates[i] == entry.tuned_size ? " (fastest)" : "");
+				else
+					ImGui::Text("%4u: -%s", entry.candidates[i], entry.candidates[i] == entry.tuned_size ? " (cached)" : "");
+			}
+
+			std::vector<std::string> labels;
+			labels.push_back("Tuned (" + std::to_string(entry.tuned_size) + ")");
+			for (auto const candidate : entry.candidates)
+				labels.push_back(std::to_string(candidate));
+			std::vector<char const*> label_pointers;
+			for (auto const& label : labels)
+				label_pointers.push_back(label.c_str());
+			ImGui::Combo("Work-group size", &entry.override_index, label_pointers.data(), static_cast<int>(label_pointers.size()));
+			if (ImGui::Button("Tune again"))
+				entry.retune_requested = true;
+			ImGui::TreePop();
+		}
+		ImGui::PopID();
+	}
+}
+
+void
+WorkGroupTuner::load_cache()
+{
+	std::ifstream file(utils::widen(_cache_path));
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string size, kernel, driver;
+		if (!std::getline(stream, size, '\t') || !std::getline(stream, kernel, '\t') || !std::getline(stream, driver))
+			continue;
+		auto const value = std::strtoul(size.c_str(), nullptr, 10);
+		if (value > 0u)
+			_cache[std::make_pair(driver, kernel)] = static_cast<std::uint32_t>(value);
+	}
+}
+
+void
+WorkGroupTuner::save_cache() const
+{
+	std::ofstream file(utils::widen(_cache_path));
+	if (!file) {
+		LogError("Failed to write the work-group size cache '%s'", _cache_path.c_str());
+		return;
+	}
+	for (auto const& entry : _cache)
+		file << entry.second << '\t' << entry.first.second << '\t' << entry.first.first << '\n';
+}
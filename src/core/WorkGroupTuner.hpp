@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+//! \brief Pick the work-group size of compute kernels by timing them on
+//!        the current GPU.
+//!
+//! The first time a kernel is requested on a given driver, it is built
+//! with each candidate work-group size and a representative workload is
+//! timed with GL_TIME_ELAPSED queries; the fastest size is stored in a
+//! cache file, keyed by kernel name and driver (vendor, renderer and
+//! version strings), so that later runs skip the measurements. Entries of
+//! other drivers found in the cache file are preserved.
+class WorkGroupTuner
+{
+public:
+	//! \brief Return the program of the kernel built for the given
+	//!        work-group size, or 0 if it could not be built.
+	using BuildProgram = std::function<GLuint(std::uint32_t work_group_size)>;
+	//! \brief Issue the workload to time with |program|, which is not
+	//!        bound yet; the dispatches must not alter the state of the
+	//!        simulation in a visible way, see the scratch bindings of
+	//!        |select()|.
+	using DispatchWorkload = std::function<void(GLuint program, std::uint32_t work_group_size)>;
+
+	explicit WorkGroupTuner(std::string cache_path);
+	~WorkGroupTuner();
+
+	WorkGroupTuner(WorkGroupTuner const&) = delete;
+	WorkGroupTuner& operator=(WorkGroupTuner const&) = delete;
+
+	//! \brief Work-group size to use for |kernel|: the manual override if
+	//!        any, else the cached one for this driver, else the result of
+	//!        timing every candidate now.
+	//!
+	//! Candidates exceeding the limits of the driver are skipped. Has to
+	//! be called with the OpenGL context current.
+	//!
+	//! While timing, the storage buffers bound to |scratch_storage_bindings|
+	//! are replaced by copies of themselves, refreshed before each
+	//! candidate, so that |dispatch| can run the real kernel on the data
+	//! of the simulation without writing to it; the original buffers are
+	//! bound again afterwards, as is the buffer bound to the generic
+	//! `GL_SHADER_STORAGE_BUFFER` target.
+	std::uint32_t select(std::string const& kernel, std::vector<std::uint32_t> const& candidates,
+	                     BuildProgram const& build, DispatchWorkload const& dispatch,
+	                     std::vector<GLuint> const& scratch_storage_bindings = {});
+
+	//! \brief Show the tuned sizes, the last measurements, and let the
+	//!        user override the size of each kernel or tune it again.
+	void render_ui();
+
+private:
+	struct KernelEntry {
+		std::vector<std::uint32_t> candidates;
+		std::vector<double> timings_ms; //!< per candidate, negative if not measured
+		std::uint32_t tuned_size = 0u;
+		int override_index = 0; //!< 0 for the tuned size, i + 1 for candidates[i]
+		bool retune_requested = false;
+	};
+
+	void tune(KernelEntry& entry, BuildProgram const& build, DispatchWorkload const& dispatch,
+	          std::vector<GLuint> const& scratch_storage_bindings);
+	double time_workload(GLuint program, std::uint32_t work_group_size, DispatchWorkload const& dispatch);
+	void load_cache();
+	void save_cache() const;
+
+	std::string _cache_path;
+	std::string _driver;
+	std::map<std::string, KernelEntry> _kernels;
+	std::map<std::pair<std::string, std::string>, std::uint32_t> _cache; //!< (driver, kernel) -> size
+	std::vector<GLuint> _queries;
+};
@@ -16,6 +16,7 @@
 #include <cassert>
 #include <cstdint>
 #include <memory>
+#include <unordered_map>
 
 namespace
 {
@@ -142,6 +143,9 @@ bonobo::loadObjects(std::string const& filename)
 	std::vector<texture_bindings> materials_bindings(assimp_scene->mNumMaterials);
 	std::vector<material_data> material_constants(assimp_scene->mNumMaterials);
 	uint32_t texture_count = 0u;
+	// Materials often share the same image, e.g. a common normal map:
+	// load each file once and bind it everywhere it is referenced.
+	std::unordered_map<std::string, GLuint> loaded_textures;
 	for (size_t i = 0; i < assimp_scene->mNumMaterials; ++i) {
 		if (!are_materials_used[i])
 			continue;
@@ -151,7 +155,7 @@ bonobo::loadObjects(std::string const& filename)
 		material_data& constants = material_constants[i];
 		auto const material = assimp_scene->mMaterials[i];
 
-		auto const process_texture = [&bindings,&material,i,&parent_folder,&texture_count](aiTextureType type, std::string const& type_as_str, std::string const& name){
+		auto const process_texture = [&bindings,&material,i,&parent_folder,&texture_count,&loaded_textures](aiTextureType type, std::string const& type_as_str, std::string const& name){
 			if (material->GetTextureCount(type)) {
 				auto const texture_start_time = std::chrono::high_resolution_clock::now();
 
@@ -159,12 +163,22 @@ bonobo::loadObjects(std::string const& filename)
 					LogWarning("Material \"%s\" has more than one %s texture: discarding all but the first one.", material->GetName().C_Str(), type_as_str.c_str());
 				aiString path;
 				material->GetTexture(type, 0, &path);
-				auto const id = bonobo::loadTexture2D(parent_folder + std::string(path.C_Str()));
+				auto const texture_path = parent_folder + std::string(path.C_Str());
+				auto const loaded_texture = loaded_textures.find(texture_path);
+				if (loaded_texture != loaded_textures.end()) {
+					bindings.emplace(name, loaded_texture->second);
+					LogTrivia("│ %s Texture \"%s\" shared with a previous material",
+					          bindings.size() == 1 ? "┌" : "├", path.C_Str());
+					return;
+				}
+
+				auto const id = bonobo::loadTexture2D(texture_path);
 				if (id == 0u) {
 					LogWarning("Failed to load the %s texture for material \"%s\".", type_as_str.c_str(), material->GetName().C_Str());
 					return;
 				}
 				bindings.emplace(name, id);
+				loaded_textures.emplace(texture_path, id);
 				++texture_count;
 
 				utils::opengl::debug::nameObject(GL_TEXTURE, id, std::string(material->GetName().C_Str()) + " " + type_as_str);
@@ -38,6 +38,19 @@ namespace bonobo
 		float opacity{ 1.0f };
 	};
 
+	inline bool operator==(material_data const& a, material_data const& b)
+	{
+		return a.diffuse == b.diffuse && a.specular == b.specular
+		    && a.ambient == b.ambient && a.emissive == b.emissive
+		    && a.shininess == b.shininess && a.indexOfRefraction == b.indexOfRefraction
+		    && a.opacity == b.opacity;
+	}
+
+	inline bool operator!=(material_data const& a, material_data const& b)
+	{
+		return !(a == b);
+	}
+
 	//! \brief Contains the data for a mesh in OpenGL.
 	struct mesh_data {
 		GLuint vao{0u};                          //!< OpenGL name of the Vertex Array Object
@@ -1,4 +1,5 @@
 #include "node.hpp"
+#include "FrameUniforms.hpp"
 #include "helpers.hpp"
 
 #include "core/Log.h"
@@ -7,23 +8,141 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+	// Mirrors the std140 layout of the `MaterialConstants` block, where
+	// vec3 members are aligned to 16 bytes.
+	struct MaterialBlock {
+		glm::vec3 diffuse_colour;
+		float shininess_value;
+		glm::vec3 specular_colour;
+		float index_of_refraction_value;
+		glm::vec3 ambient_colour;
+		float opacity_value;
+		glm::vec3 emissive_colour;
+		float padding;
+	};
+	static_assert(sizeof(MaterialBlock) == 64u, "MaterialBlock must match the std140 layout of the MaterialConstants block.");
+
+	// Nodes are copied around freely, so the buffers are owned by this
+	// pool rather than by the nodes; nodes with equal constants share the
+	// same buffer, whose content never changes once uploaded. Each
+	// distinct set of constants costs one 64-byte buffer for the lifetime
+	// of the context.
+	GLuint acquire_material_buffer(bonobo::material_data const& constants)
+	{
+		MaterialBlock block{};
+		block.diffuse_colour = constants.diffuse;
+		block.shininess_value = constants.shininess;
+		block.specular_colour = constants.specular;
+		block.index_of_refraction_value = constants.indexOfRefraction;
+		block.ambient_colour = constants.ambient;
+		block.opacity_value = constants.opacity;
+		block.emissive_colour = constants.emissive;
+
+		static std::unordered_map<std::string, GLuint> buffers;
+		auto const key = std::string(reinterpret_cast<char const*>(&block), sizeof(block));
+		auto const it = buffers.find(key);
+		if (it != buffers.end())
+			return it->second;
+
+		GLuint buffer = 0u;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(block), &block, GL_STATIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0u);
+		buffers.emplace(key, buffer);
+		return buffer;
+	}
+}
+
+Node::BuiltinUniforms const&
+Node::builtin_uniforms()
+{
+	static BuiltinUniforms const uniforms = {
+		ShaderProgramManager::InternUniformName("vertex_model_to_world"),
+		ShaderProgramManager::InternUniformName("normal_model_to_world"),
+		ShaderProgramManager::InternUniformName("vertex_world_to_clip"),
+		ShaderProgramManager::InternUniformName("diffuse_colour"),
+		ShaderProgramManager::InternUniformName("specular_colour"),
+		ShaderProgramManager::InternUniformName("ambient_colour"),
+		ShaderProgramManager::InternUniformName("emissive_colour"),
+		ShaderProgramManager::InternUniformName("shininess_value"),
+		ShaderProgramManager::InternUniformName("index_of_refraction_value"),
+		ShaderProgramManager::InternUniformName("opacity_value"),
+		ShaderProgramManager::InternUniformName("MaterialConstants")
+	};
+	return uniforms;
+}
+
+glm::mat4 const&
+Node::world_transform(glm::mat4 const& parent_transform) const
+{
+	auto const version = _transform.GetVersion();
+	if (version != _cached_transform_version || parent_transform != _cached_parent_transform) {
+		_cached_world = parent_transform * _transform.GetMatrix();
+		_cached_parent_transform = parent_transform;
+		_cached_transform_version = version;
+	}
+	return _cached_world;
+}
+
+glm::mat4 const&
+Node::normal_transform(glm::mat4 const& world) const
+{
+	if (world != _cached_normal_source) {
+		_cached_normal = glm::transpose(glm::inverse(world));
+		_cached_normal_source = world;
+	}
+	return _cached_normal;
+}
+
 void
-Node::render(glm::mat4 const& view_projection, glm::mat4 const& parent_transform) const
+Node::set_builtin_uniforms(ShaderProgramManager::UniformLocations const& locations, glm::mat4 const& view_projection, glm::mat4 const& world) const
 {
-	if (_program != nullptr)
-		render(view_projection, parent_transform * _transform.GetMatrix(), *_program, _set_uniforms);
+	auto const& names = builtin_uniforms();
+	auto const& normal_model_to_world = normal_transform(world);
+
+	glUniformMatrix4fv(locations.Location(names.vertex_model_to_world), 1, GL_FALSE, glm::value_ptr(world));
+	glUniformMatrix4fv(locations.Location(names.normal_model_to_world), 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
+
+	// Members of the `FrameUniforms` block have no location: this only
+	// sets the matrix of programs without that block.
+	auto const world_to_clip_location = locations.Location(names.vertex_world_to_clip);
+	if (world_to_clip_location >= 0)
+		glUniformMatrix4fv(world_to_clip_location, 1, GL_FALSE, glm::value_ptr(view_projection));
+
+	set_material_uniforms(locations);
 }
+
 void
-Node::render(glm::mat4 const& view_projection, int instanceNum, std::vector<glm::vec2>& positions, std::vector<glm::vec2>& velocities, glm::mat4 const& parent_transform) const
+Node::set_material_uniforms(ShaderProgramManager::UniformLocations const& locations) const
 {
-	if (_program != nullptr)
-		render(view_projection, parent_transform * _transform.GetMatrix(), instanceNum, positions, velocities, *_program, _set_uniforms);
+	auto const& names = builtin_uniforms();
+	if (locations.BlockIndex(names.material_constants) != GL_INVALID_INDEX) {
+		if (_material_buffer == 0u)
+			_material_buffer = acquire_material_buffer(_constants);
+		glBindBufferBase(GL_UNIFORM_BUFFER, FrameUniforms::material_binding, _material_buffer);
+		return;
+	}
+
+	glUniform3fv(locations.Location(names.diffuse_colour), 1, glm::value_ptr(_constants.diffuse));
+	glUniform3fv(locations.Location(names.specular_colour), 1, glm::value_ptr(_constants.specular));
+	glUniform3fv(locations.Location(names.ambient_colour), 1, glm::value_ptr(_constants.ambient));
+	glUniform3fv(locations.Location(names.emissive_colour), 1, glm::value_ptr(_constants.emissive));
+	glUniform1f(locations.Location(names.shininess_value), _constants.shininess);
+	glUniform1f(locations.Location(names.index_of_refraction_value), _constants.indexOfRefraction);
+	glUniform1f(locations.Location(names.opacity_value), _constants.opacity);
 }
+
 void
-Node::render(glm::mat4 const& view_projection, int instanceNum, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities, glm::mat4 const& parent_transform) const
+Node::render(glm::mat4 const& view_projection, glm::mat4 const& parent_transform) const
 {
 	if (_program != nullptr)
-		render(view_projection, parent_transform * _transform.GetMatrix(), instanceNum, positions, velocities, *_program, _set_uniforms);
+		render(view_projection, world_transform(parent_transform), *_program, _set_uniforms);
 }
 void
 Node::render(glm::mat4 const& view_projection,glm::vec2 position ,glm::mat4 const& parent_transform) const
@@ -33,11 +152,19 @@ Node::render(glm::mat4 const& view_projection,glm::vec2 position ,glm::mat4 cons
 	if (_program != nullptr)
 		render(view_projection, parent_transform * resultMatrix, *_program, _set_uniforms);
 }
+
+void
+Node::render_instanced(glm::mat4 const& view_projection, InstanceBuffer const& instances, glm::mat4 const& parent_transform) const
+{
+	if (_program != nullptr)
+		render_instanced(view_projection, world_transform(parent_transform), instances, *_program, _set_uniforms);
+}
+
 void
-Node::render(glm::mat4 const& view_projection, int instanceNum, GLuint positionsBuffer, GLuint velocitiesBuffer, glm::mat4 const& parent_transform) const
+Node::render_indirect(glm::mat4 const& view_projection, GLuint indirect_buffer, GLintptr indirect_offset, glm::mat4 const& parent_transform) const
 {
 	if (_program != nullptr)
-		render(view_projection, parent_transform * _transform.GetMatrix(), instanceNum, positionsBuffer, velocitiesBuffer, *_program, _set_uniforms);
+		render_indirect(view_projection, world_transform(parent_transform), indirect_buffer, indirect_offset, *_program, _set_uniforms);
 }
 
 void
@@ -50,32 +177,19 @@ Node::render(glm::mat4 const& view_projection, glm::mat4 const& world, GLuint pr
 
 	glUseProgram(program);
 
-	auto const normal_model_to_world = glm::transpose(glm::inverse(world));
-
 	set_uniforms(program);
 
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_model_to_world"), 1, GL_FALSE, glm::value_ptr(world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "normal_model_to_world"), 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_world_to_clip"), 1, GL_FALSE, glm::value_ptr(view_projection));
+	auto const locations = ShaderProgramManager::GetUniformLocations(program);
+	set_builtin_uniforms(locations, view_projection, world);
 
 	for (size_t i = 0u; i < _textures.size(); ++i) {
 		auto const& texture = _textures[i];
 		glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
 		glBindTexture(std::get<2>(texture), std::get<1>(texture));
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), static_cast<GLint>(i));
-
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 1);
+		glUniform1i(locations.Location(_texture_uniforms[i].first), static_cast<GLint>(i));
+		glUniform1i(locations.Location(_texture_uniforms[i].second), 1);
 	}
 
-	glUniform3fv(glGetUniformLocation(program, "diffuse_colour"), 1, glm::value_ptr(_constants.diffuse));
-	glUniform3fv(glGetUniformLocation(program, "specular_colour"), 1, glm::value_ptr(_constants.specular));
-	glUniform3fv(glGetUniformLocation(program, "ambient_colour"), 1, glm::value_ptr(_constants.ambient));
-	glUniform3fv(glGetUniformLocation(program, "emissive_colour"), 1, glm::value_ptr(_constants.emissive));
-	glUniform1f(glGetUniformLocation(program, "shininess_value"), _constants.shininess);
-	glUniform1f(glGetUniformLocation(program, "index_of_refraction_value"), _constants.indexOfRefraction);
-	glUniform1f(glGetUniformLocation(program, "opacity_value"), _constants.opacity);
-
 	glBindVertexArray(_vao);
 	if (_has_indices)
 		glDrawElements(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
@@ -83,294 +197,96 @@ Node::render(glm::mat4 const& view_projection, glm::mat4 const& world, GLuint pr
 		glDrawArrays(_drawing_mode, 0, _vertices_nb);
 	glBindVertexArray(0u);
 
-	for (auto const& texture : _textures) {
-		glBindTexture(std::get<2>(texture), 0);
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), 0);
-
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 0);
-	}
-
-	glUseProgram(0u);
-
-	utils::opengl::debug::endDebugGroup();
-}
-void
-Node::render(glm::mat4 const& view_projection, glm::mat4 const& world, int instanceNum, std::vector<glm::vec2>& positions, std::vector<glm::vec2>& velocities, GLuint program, std::function<void(GLuint)> const& set_uniforms) const
-{
-	if (_vao == 0u || program == 0u)
-		return;
-
-	utils::opengl::debug::beginDebugGroup(_name);
-
-	glUseProgram(program);
-
-	auto const normal_model_to_world = glm::transpose(glm::inverse(world));
-
-	set_uniforms(program);
-
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_model_to_world"), 1, GL_FALSE, glm::value_ptr(world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "normal_model_to_world"), 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_world_to_clip"), 1, GL_FALSE, glm::value_ptr(view_projection));
-
+	// The program and textures stay bound: the next draw binds its own,
+	// and |GLStateCache| drops the calls finding them already bound.
 	for (size_t i = 0u; i < _textures.size(); ++i) {
-		auto const& texture = _textures[i];
-		glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
-		glBindTexture(std::get<2>(texture), std::get<1>(texture));
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), static_cast<GLint>(i));
-
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 1);
+		glUniform1i(locations.Location(_texture_uniforms[i].first), 0);
+		glUniform1i(locations.Location(_texture_uniforms[i].second), 0);
 	}
 
-	glUniform3fv(glGetUniformLocation(program, "diffuse_colour"), 1, glm::value_ptr(_constants.diffuse));
-	glUniform3fv(glGetUniformLocation(program, "specular_colour"), 1, glm::value_ptr(_constants.specular));
-	glUniform3fv(glGetUniformLocation(program, "ambient_colour"), 1, glm::value_ptr(_constants.ambient));
-	glUniform3fv(glGetUniformLocation(program, "emissive_colour"), 1, glm::value_ptr(_constants.emissive));
-	glUniform1f(glGetUniformLocation(program, "shininess_value"), _constants.shininess);
-	glUniform1f(glGetUniformLocation(program, "index_of_refraction_value"), _constants.indexOfRefraction);
-	glUniform1f(glGetUniformLocation(program, "opacity_value"), _constants.opacity);
-
-	glBindBuffer(GL_ARRAY_BUFFER, _vao);
-	//buffer map
-	GLfloat* mappedBufferPosition = static_cast<GLfloat*>(glMapBufferRange(GL_ARRAY_BUFFER, _vertices_nb * sizeof(glm::vec3), 2 * positions.size() * sizeof(glm::vec2), GL_MAP_WRITE_BIT));
-	auto velovityOffset = 2 * positions.size();
-	if (mappedBufferPosition) {
-		// updata
-		for (int i = 0; i < positions.size(); i++) {
-			mappedBufferPosition[2 * i] = positions[i].x;
-			mappedBufferPosition[2 * i + 1] = positions[i].y;
-			mappedBufferPosition[velovityOffset + 2 * i] = velocities[i].x;
-			mappedBufferPosition[velovityOffset + 2 * i + 1] = velocities[i].y;
-		}
-		// cancel mapping
-		glUnmapBuffer(GL_ARRAY_BUFFER);
-	}
-	//std::cout << _vertices_nb << std::endl;
-	//std::cout << instanceNum << std::endl;
-	glBindVertexArray(_vao);
-	if (_has_indices) {
-		if (instanceNum == 1) {
-			glDrawElements(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
-		}
-		else {
-			glDrawElementsInstanced(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0), instanceNum);
-			//std::cout << "instance render" << std::endl;
-		}
-	}
-	else {
-		if (instanceNum == 1) {
-			glDrawArrays(_drawing_mode, 0, _vertices_nb);
-		}
-		else {
-			glDrawArraysInstanced(_drawing_mode, 0, _vertices_nb, instanceNum);
-		}
-	}
-	glBindVertexArray(0u);
-
-	//glBindVertexArray(_vao);
-	//if (_has_indices)
-	//	glDrawElements(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
-	//else
-	//	glDrawArrays(_drawing_mode, 0, _vertices_nb);
-	//glBindVertexArray(0u);
-
-	for (auto const& texture : _textures) {
-		glBindTexture(std::get<2>(texture), 0);
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), 0);
-
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 0);
-	}
-
-	glUseProgram(0u);
-
 	utils::opengl::debug::endDebugGroup();
 }
+
 void
-Node::render(glm::mat4 const& view_projection, glm::mat4 const& world, int instanceNum, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities, GLuint program, std::function<void(GLuint)> const& set_uniforms) const
+Node::render_instanced(glm::mat4 const& view_projection, glm::mat4 const& world, InstanceBuffer const& instances, GLuint program, std::function<void(GLuint)> const& set_uniforms) const
 {
-	if (_vao == 0u || program == 0u)
+	auto const instance_count = instances.get_count();
+	if (_vao == 0u || program == 0u || instance_count == 0)
 		return;
 
 	utils::opengl::debug::beginDebugGroup(_name);
 
 	glUseProgram(program);
 
-	auto const normal_model_to_world = glm::transpose(glm::inverse(world));
-
 	set_uniforms(program);
 
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_model_to_world"), 1, GL_FALSE, glm::value_ptr(world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "normal_model_to_world"), 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_world_to_clip"), 1, GL_FALSE, glm::value_ptr(view_projection));
+	auto const locations = ShaderProgramManager::GetUniformLocations(program);
+	set_builtin_uniforms(locations, view_projection, world);
 
 	for (size_t i = 0u; i < _textures.size(); ++i) {
 		auto const& texture = _textures[i];
 		glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
 		glBindTexture(std::get<2>(texture), std::get<1>(texture));
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), static_cast<GLint>(i));
-
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 1);
+		glUniform1i(locations.Location(_texture_uniforms[i].first), static_cast<GLint>(i));
+		glUniform1i(locations.Location(_texture_uniforms[i].second), 1);
 	}
 
-	glUniform3fv(glGetUniformLocation(program, "diffuse_colour"), 1, glm::value_ptr(_constants.diffuse));
-	glUniform3fv(glGetUniformLocation(program, "specular_colour"), 1, glm::value_ptr(_constants.specular));
-	glUniform3fv(glGetUniformLocation(program, "ambient_colour"), 1, glm::value_ptr(_constants.ambient));
-	glUniform3fv(glGetUniformLocation(program, "emissive_colour"), 1, glm::value_ptr(_constants.emissive));
-	glUniform1f(glGetUniformLocation(program, "shininess_value"), _constants.shininess);
-	glUniform1f(glGetUniformLocation(program, "index_of_refraction_value"), _constants.indexOfRefraction);
-	glUniform1f(glGetUniformLocation(program, "opacity_value"), _constants.opacity);
-
-	glBindBuffer(GL_ARRAY_BUFFER, _vao);
-	//buffer map
-	GLfloat* mappedBufferPosition = static_cast<GLfloat*>(glMapBufferRange(GL_ARRAY_BUFFER, _vertices_nb * sizeof(glm::vec3), 2 * positions.size() * sizeof(glm::vec3), GL_MAP_WRITE_BIT));
-	auto velovityOffset = 3 * positions.size();
-	if (mappedBufferPosition) {
-		// updata
-		for (int i = 0; i < positions.size(); i++) {
-			mappedBufferPosition[3 * i] = positions[i].x;
-			mappedBufferPosition[3 * i + 1] = positions[i].y;
-			mappedBufferPosition[3 * i + 2] = positions[i].z;
-			mappedBufferPosition[velovityOffset + 3 * i] = velocities[i].x;
-			mappedBufferPosition[velovityOffset + 3 * i + 1] = velocities[i].y;
-			mappedBufferPosition[velovityOffset + 3 * i + 2] = velocities[i].z;
-		}
-		// cancel mapping
-		glUnmapBuffer(GL_ARRAY_BUFFER);
-	}
-	//std::cout << _vertices_nb << std::endl;
-	//std::cout << instanceNum << std::endl;
 	glBindVertexArray(_vao);
-	if (_has_indices) {
-		if (instanceNum == 1) {
-			glDrawElements(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
-		}
-		else {
-			glDrawElementsInstanced(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0), instanceNum);
-			//std::cout << "2instance render" << std::endl;
-		}
-	}
-	else {
-		if (instanceNum == 1) {
-			glDrawArrays(_drawing_mode, 0, _vertices_nb);
-		}
-		else {
-			glDrawArraysInstanced(_drawing_mode, 0, _vertices_nb, instanceNum);
-		}
-	}
+	if (_has_indices)
+		glDrawElementsInstanced(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0), instance_count);
+	else
+		glDrawArraysInstanced(_drawing_mode, 0, _vertices_nb, instance_count);
 	glBindVertexArray(0u);
 
-	//glBindVertexArray(_vao);
-	//if (_has_indices)
-	//	glDrawElements(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
-	//else
-	//	glDrawArrays(_drawing_mode, 0, _vertices_nb);
-	//glBindVertexArray(0u);
-
-	for (auto const& texture : _textures) {
-		glBindTexture(std::get<2>(texture), 0);
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), 0);
-
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 0);
+	// The program and textures stay bound: the next draw binds its own,
+	// and |GLStateCache| drops the calls finding them already bound.
+	for (size_t i = 0u; i < _textures.size(); ++i) {
+		glUniform1i(locations.Location(_texture_uniforms[i].first), 0);
+		glUniform1i(locations.Location(_texture_uniforms[i].second), 0);
 	}
 
-	glUseProgram(0u);
-
 	utils::opengl::debug::endDebugGroup();
 }
+
 void
-Node::render(glm::mat4 const& view_projection, glm::mat4 const& world, int instanceNum, GLuint positions, GLuint velocities, GLuint program, std::function<void(GLuint)> const& set_uniforms) const
+Node::render_indirect(glm::mat4 const& view_projection, glm::mat4 const& world, GLuint indirect_buffer, GLintptr indirect_offset, GLuint program, std::function<void(GLuint)> const& set_uniforms) const
 {
-	if (_vao == 0u || program == 0u)
+	if (_vao == 0u || program == 0u || indirect_buffer == 0u)
 		return;
 
 	utils::opengl::debug::beginDebugGroup(_name);
 
 	glUseProgram(program);
 
-	auto const normal_model_to_world = glm::transpose(glm::inverse(world));
-
 	set_uniforms(program);
 
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_model_to_world"), 1, GL_FALSE, glm::value_ptr(world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "normal_model_to_world"), 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_world_to_clip"), 1, GL_FALSE, glm::value_ptr(view_projection));
+	auto const locations = ShaderProgramManager::GetUniformLocations(program);
+	set_builtin_uniforms(locations, view_projection, world);
 
 	for (size_t i = 0u; i < _textures.size(); ++i) {
 		auto const& texture = _textures[i];
 		glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
 		glBindTexture(std::get<2>(texture), std::get<1>(texture));
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), static_cast<GLint>(i));
-
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 1);
+		glUniform1i(locations.Location(_texture_uniforms[i].first), static_cast<GLint>(i));
+		glUniform1i(locations.Location(_texture_uniforms[i].second), 1);
 	}
 
-	glUniform3fv(glGetUniformLocation(program, "diffuse_colour"), 1, glm::value_ptr(_constants.diffuse));
-	glUniform3fv(glGetUniformLocation(program, "specular_colour"), 1, glm::value_ptr(_constants.specular));
-	glUniform3fv(glGetUniformLocation(program, "ambient_colour"), 1, glm::value_ptr(_constants.ambient));
-	glUniform3fv(glGetUniformLocation(program, "emissive_colour"), 1, glm::value_ptr(_constants.emissive));
-	glUniform1f(glGetUniformLocation(program, "shininess_value"), _constants.shininess);
-	glUniform1f(glGetUniformLocation(program, "index_of_refraction_value"), _constants.indexOfRefraction);
-	glUniform1f(glGetUniformLocation(program, "opacity_value"), _constants.opacity);
-
-	glBindBuffer(GL_ARRAY_BUFFER, _vao);
-	//buffer map
-	//GLfloat* mappedBufferPosition = static_cast<GLfloat*>(glMapBufferRange(GL_ARRAY_BUFFER, _vertices_nb * sizeof(glm::vec3), 2 * positions.size() * sizeof(glm::vec2), GL_MAP_WRITE_BIT));
-	//auto velovityOffset = 2 * positions.size();
-	//if (mappedBufferPosition) {
-	//	// updata
-	//	for (int i = 0; i < positions.size(); i++) {
-	//		mappedBufferPosition[2 * i] = positions[i].x;
-	//		mappedBufferPosition[2 * i + 1] = positions[i].y;
-	//		mappedBufferPosition[velovityOffset + 2 * i] = velocities[i].x;
-	//		mappedBufferPosition[velovityOffset + 2 * i + 1] = velocities[i].y;
-	//	}
-	//	// cancel mapping
-	//	glUnmapBuffer(GL_ARRAY_BUFFER);
-	//}
-	//std::cout << _vertices_nb << std::endl;
-	//std::cout << instanceNum << std::endl;
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
 	glBindVertexArray(_vao);
-	if (_has_indices) {
-		if (instanceNum == 1) {
-			glDrawElements(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
-		}
-		else {
-			glDrawElementsInstanced(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0), instanceNum);
-			//std::cout << "instance render" << std::endl;
-		}
-	}
-	else {
-		if (instanceNum == 1) {
-			glDrawArrays(_drawing_mode, 0, _vertices_nb);
-		}
-		else {
-			glDrawArraysInstanced(_drawing_mode, 0, _vertices_nb, instanceNum);
-		}
-	}
+	if (_has_indices)
+		glDrawElementsIndirect(_drawing_mode, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(indirect_offset));
+	else
+		glDrawArraysIndirect(_drawing_mode, reinterpret_cast<GLvoid const*>(indirect_offset));
 	glBindVertexArray(0u);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0u);
 
-	//glBindVertexArray(_vao);
-	//if (_has_indices)
-	//	glDrawElements(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
-	//else
-	//	glDrawArrays(_drawing_mode, 0, _vertices_nb);
-	//glBindVertexArray(0u);
-
-	for (auto const& texture : _textures) {
-		glBindTexture(std::get<2>(texture), 0);
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), 0);
-
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 0);
+	// The program and textures stay bound: the next draw binds its own,
+	// and |GLStateCache| drops the calls finding them already bound.
+	for (size_t i = 0u; i < _textures.size(); ++i) {
+		glUniform1i(locations.Location(_texture_uniforms[i].first), 0);
+		glUniform1i(locations.Location(_texture_uniforms[i].second), 0);
 	}
 
-	glUseProgram(0u);
-
 	utils::opengl::debug::endDebugGroup();
 }
 
@@ -391,12 +307,17 @@ Node::set_geometry(bonobo::mesh_data const& shape)
 	}
 
 	_constants = shape.material;
+	_material_buffer = 0u;
 }
 
 void
 Node::set_material_constants(bonobo::material_data const& constants)
 {
+	if (constants == _constants)
+		return;
+
 	_constants = constants;
+	_material_buffer = 0u;
 }
 
 void
@@ -450,6 +371,8 @@ Node::add_texture(std::string const& name, GLuint tex_id, GLenum type)
 	}
 
 	_textures.emplace_back(name, tex_id, type);
+	_texture_uniforms.emplace_back(ShaderProgramManager::InternUniformName(name),
+	                               ShaderProgramManager::InternUniformName("has_" + name));
 }
 
 void
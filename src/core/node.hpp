@@ -1,15 +1,19 @@
 #pragma once
 
 #include "helpers.hpp"
+#include "InstanceBuffer.hpp"
+#include "ShaderProgramManager.hpp"
 #include "TRSTransform.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 //! \brief Represents a node of a scene graph
@@ -18,6 +22,13 @@ class Node
 public:
 	//! \brief Render this node.
 	//!
+	//! Programs declaring the `FrameUniforms` block read the world-to-clip
+	//! matrix from it, see |FrameUniforms|, rather than from
+	//! |view_projection|; likewise, programs declaring the
+	//! `MaterialConstants` block get the material constants through a
+	//! uniform buffer shared by all nodes with equal constants, and the
+	//! other ones through individual uniforms.
+	//!
 	//! @param [in] view_projection Matrix transforming from world-space to clip-space
 	//! @param [in] parent_transform Matrix transforming from parent-space to
 	//!             world-space
@@ -25,12 +36,6 @@ public:
 		glm::mat4 const& parent_transform = glm::mat4(1.0f)) const;
 	void render(glm::mat4 const& view_projection,glm::vec2 position,
 		glm::mat4 const& parent_transform = glm::mat4(1.0f)) const;
-	void render(glm::mat4 const& view_projection, int instanceNum, std::vector<glm::vec2>& positions, std::vector<glm::vec2>& velocities,
-		glm::mat4 const& parent_transform = glm::mat4(1.0f)) const;
-	void render(glm::mat4 const& view_projection, int instanceNum, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities,
-		glm::mat4 const& parent_transform = glm::mat4(1.0f)) const;
-	void render(glm::mat4 const& view_projection, int instanceNum, GLuint positionsBuffer, GLuint velocitiesBuffer,
-		glm::mat4 const& parent_transform) const;
 
 	//! \brief Render this node with a specific shader program.
 	//!
@@ -48,17 +53,61 @@ public:
 	void render(glm::mat4 const& view_projection, glm::mat4 const& world,
 	            GLuint program,
 	            std::function<void (GLuint)> const& set_uniforms = [](GLuint /*programID*/){}) const;
-	void render(glm::mat4 const& view_projection, glm::mat4 const& world,
-		int instanceNum, std::vector<glm::vec2>& positions, std::vector<glm::vec2>& velocities,
-		GLuint program,
-		std::function<void(GLuint)> const& set_uniforms = [](GLuint /*programID*/) {}) const;
-	void render(glm::mat4 const& view_projection, glm::mat4 const& world,
-		int instanceNum, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities,
-		GLuint program,
-		std::function<void(GLuint)> const& set_uniforms = [](GLuint /*programID*/) {}) const;
-	void render(glm::mat4 const& view_projection, glm::mat4 const& world,
-		int instanceNum, GLuint positions, GLuint velocities,
-		GLuint program, std::function<void(GLuint)> const& set_uniforms) const;
+
+	//! \brief Render this node with draw parameters sourced from a GPU
+	//!        buffer.
+	//!
+	//! The draw parameters are read from |indirect_buffer| at
+	//! |indirect_offset|, and should be laid out as a
+	//! `DrawElementsIndirectCommand` if the geometry of this node is
+	//! indexed, and as a `DrawArraysIndirectCommand` otherwise. This
+	//! lets a compute pass decide how many instances get drawn without
+	//! any CPU round-trip.
+	//!
+	//! @param [in] view_projection Matrix transforming from world-space to clip-space
+	//! @param [in] indirect_buffer OpenGL buffer holding the draw command
+	//! @param [in] indirect_offset offset in bytes of the draw command
+	//!             within |indirect_buffer|
+	//! @param [in] parent_transform Matrix transforming from parent-space to
+	//!             world-space
+	void render_indirect(glm::mat4 const& view_projection,
+	                     GLuint indirect_buffer, GLintptr indirect_offset,
+	                     glm::mat4 const& parent_transform = glm::mat4(1.0f)) const;
+
+	//! \brief Render this node with a specific shader program and draw
+	//!        parameters sourced from a GPU buffer.
+	//!
+	//! See the other overload of |render_indirect()| for the expected
+	//! content of |indirect_buffer|.
+	void render_indirect(glm::mat4 const& view_projection, glm::mat4 const& world,
+	                     GLuint indirect_buffer, GLintptr indirect_offset,
+	                     GLuint program,
+	                     std::function<void (GLuint)> const& set_uniforms = [](GLuint /*programID*/){}) const;
+	//! \brief Render one instance of this node per instance of
+	//!        |instances|.
+	//!
+	//! |instances| should have been attached to the geometry of this node
+	//! beforehand, see |InstanceBuffer::attach()|; its streams then feed
+	//! the per-instance attributes of the program, while the transforms
+	//! and material are shared by all instances.
+	//!
+	//! @param [in] view_projection Matrix transforming from world-space to clip-space
+	//! @param [in] instances per-instance data to draw
+	//! @param [in] parent_transform Matrix transforming from parent-space to
+	//!             world-space
+	void render_instanced(glm::mat4 const& view_projection,
+	                      InstanceBuffer const& instances,
+	                      glm::mat4 const& parent_transform = glm::mat4(1.0f)) const;
+
+	//! \brief Render one instance of this node per instance of
+	//!        |instances|, with a specific shader program.
+	//!
+	//! See the other overload of |render_instanced()|; as with
+	//! |render()|, the internal transform of this node is not used.
+	void render_instanced(glm::mat4 const& view_projection, glm::mat4 const& world,
+	                      InstanceBuffer const& instances,
+	                      GLuint program,
+	                      std::function<void (GLuint)> const& set_uniforms = [](GLuint /*programID*/){}) const;
 	//! \brief Set the geometry of this node.
 	//!
 	//! It will overwrite any constants provided by an earlier call to
@@ -149,6 +198,42 @@ public:
 	TRSTransformf& get_transform();
 
 private:
+	friend class RenderQueue;
+
+	//! \brief Interned names of the uniforms set for every node.
+	struct BuiltinUniforms {
+		ShaderProgramManager::UniformName vertex_model_to_world;
+		ShaderProgramManager::UniformName normal_model_to_world;
+		ShaderProgramManager::UniformName vertex_world_to_clip;
+		ShaderProgramManager::UniformName diffuse_colour;
+		ShaderProgramManager::UniformName specular_colour;
+		ShaderProgramManager::UniformName ambient_colour;
+		ShaderProgramManager::UniformName emissive_colour;
+		ShaderProgramManager::UniformName shininess_value;
+		ShaderProgramManager::UniformName index_of_refraction_value;
+		ShaderProgramManager::UniformName opacity_value;
+		ShaderProgramManager::UniformName material_constants;
+	};
+	static BuiltinUniforms const& builtin_uniforms();
+
+	//! \brief World matrix of this node placed below |parent_transform|,
+	//!        only computed again when that matrix or |_transform|
+	//!        changed since the previous call.
+	glm::mat4 const& world_transform(glm::mat4 const& parent_transform) const;
+	//! \brief Matrix transforming normals by |world|, i.e. its inverse
+	//!        transpose, only computed again when |world| differs from
+	//!        the previous call's.
+	glm::mat4 const& normal_transform(glm::mat4 const& world) const;
+
+	//! \brief Set the transforms of |program|, whose locations are
+	//!        |locations|, followed by its material constants.
+	void set_builtin_uniforms(ShaderProgramManager::UniformLocations const& locations,
+	                          glm::mat4 const& view_projection, glm::mat4 const& world) const;
+	//! \brief Make the material constants available to the program whose
+	//!        locations are |locations|, through the `MaterialConstants`
+	//!        block if it has one.
+	void set_material_uniforms(ShaderProgramManager::UniformLocations const& locations) const;
+
 	// Geometry data
 	GLuint _vao{ 0u };
 	GLsizei _vertices_nb{ 0u };
@@ -162,10 +247,20 @@ private:
 
 	// Material data
 	std::vector<std::tuple<std::string, GLuint, GLenum>> _textures;
+	//! interned names of the sampler and `has_` uniforms of each texture
+	std::vector<std::pair<ShaderProgramManager::UniformName, ShaderProgramManager::UniformName>> _texture_uniforms;
 	bonobo::material_data _constants;
+	//! uniform buffer holding |_constants|, looked up on the first render
+	//! after they change; owned by a pool shared by all nodes
+	mutable GLuint _material_buffer{ 0u };
 
 	// Transformation data
 	TRSTransformf _transform;
+	mutable glm::mat4 _cached_parent_transform{ 1.0f };
+	mutable std::uint64_t _cached_transform_version{ 0u };
+	mutable glm::mat4 _cached_world{ 1.0f };
+	mutable glm::mat4 _cached_normal_source{ 1.0f };
+	mutable glm::mat4 _cached_normal{ 1.0f };
 
 	// Children data
 	std::vector<Node const*> _children;
@@ -2,6 +2,7 @@
 #include "opengl.hpp"
 #include "various.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -102,6 +103,15 @@ beginDebugGroup(std::string const& message, GLuint id)
 	glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, id, static_cast<GLsizei>(message.size()), message.data());
 }
 
+void
+beginDebugGroup(char const* message, GLuint id)
+{
+	if (!isSupported())
+		return;
+
+	glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, id, -1, message);
+}
+
 void
 endDebugGroup()
 {
@@ -201,6 +211,32 @@ source_and_build_shader(GLuint id, std::string const& source)
 	return wasCompilationSuccessful;
 }
 
+std::string
+insert_defines(std::string const& source, Defines const& defines)
+{
+	if (defines.empty())
+		return source;
+
+	std::size_t insertion_point = 0u;
+	std::size_t next_line = 1u;
+	auto const version = source.find("#version");
+	if (version != std::string::npos) {
+		auto const version_end = source.find('\n', version);
+		insertion_point = version_end == std::string::npos ? source.size() : version_end + 1u;
+		next_line = static_cast<std::size_t>(std::count(source.begin(), source.begin() + insertion_point, '\n')) + 1u;
+	}
+
+	std::ostringstream oss;
+	oss << source.substr(0u, insertion_point);
+	if (insertion_point == source.size() && (source.empty() || source.back() != '\n'))
+		oss << '\n';
+	for (auto const& define : defines)
+		oss << "#define " << define.first << " " << define.second << '\n';
+	oss << "#line " << next_line << '\n'
+	    << source.substr(insertion_point);
+	return oss.str();
+}
+
 GLuint
 generate_shader(GLenum type, std::string const& source)
 {
@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -34,6 +35,12 @@ std::string getStringForSeverity(GLenum severity);
 //!             filtering some messages out but is currently unused
 void beginDebugGroup(std::string const& message, GLuint id = 0u);
 
+//! \brief Start a new debug group, named by the null-terminated |message|.
+//!
+//! Unlike the std::string overload, passing a string literal or a string
+//! formatted in the frame arena does not allocate.
+void beginDebugGroup(char const* message, GLuint id = 0u);
+
 //! \brief End the most recently-started debug group.
 //!
 //! The call will be ignored if OpenGL debug facilities are not available.
@@ -66,6 +73,13 @@ opengl_error_callback( GLenum source, GLenum type, GLuint id
 namespace shader
 {
 
+using Defines = std::vector<std::pair<std::string, std::string>>;
+
+//! \brief Insert a `#define name value` line per entry of |defines| right
+//!        after the `#version` line of |source|, followed by a `#line`
+//!        directive so that compilation logs keep the original line
+//!        numbers.
+std::string insert_defines(std::string const& source, Defines const& defines);
 bool source_and_build_shader(GLuint id, std::string const& source);
 GLuint generate_shader(GLenum type, std::string const& source);
 bool link_program(GLuint id);